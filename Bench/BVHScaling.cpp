@@ -0,0 +1,108 @@
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <memory>
+
+#include <Math/BVH.hpp>
+#include <Math/Hittable.hpp>
+#include <Math/BoundingSphere.hpp>
+
+// Traces a fixed grid of primary rays into scenes of growing sphere counts and
+// reports the per-ray cost of the BVH next to the linear hittable_list_hit scan.
+
+static constexpr size_t RAY_GRID_SIZE = 256;
+static constexpr size_t LINEAR_SCAN_LIMIT = 10000;
+
+static void
+_build_scene(HittableList& world, size_t sphere_count)
+{
+	std::mt19937 rng(1337);
+
+	// Keep the density constant so that every scene covers the view similarly.
+	float extent = 100.0f * std::cbrt(float(sphere_count) / 1000.0f);
+	float radius = 2.0f;
+
+	std::uniform_real_distribution<float> position(-extent, extent);
+
+	hittable_list_clear(world);
+	for (size_t i = 0; i < sphere_count; i++)
+	{
+		auto sphere = std::make_shared<BoundingSphere>();
+		bound_sphere_create(*sphere, radius, { position(rng), position(rng), position(rng) - 2.0f * extent });
+
+		hittable_list_add(world, sphere);
+	}
+}
+
+template<typename InTraceFn>
+static double
+_trace_grid(size_t& hit_count, InTraceFn trace_fn)
+{
+	hit_count = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t y = 0; y < RAY_GRID_SIZE; y++)
+	{
+		for (size_t x = 0; x < RAY_GRID_SIZE; x++)
+		{
+			Vec3f direction = {
+				(float(x) / RAY_GRID_SIZE) - 0.5f,
+				(float(y) / RAY_GRID_SIZE) - 0.5f,
+				-1.0f
+			};
+
+			Ray ray { { 0.0f, 0.0f, 0.0f }, vector_normalize(direction) };
+
+			if (trace_fn(ray).hit)
+				hit_count++;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	double ray_count = double(RAY_GRID_SIZE * RAY_GRID_SIZE);
+	return std::chrono::duration<double, std::nano>(end - start).count() / ray_count;
+}
+
+int main(int argc, char* argv[])
+{
+	printf("%10s %12s %10s %14s %14s %10s\n",
+		"spheres", "build (ms)", "nodes", "bvh (ns/ray)", "list (ns/ray)", "hits");
+
+	for (size_t sphere_count = 10; sphere_count <= 1000000; sphere_count *= 10)
+	{
+		HittableList world;
+		_build_scene(world, sphere_count);
+
+		BVH bvh;
+
+		auto build_start = std::chrono::steady_clock::now();
+		bvh_build(bvh, world);
+		auto build_end = std::chrono::steady_clock::now();
+
+		double build_ms = std::chrono::duration<double, std::milli>(build_end - build_start).count();
+
+		size_t bvh_hits;
+		double bvh_ns = _trace_grid(bvh_hits, [&](const Ray& ray) {
+			return bvh_hit(bvh, world, ray, 0.001f, constants_infinity<float>());
+		});
+
+		if (sphere_count <= LINEAR_SCAN_LIMIT)
+		{
+			size_t list_hits;
+			double list_ns = _trace_grid(list_hits, [&](const Ray& ray) {
+				return hittable_list_hit(world, ray, 0.001f, constants_infinity<float>());
+			});
+
+			printf("%10zu %12.2f %10zu %14.1f %14.1f %10zu%s\n",
+				sphere_count, build_ms, bvh.nodes.size(), bvh_ns, list_ns, bvh_hits,
+				bvh_hits == list_hits ? "" : " (MISMATCH)");
+		}
+		else
+		{
+			printf("%10zu %12.2f %10zu %14.1f %14s %10zu\n",
+				sphere_count, build_ms, bvh.nodes.size(), bvh_ns, "-", bvh_hits);
+		}
+	}
+
+	return 0;
+}
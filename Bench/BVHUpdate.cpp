@@ -0,0 +1,142 @@
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <memory>
+
+#include <Math/Geometry.hpp>
+#include <Math/BoundingSphere.hpp>
+
+// Moves spheres of one scene in three ways and times geometry_scene_update
+// against a full geometry_scene_build: a small jitter of every sphere (refit),
+// shuffling the spheres inside one octant of the scene (partial rebuild) and
+// shuffling the whole scene (full rebuild). After every update the scene must
+// give the same hits as a freshly built one, at comparable traversal cost.
+
+static constexpr size_t SPHERE_COUNT = 100000;
+static constexpr size_t RAY_GRID_SIZE = 256;
+
+static const char* UPDATE_NAMES[] = { "none", "refit", "partial", "full" };
+
+struct _Trace
+{
+	std::vector<float> t;
+	double nodes_per_ray;
+};
+
+static _Trace
+_trace(const GeometryScene& scene)
+{
+	_Trace trace;
+	trace.t.reserve(RAY_GRID_SIZE * RAY_GRID_SIZE);
+
+	TraversalStats stats {};
+	for (size_t y = 0; y < RAY_GRID_SIZE; y++)
+	{
+		for (size_t x = 0; x < RAY_GRID_SIZE; x++)
+		{
+			Vec3f direction = { (float(x) / RAY_GRID_SIZE) - 0.5f, (float(y) / RAY_GRID_SIZE) - 0.5f, -1.0f };
+			Ray ray { { 0.0f, 0.0f, 0.0f }, vector_normalize(direction) };
+
+			GeometryHit hit = geometry_scene_intersect(scene, ray, 0.001f, constants_infinity<float>(), &stats);
+			trace.t.push_back(hit.hit ? hit.t : -1.0f);
+		}
+	}
+
+	trace.nodes_per_ray = double(stats.nodes_visited) / double(stats.rays);
+	return trace;
+}
+
+int main(int argc, char* argv[])
+{
+	std::mt19937 rng(1337);
+
+	float extent = 100.0f * std::cbrt(float(SPHERE_COUNT) / 1000.0f);
+	std::uniform_real_distribution<float> position(-extent, extent);
+	std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+
+	HittableList world;
+	std::vector<BoundingSphere*> spheres;
+	for (size_t i = 0; i < SPHERE_COUNT; i++)
+	{
+		auto sphere = std::make_shared<BoundingSphere>();
+		bound_sphere_create(*sphere, 2.0f, { position(rng), position(rng), position(rng) - 2.0f * extent });
+
+		spheres.push_back(sphere.get());
+		hittable_list_add(world, sphere);
+	}
+
+	GeometryScene scene;
+	geometry_scene_create(scene);
+	geometry_scene_set_acceleration(scene, AccelerationType::AT_BVH8);
+
+	auto build_start = std::chrono::steady_clock::now();
+	geometry_scene_build(scene, world);
+	auto build_end = std::chrono::steady_clock::now();
+
+	printf("%zu spheres, full build %.2f ms\n", SPHERE_COUNT,
+		std::chrono::duration<double, std::milli>(build_end - build_start).count());
+	printf("%-16s %8s %10s %10s %10s %10s %10s %12s %12s\n", "edit", "update", "primitives", "refit ms", "rebuild ms",
+		"sah ratio", "mismatch", "nodes/ray", "fresh n/ray");
+
+	auto shuffle = [&](auto selected) {
+		std::vector<BoundingSphere*> moved;
+		std::vector<Vec3f> centers;
+		for (BoundingSphere* sphere : spheres)
+		{
+			if (selected(sphere->center))
+			{
+				moved.push_back(sphere);
+				centers.push_back(sphere->center);
+			}
+		}
+
+		std::shuffle(centers.begin(), centers.end(), rng);
+		for (size_t i = 0; i < moved.size(); i++)
+			moved[i]->center = centers[i];
+	};
+
+	const char* edit_names[] = { "jitter all", "shuffle octant", "shuffle all" };
+	for (int edit = 0; edit < 3; edit++)
+	{
+		switch (edit)
+		{
+			case 0:
+				for (BoundingSphere* sphere : spheres)
+					sphere->center = sphere->center + Vec3f{ jitter(rng), jitter(rng), jitter(rng) };
+				break;
+			case 1:
+				shuffle([extent](const Vec3f& center) {
+					return center.x > 0.0f && center.y > 0.0f && center.z > -extent * 2.0f;
+				});
+				break;
+			default:
+				shuffle([](const Vec3f&) { return true; });
+				break;
+		}
+
+		BVHUpdateStats stats = geometry_scene_update(scene, world);
+		_Trace updated = _trace(scene);
+
+		GeometryScene fresh;
+		geometry_scene_create(fresh);
+		geometry_scene_set_acceleration(fresh, AccelerationType::AT_BVH8);
+		geometry_scene_build(fresh, world);
+
+		_Trace reference = _trace(fresh);
+		geometry_scene_destroy(fresh);
+
+		size_t mismatch_count = 0;
+		for (size_t i = 0; i < reference.t.size(); i++)
+			mismatch_count += updated.t[i] != reference.t[i];
+
+		printf("%-16s %8s %10u %10.2f %10.2f %10.3f %10zu %12.1f %12.1f\n", edit_names[edit],
+			UPDATE_NAMES[int(stats.type)], stats.rebuilt_primitives, stats.refit_ms, stats.rebuild_ms,
+			stats.refit_cost_ratio, mismatch_count, updated.nodes_per_ray, reference.nodes_per_ray);
+	}
+
+	geometry_scene_destroy(scene);
+
+	return 0;
+}
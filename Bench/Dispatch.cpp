@@ -0,0 +1,91 @@
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <memory>
+
+#include <Math/BVH.hpp>
+#include <Math/Geometry.hpp>
+#include <Math/Hittable.hpp>
+#include <Math/BoundingSphere.hpp>
+
+// Per-ray cost of the Hittable::hit function-pointer path (one call and one
+// full HitRecord per candidate) against the type-batched GeometryScene path,
+// both traversing an identical BVH.
+
+static constexpr size_t RAY_GRID_SIZE = 512;
+
+template<typename InTraceFn>
+static double
+_trace_grid(size_t& hit_count, InTraceFn trace_fn)
+{
+	hit_count = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t y = 0; y < RAY_GRID_SIZE; y++)
+	{
+		for (size_t x = 0; x < RAY_GRID_SIZE; x++)
+		{
+			Vec3f direction = {
+				(float(x) / RAY_GRID_SIZE) - 0.5f,
+				(float(y) / RAY_GRID_SIZE) - 0.5f,
+				-1.0f
+			};
+
+			Ray ray { { 0.0f, 0.0f, 0.0f }, vector_normalize(direction) };
+
+			if (trace_fn(ray).hit)
+				hit_count++;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	double ray_count = double(RAY_GRID_SIZE * RAY_GRID_SIZE);
+	return std::chrono::duration<double, std::nano>(end - start).count() / ray_count;
+}
+
+int main(int argc, char* argv[])
+{
+	printf("%10s %18s %18s %10s\n", "spheres", "hittable (ns/ray)", "batched (ns/ray)", "hits");
+
+	for (size_t sphere_count = 100; sphere_count <= 1000000; sphere_count *= 10)
+	{
+		std::mt19937 rng(1337);
+
+		float extent = 100.0f * std::cbrt(float(sphere_count) / 1000.0f);
+		std::uniform_real_distribution<float> position(-extent, extent);
+
+		HittableList world;
+		for (size_t i = 0; i < sphere_count; i++)
+		{
+			auto sphere = std::make_shared<BoundingSphere>();
+			bound_sphere_create(*sphere, 2.0f, { position(rng), position(rng), position(rng) - 2.0f * extent });
+
+			hittable_list_add(world, sphere);
+		}
+
+		BVH bvh;
+		bvh_build(bvh, world);
+
+		GeometryScene scene;
+		geometry_scene_create(scene);
+		geometry_scene_build(scene, world);
+
+		size_t hittable_hits;
+		double hittable_ns = _trace_grid(hittable_hits, [&](const Ray& ray) {
+			return bvh_hit(bvh, world, ray, 0.001f, constants_infinity<float>());
+		});
+
+		size_t batched_hits;
+		double batched_ns = _trace_grid(batched_hits, [&](const Ray& ray) {
+			return geometry_scene_hit(scene, ray, 0.001f, constants_infinity<float>());
+		});
+
+		printf("%10zu %18.1f %18.1f %10zu%s\n",
+			sphere_count, hittable_ns, batched_ns, batched_hits,
+			batched_hits == hittable_hits ? "" : " (MISMATCH)");
+
+		geometry_scene_destroy(scene);
+	}
+
+	return 0;
+}
@@ -0,0 +1,222 @@
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <memory>
+
+#include <Math/Geometry.hpp>
+#include <Math/Instance.hpp>
+#include <Math/Transform.hpp>
+#include <Math/TriangleMesh.hpp>
+
+// Scatters instances of one tessellated sphere with random rotations and
+// scales, then reports memory, top-level build time and primary ray
+// throughput. A small configuration is also flattened into a single mesh
+// with every transform baked in, and both must agree on every hit.
+
+static constexpr size_t RAY_GRID_SIZE = 256;
+
+static void
+_tessellate_sphere(std::vector<Vec3f>& positions, std::vector<uint32_t>& indices, size_t segments, float radius)
+{
+	const float pi = 3.14159265358979f;
+
+	positions.clear();
+	indices.clear();
+
+	for (size_t ring = 0; ring <= segments; ring++)
+	{
+		float theta = pi * float(ring) / float(segments);
+		for (size_t segment = 0; segment < segments; segment++)
+		{
+			float phi = 2.0f * pi * float(segment) / float(segments);
+			positions.push_back({ radius * std::sin(theta) * std::cos(phi), radius * std::cos(theta), radius * std::sin(theta) * std::sin(phi) });
+		}
+	}
+
+	for (size_t ring = 0; ring < segments; ring++)
+	{
+		for (size_t segment = 0; segment < segments; segment++)
+		{
+			uint32_t a = uint32_t(ring * segments + segment);
+			uint32_t b = uint32_t(ring * segments + (segment + 1) % segments);
+
+			indices.insert(indices.end(), { a, b, uint32_t(a + segments) });
+			indices.insert(indices.end(), { b, uint32_t(b + segments), uint32_t(a + segments) });
+		}
+	}
+}
+
+static size_t
+_mesh_bytes(const TriangleMesh& mesh)
+{
+	size_t triangle_count = triangle_mesh_get_triangle_count(mesh);
+
+	return mesh.positions.size() * sizeof(Vec3f) + mesh.indices.size() * sizeof(uint32_t) +
+		triangle_count * (9 * sizeof(float) + sizeof(uint32_t)) +
+		mesh.bvh.nodes.size() * sizeof(BVHNode) + mesh.bvh.indices.size() * sizeof(uint32_t) +
+		mesh.wide_bvh.nodes.size() * sizeof(mesh.wide_bvh.nodes[0]);
+}
+
+static std::vector<Transform>
+_scatter(size_t instance_count, float& extent)
+{
+	std::mt19937 rng(1337);
+
+	extent = 100.0f * std::cbrt(float(instance_count) / 1000.0f);
+	std::uniform_real_distribution<float> position(-extent, extent);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+	std::vector<Transform> transforms(instance_count);
+	for (Transform& transform : transforms)
+	{
+		Vec3f axis = { unit(rng), unit(rng), unit(rng) + 2.0f };
+		float s = scale(rng);
+
+		transform = transform_multiply(
+			transform_translate({ position(rng), position(rng), position(rng) - 2.0f * extent }),
+			transform_multiply(transform_rotate(axis, unit(rng) * 3.14159f), transform_scale({ s, s, s })));
+	}
+
+	return transforms;
+}
+
+static Ray
+_primary_ray(size_t x, size_t y)
+{
+	Vec3f direction = { (float(x) / RAY_GRID_SIZE) - 0.5f, (float(y) / RAY_GRID_SIZE) - 0.5f, -1.0f };
+
+	return { { 0.0f, 0.0f, 0.0f }, vector_normalize(direction) };
+}
+
+int main(int argc, char* argv[])
+{
+	// Correctness against a flattened copy.
+	{
+		std::vector<Vec3f> positions;
+		std::vector<uint32_t> indices;
+		_tessellate_sphere(positions, indices, 32, 2.0f);
+
+		TriangleMesh mesh;
+		triangle_mesh_create(mesh, positions.data(), positions.size(), indices.data(), indices.size());
+
+		float extent;
+		std::vector<Transform> transforms = _scatter(512, extent);
+
+		HittableList world;
+		std::vector<Vec3f> flat_positions;
+		std::vector<uint32_t> flat_indices;
+
+		for (const Transform& transform : transforms)
+		{
+			auto instance = std::make_shared<Instance>();
+			instance_create(*instance, &mesh, transform);
+			hittable_list_add(world, instance);
+
+			uint32_t base = uint32_t(flat_positions.size());
+			for (const Vec3f& position : positions)
+				flat_positions.push_back(transform_point(transform, position));
+			for (uint32_t index : indices)
+				flat_indices.push_back(base + index);
+		}
+
+		TriangleMesh flat;
+		triangle_mesh_create(flat, flat_positions.data(), flat_positions.size(), flat_indices.data(), flat_indices.size());
+
+		GeometryScene scene;
+		geometry_scene_create(scene);
+		geometry_scene_build(scene, world);
+		geometry_scene_set_acceleration(scene, AccelerationType::AT_BVH8);
+
+		size_t mismatch_count = 0, hit_count = 0;
+		for (size_t y = 0; y < RAY_GRID_SIZE; y++)
+		{
+			for (size_t x = 0; x < RAY_GRID_SIZE; x++)
+			{
+				Ray ray = _primary_ray(x, y);
+
+				HitRecord instanced = geometry_scene_hit(scene, ray, 0.001f, constants_infinity<float>());
+				HitRecord flattened = triangle_mesh_hit_record(flat, triangle_mesh_intersect(flat, ray, 0.001f, constants_infinity<float>()), ray);
+
+				hit_count += instanced.hit;
+
+				// Silhouette grazes round differently in object and world space.
+				const HitRecord& any = instanced.hit ? instanced : flattened;
+				if (any.hit && std::abs(vector_dot(any.normal, ray.direction)) < 0.2f)
+					continue;
+
+				if (instanced.hit != flattened.hit ||
+					(instanced.hit && (std::abs(instanced.t - flattened.t) > 1e-3f * flattened.t ||
+						vector_dot(instanced.normal, flattened.normal) < 0.999f)))
+					mismatch_count++;
+			}
+		}
+
+		printf("flattened check: %zu instances, %zu hits, %zu mismatches\n", transforms.size(), hit_count, mismatch_count);
+
+		geometry_scene_destroy(scene);
+		triangle_mesh_destroy(flat);
+		triangle_mesh_destroy(mesh);
+	}
+
+	std::vector<Vec3f> positions;
+	std::vector<uint32_t> indices;
+	_tessellate_sphere(positions, indices, 708, 2.0f);
+
+	TriangleMesh mesh;
+	triangle_mesh_create(mesh, positions.data(), positions.size(), indices.data(), indices.size());
+
+	size_t mesh_bytes = _mesh_bytes(mesh);
+
+	printf("mesh: %zu triangles, %.1f MB\n", triangle_mesh_get_triangle_count(mesh), double(mesh_bytes) / (1 << 20));
+	printf("%10s %14s %14s %12s %12s %10s\n", "instances", "instance (MB)", "flattened (MB)", "build (ms)", "Mrays/s", "hits");
+
+	for (size_t instance_count = 10; instance_count <= 10000; instance_count *= 10)
+	{
+		float extent;
+		std::vector<Transform> transforms = _scatter(instance_count, extent);
+
+		HittableList world;
+		for (const Transform& transform : transforms)
+		{
+			auto instance = std::make_shared<Instance>();
+			instance_create(*instance, &mesh, transform);
+			hittable_list_add(world, instance);
+		}
+
+		GeometryScene scene;
+		geometry_scene_create(scene);
+
+		auto build_start = std::chrono::steady_clock::now();
+		geometry_scene_build(scene, world);
+		geometry_scene_set_acceleration(scene, AccelerationType::AT_BVH8);
+		auto build_end = std::chrono::steady_clock::now();
+
+		size_t instance_bytes = instance_count * (sizeof(Instance) + sizeof(std::shared_ptr<Hittable>) + sizeof(GeometryHandle) + sizeof(const Instance*)) +
+			scene.bvh.nodes.size() * sizeof(BVHNode) + scene.bvh.indices.size() * sizeof(uint32_t) +
+			scene.bvh8.nodes.size() * sizeof(scene.bvh8.nodes[0]) + mesh_bytes;
+
+		TraversalStats stats {};
+		size_t hit_count = 0;
+
+		auto start = std::chrono::steady_clock::now();
+		for (size_t y = 0; y < RAY_GRID_SIZE; y++)
+			for (size_t x = 0; x < RAY_GRID_SIZE; x++)
+				hit_count += geometry_scene_intersect(scene, _primary_ray(x, y), 0.001f, constants_infinity<float>(), &stats).hit;
+		auto end = std::chrono::steady_clock::now();
+
+		printf("%10zu %14.1f %14.1f %12.2f %12.2f %10zu\n", instance_count,
+			double(instance_bytes) / (1 << 20), double(mesh_bytes * instance_count) / (1 << 20),
+			std::chrono::duration<double, std::milli>(build_end - build_start).count(),
+			double(stats.rays) / std::chrono::duration<double>(end - start).count() / 1e6,
+			hit_count);
+
+		geometry_scene_destroy(scene);
+	}
+
+	triangle_mesh_destroy(mesh);
+
+	return 0;
+}
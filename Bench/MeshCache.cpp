@@ -0,0 +1,151 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+
+#include <Mesh/MeshCache.hpp>
+
+// Writes a height-field grid as OBJ (256 MB by default, first argument
+// overrides) and loads it through the BVH cache three times: cold, which parses,
+// builds and writes the cache; warm, which maps it; and after an edit to the
+// file, which has to miss again. Rays traced through the built and the mapped
+// mesh must agree.
+
+static constexpr size_t RAY_GRID_SIZE = 512;
+
+static size_t
+_write_obj(const char* filename, size_t target_bytes)
+{
+	FILE* fp = fopen(filename, "wb");
+	if (!fp)
+		return 0;
+
+	// A square grid of n x n vertices takes roughly 70 bytes per vertex.
+	size_t n = 2;
+	while ((n + 1) * (n + 1) * 70 < target_bytes)
+		n++;
+
+	size_t bytes = 0;
+
+	for (size_t y = 0; y < n; y++)
+		for (size_t x = 0; x < n; x++)
+			bytes += fprintf(fp, "v %.6f %.6f %.6f\n", float(x) / float(n), 0.05f * std::sin(float(x + y) * 0.1f), -float(y) / float(n));
+
+	for (size_t y = 0; y + 1 < n; y++)
+	{
+		for (size_t x = 0; x + 1 < n; x++)
+		{
+			size_t a = y * n + x + 1, b = a + 1, c = a + n, d = c + 1;
+			bytes += fprintf(fp, "f %zu %zu %zu %zu\n", a, b, d, c);
+		}
+	}
+
+	fclose(fp);
+
+	return bytes;
+}
+
+static size_t
+_count_mismatches(const TriangleMesh& lhs, const TriangleMesh& rhs)
+{
+	size_t mismatch_count = 0;
+
+	for (size_t y = 0; y < RAY_GRID_SIZE; y++)
+	{
+		for (size_t x = 0; x < RAY_GRID_SIZE; x++)
+		{
+			Vec3f origin = { 0.5f, 2.0f, -0.5f };
+			Vec3f direction = Vec3f{ (float(x) + 0.5f) / RAY_GRID_SIZE, 0.0f, -(float(y) + 0.5f) / RAY_GRID_SIZE } - origin;
+
+			Ray ray { origin, vector_normalize(direction) };
+
+			TriangleHit lhs_hit = triangle_mesh_intersect(lhs, ray, 0.001f, constants_infinity<float>());
+			TriangleHit rhs_hit = triangle_mesh_intersect(rhs, ray, 0.001f, constants_infinity<float>());
+
+			HitRecord lhs_record = triangle_mesh_hit_record(lhs, lhs_hit, ray);
+			HitRecord rhs_record = triangle_mesh_hit_record(rhs, rhs_hit, ray);
+
+			mismatch_count += lhs_hit.hit != rhs_hit.hit || lhs_hit.t != rhs_hit.t ||
+				lhs.triangles.primitive[lhs_hit.index] != rhs.triangles.primitive[rhs_hit.index] ||
+				vector_distance(lhs_record.normal, rhs_record.normal) != 0.0f;
+		}
+	}
+
+	return mismatch_count;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t target_mb = argc > 1 ? size_t(atoll(argv[1])) : 256;
+
+	std::string obj_filename = "mesh-cache-bench.obj";
+	std::string cache_filename = obj_filename + ".bvh";
+
+	remove(cache_filename.c_str());
+
+	size_t bytes = _write_obj(obj_filename.c_str(), target_mb << 20);
+	if (!bytes)
+	{
+		printf("could not write %s\n", obj_filename.c_str());
+		return 1;
+	}
+
+	printf("%s: %.1f MB\n", obj_filename.c_str(), double(bytes) / (1 << 20));
+	printf("%-8s %6s %10s %10s %10s %10s %10s %10s\n", "load", "cache", "hash ms", "open ms", "parse ms", "build ms", "write ms", "total ms");
+
+	TriangleMesh built;
+	MeshCache built_cache;
+	mesh_cache_create(built_cache);
+
+	TriangleMesh mapped;
+	MeshCache mapped_cache;
+	mesh_cache_create(mapped_cache);
+
+	const char* load_names[] = { "cold", "warm", "edited" };
+	for (int load = 0; load < 3; load++)
+	{
+		TriangleMesh& mesh = load == 1 ? mapped : built;
+		MeshCache& cache = load == 1 ? mapped_cache : built_cache;
+
+		if (load == 2)
+		{
+			triangle_mesh_destroy(built);
+			mesh_cache_close(built_cache);
+
+			FILE* fp = fopen(obj_filename.c_str(), "ab");
+			fputs("# edited\n", fp);
+			fclose(fp);
+		}
+
+		MeshCacheStats stats {};
+
+		auto load_start = std::chrono::steady_clock::now();
+		bool loaded = triangle_mesh_load_cached(mesh, cache, obj_filename.c_str(), cache_filename.c_str(), 0, &stats);
+		auto load_end = std::chrono::steady_clock::now();
+
+		if (!loaded)
+		{
+			printf("%-8s load failed\n", load_names[load]);
+			return 1;
+		}
+
+		printf("%-8s %6s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", load_names[load], stats.hit ? "hit" : "miss",
+			stats.hash_ms, stats.open_ms, stats.load.parse_ms, stats.load.build_ms, stats.write_ms,
+			std::chrono::duration<double, std::milli>(load_end - load_start).count());
+	}
+
+	printf("%zu triangles, %zu of %zu rays differ between built and mapped mesh\n", triangle_mesh_get_triangle_count(mapped),
+		_count_mismatches(built, mapped), RAY_GRID_SIZE * RAY_GRID_SIZE);
+
+	triangle_mesh_destroy(built);
+	triangle_mesh_destroy(mapped);
+
+	mesh_cache_close(built_cache);
+	mesh_cache_close(mapped_cache);
+
+	remove(obj_filename.c_str());
+	remove(cache_filename.c_str());
+
+	return 0;
+}
@@ -0,0 +1,166 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Mesh/MeshLoader.hpp>
+
+// Writes a height-field grid as OBJ until the file reaches the requested size
+// (1024 MB by default, first argument overrides) and loads it with every
+// thread count from one to the hardware concurrency. Small ascii and binary
+// PLY copies of the same grid are loaded to check that all formats agree.
+
+static size_t
+_write_obj(const char* filename, size_t target_bytes, size_t& vertex_count, size_t& triangle_count)
+{
+	FILE* fp = fopen(filename, "wb");
+	if (!fp)
+		return 0;
+
+	// A square grid of n x n vertices takes roughly 70 bytes per vertex.
+	size_t n = 2;
+	while ((n + 1) * (n + 1) * 70 < target_bytes)
+		n++;
+
+	size_t bytes = 0;
+
+	for (size_t y = 0; y < n; y++)
+		for (size_t x = 0; x < n; x++)
+			bytes += fprintf(fp, "v %.6f %.6f %.6f\n", float(x) * 0.01f, 0.25f * std::sin(float(x + y) * 0.1f), -float(y) * 0.01f);
+
+	for (size_t y = 0; y + 1 < n; y++)
+	{
+		for (size_t x = 0; x + 1 < n; x++)
+		{
+			size_t a = y * n + x + 1, b = a + 1, c = a + n, d = c + 1;
+			bytes += fprintf(fp, "f %zu %zu %zu %zu\n", a, b, d, c);
+		}
+	}
+
+	fclose(fp);
+
+	vertex_count = n * n;
+	triangle_count = (n - 1) * (n - 1) * 2;
+
+	return bytes;
+}
+
+static void
+_write_ply(const char* filename, const TriangleMesh& mesh, bool binary)
+{
+	FILE* fp = fopen(filename, "wb");
+
+	fprintf(fp, "ply\nformat %s 1.0\ncomment grid\n", binary ? "binary_little_endian" : "ascii");
+	fprintf(fp, "element vertex %zu\nproperty float x\nproperty float y\nproperty float z\n", mesh.positions.size());
+	fprintf(fp, "element face %zu\nproperty list uchar int vertex_indices\nend_header\n", triangle_mesh_get_triangle_count(mesh));
+
+	for (const Vec3f& position : mesh.positions)
+	{
+		if (binary)
+			fwrite(&position.x, sizeof(float), 3, fp);
+		else
+			fprintf(fp, "%.6f %.6f %.6f\n", position.x, position.y, position.z);
+	}
+
+	for (size_t i = 0; i < mesh.indices.size(); i += 3)
+	{
+		if (binary)
+		{
+			uint8_t count = 3;
+			int32_t indices[3] = { int32_t(mesh.indices[i]), int32_t(mesh.indices[i + 1]), int32_t(mesh.indices[i + 2]) };
+
+			fwrite(&count, 1, 1, fp);
+			fwrite(indices, sizeof(int32_t), 3, fp);
+		}
+		else
+			fprintf(fp, "3 %u %u %u\n", mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2]);
+	}
+
+	fclose(fp);
+}
+
+static bool
+_same_mesh(const TriangleMesh& lhs, const TriangleMesh& rhs)
+{
+	if (lhs.positions.size() != rhs.positions.size() || lhs.indices != rhs.indices)
+		return false;
+
+	for (size_t i = 0; i < lhs.positions.size(); i++)
+		if (vector_distance(lhs.positions[i], rhs.positions[i]) > 1e-5f)
+			return false;
+
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t target_mb = argc > 1 ? size_t(atoll(argv[1])) : 1024;
+
+	std::string obj_filename = "mesh-load-bench.obj";
+
+	size_t vertex_count = 0, triangle_count = 0;
+	size_t bytes = _write_obj(obj_filename.c_str(), target_mb << 20, vertex_count, triangle_count);
+	if (!bytes)
+	{
+		printf("could not write %s\n", obj_filename.c_str());
+		return 1;
+	}
+
+	printf("%s: %.1f MB, %zu vertices, %zu triangles\n", obj_filename.c_str(), double(bytes) / (1 << 20), vertex_count, triangle_count);
+	printf("%8s %12s %10s %12s\n", "threads", "parse (ms)", "MB/s", "build (ms)");
+
+	uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+	for (uint32_t thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+	{
+		TriangleMesh mesh;
+		MeshLoadStats stats {};
+
+		if (!triangle_mesh_load(mesh, obj_filename.c_str(), thread_count, &stats) ||
+			stats.vertex_count != vertex_count || stats.triangle_count != triangle_count)
+		{
+			printf("%8u load failed\n", thread_count);
+			return 1;
+		}
+
+		printf("%8u %12.1f %10.1f %12.1f\n", stats.thread_count, stats.parse_ms,
+			double(stats.bytes) / (1 << 20) / (stats.parse_ms / 1000.0), stats.build_ms);
+
+		triangle_mesh_destroy(mesh);
+
+		if (thread_count * 2 > max_threads && thread_count != max_threads)
+			thread_count = max_threads / 2;
+	}
+
+	remove(obj_filename.c_str());
+
+	// Format cross-check on a small grid.
+	_write_obj(obj_filename.c_str(), 4 << 20, vertex_count, triangle_count);
+
+	TriangleMesh reference;
+	triangle_mesh_load(reference, obj_filename.c_str());
+
+	for (bool binary : { false, true })
+	{
+		const char* ply_filename = binary ? "mesh-load-bench-binary.ply" : "mesh-load-bench-ascii.ply";
+		_write_ply(ply_filename, reference, binary);
+
+		TriangleMesh mesh;
+		bool loaded = triangle_mesh_load(mesh, ply_filename);
+
+		printf("%s ply: %s\n", binary ? "binary" : "ascii", loaded && _same_mesh(reference, mesh) ? "match" : "MISMATCH");
+
+		if (loaded)
+			triangle_mesh_destroy(mesh);
+
+		remove(ply_filename);
+	}
+
+	triangle_mesh_destroy(reference);
+	remove(obj_filename.c_str());
+
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <memory>
+
+#include <Math/Geometry.hpp>
+#include <Math/Hittable.hpp>
+#include <Math/RayPacket.hpp>
+#include <Math/BoundingSphere.hpp>
+
+// Primary visibility throughput for single rays against 8x8 packets. Pixels
+// are generated the same way as the app: a pinhole camera at the origin
+// looking down -z.
+
+static constexpr size_t IMAGE_SIZE = 1024;
+
+static Vec3f
+_pixel_direction(size_t x, size_t y)
+{
+	Vec3f direction = {
+		(float(x) + 0.5f) / IMAGE_SIZE - 0.5f,
+		0.5f - (float(y) + 0.5f) / IMAGE_SIZE,
+		-1.0f
+	};
+
+	return vector_normalize(direction);
+}
+
+int main(int argc, char* argv[])
+{
+	printf("%10s %16s %16s %16s %10s\n", "spheres", "BVH2 (Mrays/s)", "BVH8 (Mrays/s)", "packet (Mrays/s)", "mismatch");
+
+	for (size_t sphere_count = 1000; sphere_count <= 1000000; sphere_count *= 10)
+	{
+		std::mt19937 rng(1337);
+
+		float extent = 100.0f * std::cbrt(float(sphere_count) / 1000.0f);
+		std::uniform_real_distribution<float> position(-extent, extent);
+
+		HittableList world;
+		for (size_t i = 0; i < sphere_count; i++)
+		{
+			auto sphere = std::make_shared<BoundingSphere>();
+			bound_sphere_create(*sphere, 2.0f, { position(rng), position(rng), position(rng) - 2.0f * extent });
+
+			hittable_list_add(world, sphere);
+		}
+
+		GeometryScene scene;
+		geometry_scene_create(scene);
+		geometry_scene_build(scene, world);
+
+		std::vector<float> single_t(IMAGE_SIZE * IMAGE_SIZE);
+		std::vector<float> packet_t(IMAGE_SIZE * IMAGE_SIZE);
+
+		double single_mrays[2];
+		for (int i = 0; i < 2; i++)
+		{
+			geometry_scene_set_acceleration(scene, i ? AccelerationType::AT_BVH8 : AccelerationType::AT_BVH2);
+
+			auto start = std::chrono::steady_clock::now();
+			for (size_t y = 0; y < IMAGE_SIZE; y++)
+			{
+				for (size_t x = 0; x < IMAGE_SIZE; x++)
+				{
+					Ray ray { { 0.0f, 0.0f, 0.0f }, _pixel_direction(x, y) };
+
+					GeometryHit hit = geometry_scene_intersect(scene, ray, 0.001f, constants_infinity<float>());
+					single_t[x + y * IMAGE_SIZE] = hit.hit ? hit.t : -1.0f;
+				}
+			}
+			auto end = std::chrono::steady_clock::now();
+
+			single_mrays[i] = double(IMAGE_SIZE * IMAGE_SIZE) / std::chrono::duration<double, std::micro>(end - start).count();
+		}
+
+		RayPacket packet;
+		GeometryHit hits[RAY_PACKET_SIZE];
+
+		auto start = std::chrono::steady_clock::now();
+		for (size_t tile_y = 0; tile_y < IMAGE_SIZE; tile_y += RAY_PACKET_WIDTH)
+		{
+			for (size_t tile_x = 0; tile_x < IMAGE_SIZE; tile_x += RAY_PACKET_WIDTH)
+			{
+				ray_packet_create(packet, { 0.0f, 0.0f, 0.0f }, 0.001f, constants_infinity<float>());
+
+				for (size_t y = 0; y < RAY_PACKET_WIDTH; y++)
+					for (size_t x = 0; x < RAY_PACKET_WIDTH; x++)
+						ray_packet_add(packet, _pixel_direction(tile_x + x, tile_y + y));
+
+				ray_packet_finalize(packet);
+				geometry_scene_intersect_packet(scene, packet, hits);
+
+				for (size_t i = 0; i < RAY_PACKET_SIZE; i++)
+				{
+					size_t x = tile_x + i % RAY_PACKET_WIDTH;
+					size_t y = tile_y + i / RAY_PACKET_WIDTH;
+
+					packet_t[x + y * IMAGE_SIZE] = hits[i].hit ? hits[i].t : -1.0f;
+				}
+			}
+		}
+		auto end = std::chrono::steady_clock::now();
+
+		double packet_mrays = double(IMAGE_SIZE * IMAGE_SIZE) / std::chrono::duration<double, std::micro>(end - start).count();
+
+		size_t mismatch = 0;
+		for (size_t i = 0; i < single_t.size(); i++)
+			if (std::abs(single_t[i] - packet_t[i]) > 1e-3f * std::max(1.0f, std::abs(single_t[i])))
+				mismatch++;
+
+		printf("%10zu %16.2f %16.2f %16.2f %10zu\n",
+			sphere_count, single_mrays[0], single_mrays[1], packet_mrays, mismatch);
+
+		geometry_scene_destroy(scene);
+	}
+
+	return 0;
+}
@@ -0,0 +1,99 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <Math/Geometry.hpp>
+#include <Math/BoundingSphere.hpp>
+
+#include <Render/Renderer.hpp>
+
+// Renders a deliberately skewed frame, with all geometry packed into the top
+// left corner and empty sky elsewhere, once with static per-thread shares and
+// once with work stealing, and prints each thread's busy and idle time. The
+// thread count defaults to the hardware concurrency but at least four; the
+// first argument overrides it.
+
+static constexpr size_t FRAME_WIDTH = 1920;
+static constexpr size_t FRAME_HEIGHT = 1080;
+static constexpr size_t SPHERE_COUNT = 50000;
+static constexpr int FRAME_COUNT = 3;
+
+int main(int argc, char* argv[])
+{
+	uint32_t thread_count = argc > 1 ? uint32_t(atoi(argv[1])) : std::max(4u, std::thread::hardware_concurrency());
+
+	float viewport_width = 5.0f;
+	float viewport_height = viewport_width * float(FRAME_HEIGHT) / float(FRAME_WIDTH);
+
+	RenderView view;
+	view.center = { 0.0f, 0.0f, 0.0f };
+	view.pixel_delta_u = Vec3f{ viewport_width, 0.0f, 0.0f } / float(FRAME_WIDTH);
+	view.pixel_delta_v = Vec3f{ 0.0f, -viewport_height, 0.0f } / float(FRAME_HEIGHT);
+	view.viewport_upper_left = Vec3f{ -viewport_width / 2.0f, viewport_height / 2.0f, -10.0f };
+
+	// Spheres are dropped along rays through the top left sixteenth of the
+	// frame, at random depths.
+	std::mt19937 rng(1337);
+	std::uniform_real_distribution<float> pixel_x(0.0f, FRAME_WIDTH / 4.0f);
+	std::uniform_real_distribution<float> pixel_y(0.0f, FRAME_HEIGHT / 4.0f);
+	std::uniform_real_distribution<float> depth(20.0f, 60.0f);
+	std::uniform_real_distribution<float> radius(0.05f, 0.2f);
+
+	HittableList world;
+	for (size_t i = 0; i < SPHERE_COUNT; i++)
+	{
+		Vec3f pixel = view.viewport_upper_left + pixel_x(rng) * view.pixel_delta_u + pixel_y(rng) * view.pixel_delta_v;
+
+		auto sphere = std::make_shared<BoundingSphere>();
+		bound_sphere_create(*sphere, radius(rng), depth(rng) * pixel);
+
+		hittable_list_add(world, sphere);
+	}
+
+	GeometryScene scene;
+	geometry_scene_create(scene);
+	geometry_scene_set_acceleration(scene, SIMD_WIDTH >= 8 ? AccelerationType::AT_BVH8 : AccelerationType::AT_BVH4);
+	geometry_scene_build(scene, world);
+
+	std::vector<uint8_t> reference(FRAME_WIDTH * FRAME_HEIGHT * 3);
+	std::vector<uint8_t> pixels(FRAME_WIDTH * FRAME_HEIGHT * 3);
+
+	printf("%ux%u, %zu spheres in the top left corner, %u threads\n", unsigned(FRAME_WIDTH), unsigned(FRAME_HEIGHT), SPHERE_COUNT, thread_count);
+
+	for (bool work_stealing : { false, true })
+	{
+		Renderer renderer;
+		renderer_create(renderer, { thread_count, RENDER_DEFAULT_TILE_SIZE, true, work_stealing });
+
+		RenderTarget target = { work_stealing ? pixels.data() : reference.data(), FRAME_WIDTH, FRAME_HEIGHT, FRAME_WIDTH * 3 };
+
+		RenderStats best {};
+		for (int frame = 0; frame <= FRAME_COUNT; frame++)
+		{
+			RenderStats stats = renderer_render(renderer, scene, view, target);
+			if (frame == 1 || (frame > 1 && stats.render_ms < best.render_ms))
+				best = stats;
+		}
+
+		renderer_destroy(renderer);
+
+		printf("\n%s: %.2f ms, load balance %.1f%%\n", work_stealing ? "work stealing" : "static shares", best.render_ms, best.load_balance * 100.0f);
+		printf("%8s %10s %10s %8s %8s %8s\n", "thread", "busy ms", "idle ms", "tiles", "steals", "splits");
+
+		for (uint32_t i = 0; i < best.thread_count; i++)
+		{
+			const RenderThreadStats& thread = best.threads[i];
+			printf("%8u %10.2f %10.2f %8u %8u %8u\n", i, thread.busy_ms, thread.idle_ms, thread.tile_count, thread.steal_count, thread.split_count);
+		}
+	}
+
+	printf("\nimages %s\n", memcmp(reference.data(), pixels.data(), pixels.size()) == 0 ? "match" : "MISMATCH");
+
+	geometry_scene_destroy(scene);
+
+	return 0;
+}
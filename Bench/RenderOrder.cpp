@@ -0,0 +1,191 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include <Math/Geometry.hpp>
+#include <Math/BoundingSphere.hpp>
+
+#include <Render/Renderer.hpp>
+
+// Renders a dense field of half a million spheres, whose BVH is far larger
+// than the caches, in scanline, Morton and Hilbert order, with and without
+// packet tracing. Reports throughput and, where perf events are available,
+// last level and L1 data cache misses per ray. Every order has to produce the
+// scanline image byte for byte. The first argument overrides the thread count.
+
+static constexpr size_t FRAME_WIDTH = 1920;
+static constexpr size_t FRAME_HEIGHT = 1080;
+static constexpr size_t SPHERE_COUNT = 500000;
+static constexpr int FRAME_COUNT = 3;
+
+// Hardware counters covering every thread started after they are opened;
+// counts of exited threads are folded into the fd they were inherited from.
+struct _Counters
+{
+	int cache_misses;
+	int l1d_misses;
+};
+
+#ifdef __linux__
+static int
+_open_counter(uint32_t type, uint64_t config)
+{
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+static void
+_open_counters(_Counters& self)
+{
+#ifdef __linux__
+	self.cache_misses = _open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+	self.l1d_misses = _open_counter(PERF_TYPE_HW_CACHE,
+		PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#else
+	self.cache_misses = self.l1d_misses = -1;
+#endif
+}
+static void
+_close_counters(_Counters& self)
+{
+#ifdef __linux__
+	if (self.cache_misses >= 0)
+		close(self.cache_misses);
+	if (self.l1d_misses >= 0)
+		close(self.l1d_misses);
+#endif
+}
+
+static uint64_t
+_read_counter(int fd)
+{
+	uint64_t value = 0;
+#ifdef __linux__
+	if (fd < 0 || read(fd, &value, sizeof(value)) != sizeof(value))
+		value = 0;
+#endif
+	return value;
+}
+
+static void
+_format_per_ray(char* buffer, size_t size, int fd, uint64_t count, uint64_t rays)
+{
+	if (fd < 0)
+		snprintf(buffer, size, "n/a");
+	else
+		snprintf(buffer, size, "%.3f", rays ? double(count) / double(rays) : 0.0);
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t thread_count = argc > 1 ? uint32_t(atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+
+	std::mt19937 rng(1337);
+	std::uniform_real_distribution<float> lateral(-150.0f, 150.0f);
+	std::uniform_real_distribution<float> depth(-950.0f, -350.0f);
+	std::uniform_real_distribution<float> radius(0.5f, 2.0f);
+
+	HittableList world;
+	for (size_t i = 0; i < SPHERE_COUNT; i++)
+	{
+		auto sphere = std::make_shared<BoundingSphere>();
+		bound_sphere_create(*sphere, radius(rng), { lateral(rng), lateral(rng), depth(rng) });
+
+		hittable_list_add(world, sphere);
+	}
+
+	GeometryScene scene;
+	geometry_scene_create(scene);
+	geometry_scene_set_acceleration(scene, SIMD_WIDTH >= 8 ? AccelerationType::AT_BVH8 : AccelerationType::AT_BVH4);
+	geometry_scene_build(scene, world);
+
+	float viewport_width = 5.0f;
+	float viewport_height = viewport_width * float(FRAME_HEIGHT) / float(FRAME_WIDTH);
+
+	RenderView view;
+	view.center = { 0.0f, 0.0f, 0.0f };
+	view.pixel_delta_u = Vec3f{ viewport_width, 0.0f, 0.0f } / float(FRAME_WIDTH);
+	view.pixel_delta_v = Vec3f{ 0.0f, -viewport_height, 0.0f } / float(FRAME_HEIGHT);
+	view.viewport_upper_left = Vec3f{ -viewport_width / 2.0f, viewport_height / 2.0f, -10.0f };
+
+	_Counters counters;
+	_open_counters(counters);
+
+	std::vector<uint8_t> reference(FRAME_WIDTH * FRAME_HEIGHT * 3);
+	std::vector<uint8_t> pixels(FRAME_WIDTH * FRAME_HEIGHT * 3);
+
+	const char* order_names[] = { "scanline", "morton", "hilbert" };
+
+	printf("%ux%u, %zu spheres, %u threads\n", unsigned(FRAME_WIDTH), unsigned(FRAME_HEIGHT), SPHERE_COUNT, thread_count);
+	printf("%-8s %-9s %10s %10s %12s %12s %10s\n", "tracing", "order", "ms", "Mrays/s", "LLC miss/ray", "L1D miss/ray", "image");
+
+	for (bool packet_tracing : { false, true })
+	{
+		for (RenderOrder order : { RenderOrder::RO_SCANLINE, RenderOrder::RO_MORTON, RenderOrder::RO_HILBERT })
+		{
+			uint64_t cache_misses = _read_counter(counters.cache_misses);
+			uint64_t l1d_misses = _read_counter(counters.l1d_misses);
+
+			// Pool threads have to start after the counters were read and
+			// exit before they are read again, for their counts to land.
+			Renderer renderer;
+			renderer_create(renderer, { thread_count, RENDER_DEFAULT_TILE_SIZE, packet_tracing, true, order });
+
+			RenderTarget target = { order == RenderOrder::RO_SCANLINE ? reference.data() : pixels.data(), FRAME_WIDTH, FRAME_HEIGHT, FRAME_WIDTH * 3 };
+
+			// The first frame warms caches and the pool; the best of the rest
+			// counts. Misses are averaged over every ray traced.
+			RenderStats best {};
+			uint64_t rays = 0;
+			for (int frame = 0; frame <= FRAME_COUNT; frame++)
+			{
+				RenderStats stats = renderer_render(renderer, scene, view, target);
+				if (frame == 1 || (frame > 1 && stats.render_ms < best.render_ms))
+					best = stats;
+
+				rays += stats.traversal.rays;
+			}
+
+			renderer_destroy(renderer);
+
+			cache_misses = _read_counter(counters.cache_misses) - cache_misses;
+			l1d_misses = _read_counter(counters.l1d_misses) - l1d_misses;
+
+			char cache_misses_text[32], l1d_misses_text[32];
+			_format_per_ray(cache_misses_text, sizeof(cache_misses_text), counters.cache_misses, cache_misses, rays);
+			_format_per_ray(l1d_misses_text, sizeof(l1d_misses_text), counters.l1d_misses, l1d_misses, rays);
+
+			bool match = order == RenderOrder::RO_SCANLINE || memcmp(reference.data(), pixels.data(), pixels.size()) == 0;
+
+			printf("%-8s %-9s %10.2f %10.2f %12s %12s %10s\n", packet_tracing ? "packet" : "single", order_names[int(order)],
+				best.render_ms, double(best.traversal.rays) / (best.render_ms * 1000.0), cache_misses_text, l1d_misses_text,
+				match ? "match" : "MISMATCH");
+		}
+	}
+
+	_close_counters(counters);
+
+	geometry_scene_destroy(scene);
+
+	return 0;
+}
@@ -0,0 +1,139 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <Math/Geometry.hpp>
+#include <Math/BoundingSphere.hpp>
+
+#include <Render/Renderer.hpp>
+#include <Render/Accumulation.hpp>
+
+// Accumulates passes of a 3840x2160 sphere field, whose target and float
+// accumulation buffer are far larger than the caches, with render threads
+// left to the scheduler or pinned, and with freshly allocated buffers either
+// cleared by the calling thread, as a serial reset would, or first touched by
+// the threads rendering each tile. On multi-socket machines the latter places
+// every tile on the node that renders it. Every configuration has to resolve
+// to the same image. The first argument overrides the thread count.
+
+static constexpr size_t FRAME_WIDTH = 3840;
+static constexpr size_t FRAME_HEIGHT = 2160;
+static constexpr size_t SPHERE_COUNT = 10000;
+static constexpr int PASS_COUNT = 8;
+
+int main(int argc, char* argv[])
+{
+	uint32_t thread_count = argc > 1 ? uint32_t(atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+
+	std::mt19937 rng(1337);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> radius(0.5f, 4.0f);
+
+	HittableList world;
+	for (size_t i = 0; i < SPHERE_COUNT; i++)
+	{
+		auto sphere = std::make_shared<BoundingSphere>();
+		bound_sphere_create(*sphere, radius(rng), { position(rng), position(rng), position(rng) - 250.0f });
+
+		hittable_list_add(world, sphere);
+	}
+
+	GeometryScene scene;
+	geometry_scene_create(scene);
+	geometry_scene_set_acceleration(scene, SIMD_WIDTH >= 8 ? AccelerationType::AT_BVH8 : AccelerationType::AT_BVH4);
+	geometry_scene_build(scene, world);
+
+	float viewport_width = 5.0f;
+	float viewport_height = viewport_width * float(FRAME_HEIGHT) / float(FRAME_WIDTH);
+
+	RenderView view;
+	view.center = { 0.0f, 0.0f, 0.0f };
+	view.pixel_delta_u = Vec3f{ viewport_width, 0.0f, 0.0f } / float(FRAME_WIDTH);
+	view.pixel_delta_v = Vec3f{ 0.0f, -viewport_height, 0.0f } / float(FRAME_HEIGHT);
+	view.viewport_upper_left = Vec3f{ -viewport_width / 2.0f, viewport_height / 2.0f, -10.0f };
+
+	size_t pixel_count = FRAME_WIDTH * FRAME_HEIGHT;
+	std::vector<uint8_t> reference(pixel_count * 3);
+
+	printf("%ux%u, %zu spheres, %u threads, %d passes\n", unsigned(FRAME_WIDTH), unsigned(FRAME_HEIGHT), SPHERE_COUNT, thread_count, PASS_COUNT);
+	printf("%-8s %-12s %6s %10s %10s %10s %10s\n", "threads", "buffers", "nodes", "ms/pass", "Mrays/s", "speedup", "image");
+
+	double baseline_ms = 0.0;
+
+	for (bool pin_threads : { false, true })
+	{
+		for (bool first_touch : { false, true })
+		{
+			Renderer renderer;
+			renderer_create(renderer, { thread_count, RENDER_DEFAULT_TILE_SIZE, true, true, RenderOrder::RO_SCANLINE, 0.0f, pin_threads, first_touch });
+
+			// Fresh allocations every time, so no page is placed yet.
+			uint8_t* pixels = (uint8_t*)malloc(pixel_count * 3);
+			RenderTarget target = { pixels, FRAME_WIDTH, FRAME_HEIGHT, FRAME_WIDTH * 3 };
+
+			AccumulationBuffer accumulation;
+			accumulation_buffer_create(accumulation);
+			accumulation_buffer_prepare(accumulation, FRAME_WIDTH, FRAME_HEIGHT, view);
+
+			if (!first_touch)
+			{
+				memset(pixels, 0, pixel_count * 3);
+				memset(accumulation.color, 0, pixel_count * 3 * sizeof(float));
+				memset(accumulation.squares, 0, pixel_count * sizeof(float));
+				memset(accumulation.sample_counts, 0, pixel_count * sizeof(uint32_t));
+			}
+
+			// The first pass places pages and warms the pool; the mean of the
+			// rest counts.
+			double render_ms = 0.0;
+			uint64_t rays = 0;
+			for (int pass = 0; pass <= PASS_COUNT; pass++)
+			{
+				RenderStats stats = renderer_render(renderer, scene, view, target, &accumulation);
+				if (pass)
+				{
+					render_ms += stats.render_ms;
+					rays += stats.traversal.rays;
+				}
+			}
+
+			// Nodes the pinned threads are spread over.
+			char nodes_text[16] = "-";
+			if (thread_pool_is_pinned(renderer.pool))
+			{
+				uint32_t node_count = 0;
+				for (uint32_t i = 0; i < thread_count; i++)
+					node_count = std::max(node_count, thread_pool_get_node(renderer.pool, i) + 1);
+
+				snprintf(nodes_text, sizeof(nodes_text), "%u", node_count);
+			}
+
+			accumulation_buffer_resolve(accumulation, target);
+
+			bool is_baseline = !pin_threads && !first_touch;
+			if (is_baseline)
+			{
+				memcpy(reference.data(), pixels, reference.size());
+				baseline_ms = render_ms;
+			}
+
+			bool match = is_baseline || memcmp(reference.data(), pixels, reference.size()) == 0;
+
+			printf("%-8s %-12s %6s %10.2f %10.2f %10.2f %10s\n", pin_threads ? "pinned" : "free", first_touch ? "first touch" : "serial",
+				nodes_text, render_ms / PASS_COUNT, double(rays) / (render_ms * 1000.0), baseline_ms / render_ms, match ? "match" : "MISMATCH");
+
+			accumulation_buffer_destroy(accumulation);
+			free(pixels);
+
+			renderer_destroy(renderer);
+		}
+	}
+
+	geometry_scene_destroy(scene);
+
+	return 0;
+}
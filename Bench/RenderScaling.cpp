@@ -0,0 +1,100 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <Math/Geometry.hpp>
+#include <Math/BoundingSphere.hpp>
+
+#include <Render/Renderer.hpp>
+
+// Renders one 1920x1080 frame of a sphere field with every thread count from
+// one to the hardware concurrency (first argument overrides the maximum) and
+// reports throughput and speedup over one thread. Every frame must match the
+// single threaded one byte for byte.
+
+static constexpr size_t FRAME_WIDTH = 1920;
+static constexpr size_t FRAME_HEIGHT = 1080;
+static constexpr size_t SPHERE_COUNT = 10000;
+static constexpr int FRAME_COUNT = 3;
+
+int main(int argc, char* argv[])
+{
+	uint32_t max_threads = argc > 1 ? uint32_t(atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+
+	std::mt19937 rng(1337);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> radius(0.5f, 4.0f);
+
+	HittableList world;
+	for (size_t i = 0; i < SPHERE_COUNT; i++)
+	{
+		auto sphere = std::make_shared<BoundingSphere>();
+		bound_sphere_create(*sphere, radius(rng), { position(rng), position(rng), position(rng) - 250.0f });
+
+		hittable_list_add(world, sphere);
+	}
+
+	GeometryScene scene;
+	geometry_scene_create(scene);
+	geometry_scene_set_acceleration(scene, SIMD_WIDTH >= 8 ? AccelerationType::AT_BVH8 : AccelerationType::AT_BVH4);
+	geometry_scene_build(scene, world);
+
+	float viewport_width = 5.0f;
+	float viewport_height = viewport_width * float(FRAME_HEIGHT) / float(FRAME_WIDTH);
+
+	RenderView view;
+	view.center = { 0.0f, 0.0f, 0.0f };
+	view.pixel_delta_u = Vec3f{ viewport_width, 0.0f, 0.0f } / float(FRAME_WIDTH);
+	view.pixel_delta_v = Vec3f{ 0.0f, -viewport_height, 0.0f } / float(FRAME_HEIGHT);
+	view.viewport_upper_left = Vec3f{ -viewport_width / 2.0f, viewport_height / 2.0f, -10.0f };
+
+	std::vector<uint8_t> reference(FRAME_WIDTH * FRAME_HEIGHT * 3);
+	std::vector<uint8_t> pixels(FRAME_WIDTH * FRAME_HEIGHT * 3);
+
+	printf("%ux%u, %zu spheres\n", unsigned(FRAME_WIDTH), unsigned(FRAME_HEIGHT), SPHERE_COUNT);
+	printf("%8s %6s %8s %10s %10s %10s %10s\n", "threads", "tile", "tiles", "ms", "Mrays/s", "speedup", "image");
+
+	for (uint32_t tile_size : { 16u, 32u, 64u })
+	{
+		double single_thread_ms = 0.0;
+
+		for (uint32_t thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+		{
+			Renderer renderer;
+			renderer_create(renderer, { thread_count, tile_size, true, true });
+
+			RenderTarget target = { thread_count == 1 ? reference.data() : pixels.data(), FRAME_WIDTH, FRAME_HEIGHT, FRAME_WIDTH * 3 };
+
+			// The first frame warms caches and the pool; the best of the rest counts.
+			RenderStats best {};
+			for (int frame = 0; frame <= FRAME_COUNT; frame++)
+			{
+				RenderStats stats = renderer_render(renderer, scene, view, target);
+				if (frame == 1 || (frame > 1 && stats.render_ms < best.render_ms))
+					best = stats;
+			}
+
+			renderer_destroy(renderer);
+
+			if (thread_count == 1)
+				single_thread_ms = best.render_ms;
+
+			bool match = thread_count == 1 || memcmp(reference.data(), pixels.data(), pixels.size()) == 0;
+
+			printf("%8u %6u %8u %10.2f %10.2f %10.2f %10s\n", best.thread_count, tile_size, best.tile_count, best.render_ms,
+				double(best.traversal.rays) / (best.render_ms * 1000.0), single_thread_ms / best.render_ms, match ? "match" : "MISMATCH");
+
+			if (thread_count * 2 > max_threads && thread_count != max_threads)
+				thread_count = max_threads / 2;
+		}
+	}
+
+	geometry_scene_destroy(scene);
+
+	return 0;
+}
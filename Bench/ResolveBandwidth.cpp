@@ -0,0 +1,118 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include <Math/SIMD.hpp>
+
+#include <Render/Renderer.hpp>
+#include <Render/Accumulation.hpp>
+
+// Resolves a 3840x2160 accumulation buffer, far larger than the caches, into
+// RGB24 rows packed back to back, RGBA32 rows padded to SIMD_ALIGNMENT as the
+// frame buffer lays them out, and RGBA32 rows deliberately misaligned. Every
+// layout has to hold the same colors, with opaque alpha for RGBA32.
+
+static constexpr size_t FRAME_WIDTH = 3840;
+static constexpr size_t FRAME_HEIGHT = 2160;
+static constexpr int RESOLVE_COUNT = 20;
+
+struct Layout
+{
+	const char* name;
+	RenderFormat format;
+	size_t pitch;
+	size_t offset; // from an aligned allocation
+};
+
+int main()
+{
+	size_t pixel_count = FRAME_WIDTH * FRAME_HEIGHT;
+
+	RenderView view = {};
+
+	AccumulationBuffer accumulation;
+	accumulation_buffer_create(accumulation);
+	accumulation_buffer_prepare(accumulation, FRAME_WIDTH, FRAME_HEIGHT, view);
+
+	// Sums of samples in [0, 1], with a few pixels not sampled yet.
+	std::mt19937 rng(1337);
+	std::uniform_real_distribution<float> channel(0.0f, 1.0f);
+	std::uniform_int_distribution<uint32_t> count(0, 64);
+
+	for (size_t i = 0; i < pixel_count; i++)
+	{
+		uint32_t samples = count(rng);
+		accumulation.sample_counts[i] = samples;
+
+		for (size_t c = 0; c < 3; c++)
+			accumulation.color[i * 3 + c] = float(samples) * channel(rng);
+	}
+
+	Layout layouts[] = {
+		{ "RGB24", RenderFormat::RF_RGB24, FRAME_WIDTH * 3, 0 },
+		{ "RGBA32", RenderFormat::RF_RGBA32, simd_round_up(FRAME_WIDTH * 4, SIMD_ALIGNMENT), 0 },
+		{ "RGBA32 unaligned", RenderFormat::RF_RGBA32, FRAME_WIDTH * 4 + 4, 4 },
+	};
+
+	size_t reference_pitch = FRAME_WIDTH * 3;
+	uint8_t* reference = nullptr;
+
+	printf("%ux%u, %d resolves, SIMD width %zu\n", unsigned(FRAME_WIDTH), unsigned(FRAME_HEIGHT), RESOLVE_COUNT, SIMD_WIDTH);
+	printf("%-18s %8s %10s %10s %10s %10s\n", "layout", "pitch", "ms", "Mpixels/s", "GB/s", "image");
+
+	for (const Layout& layout : layouts)
+	{
+		uint8_t* allocation = (uint8_t*)simd_aligned_alloc(layout.pitch * FRAME_HEIGHT + layout.offset);
+		memset(allocation, 0, layout.pitch * FRAME_HEIGHT + layout.offset);
+
+		RenderTarget target = { allocation + layout.offset, FRAME_WIDTH, FRAME_HEIGHT, layout.pitch, layout.format };
+
+		// One resolve to warm up, then the mean of the rest.
+		accumulation_buffer_resolve(accumulation, target);
+
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < RESOLVE_COUNT; i++)
+			accumulation_buffer_resolve(accumulation, target);
+		auto end = std::chrono::steady_clock::now();
+
+		double resolve_ms = std::chrono::duration<double, std::milli>(end - start).count() / RESOLVE_COUNT;
+
+		// Float sums and counts read plus pixels written.
+		size_t pixel_size = render_target_get_pixel_size(target);
+		double bytes = double(pixel_count) * double(3 * sizeof(float) + sizeof(uint32_t) + pixel_size);
+
+		bool match = true;
+		if (!reference)
+		{
+			reference = (uint8_t*)malloc(reference_pitch * FRAME_HEIGHT);
+			for (size_t y = 0; y < FRAME_HEIGHT; y++)
+				for (size_t x = 0; x < FRAME_WIDTH; x++)
+					memcpy(reference + y * reference_pitch + x * 3, target.pixels + y * target.pitch + x * pixel_size, 3);
+		}
+		else
+		{
+			for (size_t y = 0; y < FRAME_HEIGHT && match; y++)
+			{
+				for (size_t x = 0; x < FRAME_WIDTH && match; x++)
+				{
+					const uint8_t* pixel = target.pixels + y * target.pitch + x * pixel_size;
+
+					match = memcmp(reference + y * reference_pitch + x * 3, pixel, 3) == 0 &&
+						(pixel_size == 3 || pixel[3] == 255);
+				}
+			}
+		}
+
+		printf("%-18s %8zu %10.2f %10.1f %10.2f %10s\n", layout.name, layout.pitch, resolve_ms,
+			double(pixel_count) / (resolve_ms * 1000.0), bytes / (resolve_ms * 1.0e6), match ? "match" : "MISMATCH");
+
+		simd_aligned_free(allocation);
+	}
+
+	free(reference);
+	accumulation_buffer_destroy(accumulation);
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+
+#include <Math/SphereSoA.hpp>
+#include <Math/BoundingSphere.hpp>
+
+// Compares one-sphere-per-call bounding_sphere_intersect against the SphereSoA
+// kernel by tracing the same random rays through every sphere of a flat scene.
+
+static constexpr size_t RAY_COUNT = 4096;
+
+int main(int argc, char* argv[])
+{
+	printf("SIMD width: %zu\n", SIMD_WIDTH);
+	printf("%10s %16s %16s %10s %10s\n", "spheres", "scalar (ns/test)", "soa (ns/test)", "speedup", "mismatch");
+
+	for (size_t sphere_count = 8; sphere_count <= 65536; sphere_count *= 8)
+	{
+		std::mt19937 rng(1337);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> radius(0.5f, 4.0f);
+
+		std::vector<BoundingSphere> spheres(sphere_count);
+
+		SphereSoA soa;
+		sphere_soa_create(soa, sphere_count);
+
+		for (size_t i = 0; i < sphere_count; i++)
+		{
+			Vec3f center = { position(rng), position(rng), position(rng) - 200.0f };
+			float r = radius(rng);
+
+			bound_sphere_create(spheres[i], r, center);
+			sphere_soa_add(soa, r, center);
+		}
+
+		std::vector<Ray> rays(RAY_COUNT);
+		for (auto& ray : rays)
+		{
+			Vec3f direction = { position(rng), position(rng), -200.0f };
+			ray = { { 0.0f, 0.0f, 0.0f }, vector_normalize(direction) };
+		}
+
+		std::vector<uint32_t> scalar_hits(RAY_COUNT);
+		std::vector<uint32_t> soa_hits(RAY_COUNT);
+
+		auto scalar_start = std::chrono::steady_clock::now();
+		for (size_t r = 0; r < RAY_COUNT; r++)
+		{
+			float closest = constants_infinity<float>();
+			uint32_t closest_index = UINT32_MAX;
+
+			for (size_t i = 0; i < sphere_count; i++)
+			{
+				float t = bounding_sphere_intersect(spheres[i], rays[r]);
+				if (t > 0.001f && t < closest)
+				{
+					closest = t;
+					closest_index = uint32_t(i);
+				}
+			}
+
+			scalar_hits[r] = closest_index;
+		}
+		auto scalar_end = std::chrono::steady_clock::now();
+
+		auto soa_start = std::chrono::steady_clock::now();
+		for (size_t r = 0; r < RAY_COUNT; r++)
+		{
+			SphereSoAHit hit = sphere_soa_intersect(soa, rays[r], 0.001f, constants_infinity<float>());
+			soa_hits[r] = hit.hit ? hit.index : UINT32_MAX;
+		}
+		auto soa_end = std::chrono::steady_clock::now();
+
+		size_t mismatch = 0;
+		for (size_t r = 0; r < RAY_COUNT; r++)
+			if (scalar_hits[r] != soa_hits[r])
+				mismatch++;
+
+		double test_count = double(RAY_COUNT * sphere_count);
+		double scalar_ns = std::chrono::duration<double, std::nano>(scalar_end - scalar_start).count() / test_count;
+		double soa_ns = std::chrono::duration<double, std::nano>(soa_end - soa_start).count() / test_count;
+
+		printf("%10zu %16.3f %16.3f %9.2fx %10zu\n",
+			sphere_count, scalar_ns, soa_ns, scalar_ns / soa_ns, mismatch);
+
+		sphere_soa_destroy(soa);
+	}
+
+	return 0;
+}
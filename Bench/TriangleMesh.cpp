@@ -0,0 +1,134 @@
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+
+#include <Math/TriangleMesh.hpp>
+
+// Builds tessellated spheres of increasing density and reports mesh build time,
+// primary ray throughput and watertightness. Leak rays start at the centre of
+// the closed mesh and aim straight at its vertices and edge midpoints, where a
+// non-watertight test lets rays slip between neighbouring triangles.
+
+static constexpr size_t RAY_GRID_SIZE = 512;
+static constexpr size_t LEAK_RAY_COUNT = 1 << 18;
+
+static void
+_tessellate_sphere(std::vector<Vec3f>& positions, std::vector<uint32_t>& indices, size_t rings, size_t segments, float radius)
+{
+	const float pi = 3.14159265358979f;
+
+	positions.clear();
+	indices.clear();
+
+	positions.push_back({ 0.0f, radius, 0.0f });
+	for (size_t ring = 1; ring < rings; ring++)
+	{
+		float theta = pi * float(ring) / float(rings);
+		for (size_t segment = 0; segment < segments; segment++)
+		{
+			float phi = 2.0f * pi * float(segment) / float(segments);
+			positions.push_back({ radius * std::sin(theta) * std::cos(phi), radius * std::cos(theta), radius * std::sin(theta) * std::sin(phi) });
+		}
+	}
+	positions.push_back({ 0.0f, -radius, 0.0f });
+
+	uint32_t south_pole = uint32_t(positions.size() - 1);
+	auto vertex = [segments](size_t ring, size_t segment) -> uint32_t {
+		return uint32_t(1 + (ring - 1) * segments + segment % segments);
+	};
+
+	for (size_t segment = 0; segment < segments; segment++)
+	{
+		indices.insert(indices.end(), { 0, vertex(1, segment + 1), vertex(1, segment) });
+		indices.insert(indices.end(), { south_pole, vertex(rings - 1, segment), vertex(rings - 1, segment + 1) });
+	}
+
+	for (size_t ring = 1; ring < rings - 1; ring++)
+	{
+		for (size_t segment = 0; segment < segments; segment++)
+		{
+			uint32_t a = vertex(ring, segment), b = vertex(ring, segment + 1);
+			uint32_t c = vertex(ring + 1, segment), d = vertex(ring + 1, segment + 1);
+
+			indices.insert(indices.end(), { a, b, c });
+			indices.insert(indices.end(), { b, d, c });
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	printf("SIMD width: %zu, mesh BVH width: %d\n", SIMD_WIDTH, SIMD_WIDTH >= 8 ? 8 : 4);
+	printf("%10s %12s %10s %12s %12s %10s\n",
+		"triangles", "build (ms)", "nodes", "Mrays/s", "nodes/ray", "leaks");
+
+	for (size_t segments : { 100, 316, 1000 })
+	{
+		size_t rings = segments;
+
+		std::vector<Vec3f> positions;
+		std::vector<uint32_t> indices;
+		_tessellate_sphere(positions, indices, rings, segments, 10.0f);
+
+		TriangleMesh mesh;
+
+		auto build_start = std::chrono::steady_clock::now();
+		triangle_mesh_create(mesh, positions.data(), positions.size(), indices.data(), indices.size());
+		auto build_end = std::chrono::steady_clock::now();
+
+		TraversalStats stats {};
+		size_t hit_count = 0;
+
+		auto start = std::chrono::steady_clock::now();
+		for (size_t y = 0; y < RAY_GRID_SIZE; y++)
+		{
+			for (size_t x = 0; x < RAY_GRID_SIZE; x++)
+			{
+				Vec3f direction = {
+					((float(x) / RAY_GRID_SIZE) - 0.5f) * 0.5f,
+					((float(y) / RAY_GRID_SIZE) - 0.5f) * 0.5f,
+					-1.0f
+				};
+
+				Ray ray { { 0.0f, 0.0f, 30.0f }, vector_normalize(direction) };
+
+				if (triangle_mesh_intersect(mesh, ray, 0.001f, constants_infinity<float>(), &stats).hit)
+					hit_count++;
+			}
+		}
+		auto end = std::chrono::steady_clock::now();
+
+		std::mt19937 rng(1337);
+		std::uniform_int_distribution<size_t> triangle(0, triangle_mesh_get_triangle_count(mesh) - 1);
+		std::uniform_int_distribution<int> corner(0, 2);
+
+		size_t leak_count = 0;
+		for (size_t i = 0; i < LEAK_RAY_COUNT; i++)
+		{
+			size_t index = triangle(rng) * 3;
+
+			const Vec3f& a = positions[indices[index + corner(rng)]];
+			const Vec3f& b = positions[indices[index + corner(rng)]];
+
+			Vec3f target = (a + b) * 0.5f;
+			Ray ray { { 0.0f, 0.0f, 0.0f }, vector_normalize(target) };
+
+			if (!triangle_mesh_intersect(mesh, ray, 0.0f, constants_infinity<float>()).hit)
+				leak_count++;
+		}
+
+		double build_ms = std::chrono::duration<double, std::milli>(build_end - build_start).count();
+		double seconds = std::chrono::duration<double>(end - start).count();
+
+		printf("%10zu %12.2f %10zu %12.2f %12.1f %10zu\n",
+			triangle_mesh_get_triangle_count(mesh), build_ms, mesh.wide_bvh.nodes.size(),
+			double(stats.rays) / seconds / 1e6,
+			double(stats.nodes_visited) / double(stats.rays),
+			leak_count);
+
+		triangle_mesh_destroy(mesh);
+	}
+
+	return 0;
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <memory>
+
+#include <Math/Geometry.hpp>
+#include <Math/Hittable.hpp>
+#include <Math/BoundingSphere.hpp>
+
+// Traces the same primary rays through the binary, 4-wide and 8-wide
+// hierarchies of one scene and reports throughput and traversal steps.
+
+static constexpr size_t RAY_GRID_SIZE = 512;
+
+static const char* ACCELERATION_NAMES[] = { "BVH2", "BVH4", "BVH8" };
+
+int main(int argc, char* argv[])
+{
+	printf("SIMD width: %zu\n", SIMD_WIDTH);
+	printf("%10s %6s %10s %12s %12s %12s %10s\n",
+		"spheres", "accel", "nodes", "Mrays/s", "nodes/ray", "leaves/ray", "hits");
+
+	for (size_t sphere_count = 1000; sphere_count <= 1000000; sphere_count *= 10)
+	{
+		std::mt19937 rng(1337);
+
+		float extent = 100.0f * std::cbrt(float(sphere_count) / 1000.0f);
+		std::uniform_real_distribution<float> position(-extent, extent);
+
+		HittableList world;
+		for (size_t i = 0; i < sphere_count; i++)
+		{
+			auto sphere = std::make_shared<BoundingSphere>();
+			bound_sphere_create(*sphere, 2.0f, { position(rng), position(rng), position(rng) - 2.0f * extent });
+
+			hittable_list_add(world, sphere);
+		}
+
+		GeometryScene scene;
+		geometry_scene_create(scene);
+		geometry_scene_build(scene, world);
+
+		for (int acceleration = 0; acceleration < 3; acceleration++)
+		{
+			geometry_scene_set_acceleration(scene, AccelerationType(acceleration));
+
+			size_t node_count = scene.bvh.nodes.size();
+			if (scene.acceleration == AccelerationType::AT_BVH4)
+				node_count = scene.bvh4.nodes.size();
+			if (scene.acceleration == AccelerationType::AT_BVH8)
+				node_count = scene.bvh8.nodes.size();
+
+			TraversalStats stats {};
+			size_t hit_count = 0;
+
+			auto start = std::chrono::steady_clock::now();
+			for (size_t y = 0; y < RAY_GRID_SIZE; y++)
+			{
+				for (size_t x = 0; x < RAY_GRID_SIZE; x++)
+				{
+					Vec3f direction = {
+						(float(x) / RAY_GRID_SIZE) - 0.5f,
+						(float(y) / RAY_GRID_SIZE) - 0.5f,
+						-1.0f
+					};
+
+					Ray ray { { 0.0f, 0.0f, 0.0f }, vector_normalize(direction) };
+
+					if (geometry_scene_intersect(scene, ray, 0.001f, constants_infinity<float>(), &stats).hit)
+						hit_count++;
+				}
+			}
+			auto end = std::chrono::steady_clock::now();
+
+			double seconds = std::chrono::duration<double>(end - start).count();
+
+			printf("%10zu %6s %10zu %12.2f %12.1f %12.1f %10zu\n",
+				sphere_count, ACCELERATION_NAMES[acceleration], node_count,
+				double(stats.rays) / seconds / 1e6,
+				double(stats.nodes_visited) / double(stats.rays),
+				double(stats.leaves_visited) / double(stats.rays),
+				hit_count);
+		}
+
+		geometry_scene_destroy(scene);
+	}
+
+	return 0;
+}
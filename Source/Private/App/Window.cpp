@@ -1,14 +1,26 @@
 #include <App/Window.h>
 
 #include <cstring>
+#include <algorithm>
 #include <assert.h>
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_events.h>
 
+#include <Math/SIMD.hpp>
+
 #include <IMGUI/backends/imgui_impl_sdl3.h>
 #include <IMGUI/backends/imgui_impl_sdlrenderer3.h>
 
+// Three buffers change hands by index: the renderer draws into back, the
+// presenter reads front, and ready holds the latest finished frame, with
+// FRAMEBUFFER_NEW set until the presenter took it. Publishing and taking are
+// a single exchange each, so neither side ever waits for the other.
+constexpr uint32_t FRAMEBUFFER_NEW = 4;
+
+// Changes are tracked in bitmaps of square tiles, one bit each, row by row.
+constexpr size_t FRAMEBUFFER_TILE_SIZE = 32;
+
 struct FrameBuffer
 {
 	size_t pitch;
@@ -16,7 +28,36 @@ struct FrameBuffer
 
 	FrameBufferFormat format;
 
-	void *front_buffer, *back_buffer;
+	void* buffers[3];     // rows start on SIMD_ALIGNMENT
+	void* allocations[3];
+
+	uint32_t back;   // renderer only
+	uint32_t latest; // renderer only; last published, in ready or front
+	uint32_t front;  // presenter only
+	std::atomic<uint32_t> ready;
+
+	size_t tiles_x, tiles_y;
+	size_t tile_words;
+
+	// Rects the render workers finished, which the worker folds into stale
+	// before it syncs or swaps.
+	TileQueue finished_tiles;
+
+	// Renderer only, kept for every buffer: tiles it may differ in from the
+	// latest frame.
+	uint64_t* stale[3];
+
+	// Tiles the texture may differ in from the latest frame. The worker ORs
+	// in every frame's changes once it is published, and the presenter takes
+	// them word by word.
+	std::atomic<uint64_t>* texture_stale;
+
+	// Presenter only: the tiles being uploaded, and the rects still open from
+	// the rows above, by the column they start at, as their end column past
+	// the last and their first row.
+	uint64_t* uploads;
+	uint32_t* upload_right;
+	uint32_t* upload_top;
 };
 
 struct ApplicationWindow
@@ -27,6 +68,10 @@ struct ApplicationWindow
 
 	FrameBuffer* frame_buffer;
 
+	// The worker pushes a frame_event for every published frame, to wake the
+	// UI loop.
+	uint32_t frame_event;
+
 	ApplicationCallback on_create_fn;
 	ApplicationCallback on_update_fn;
 	ApplicationCallback on_render_fn;
@@ -35,6 +80,61 @@ struct ApplicationWindow
 	ApplicationResizeCallback on_resize_fn;
 };
 
+ApplicationState g_state;
+
+static void
+_tiles_add(const FrameBuffer* self, uint64_t* tiles, size_t x, size_t y, size_t width, size_t height)
+{
+	if (!width || !height || x >= self->width || y >= self->height)
+		return;
+
+	size_t right = (std::min(x + width, self->width) - 1) / FRAMEBUFFER_TILE_SIZE;
+	size_t bottom = (std::min(y + height, self->height) - 1) / FRAMEBUFFER_TILE_SIZE;
+
+	for (size_t tile_y = y / FRAMEBUFFER_TILE_SIZE; tile_y <= bottom; tile_y++)
+	{
+		for (size_t tile_x = x / FRAMEBUFFER_TILE_SIZE; tile_x <= right; tile_x++)
+		{
+			size_t tile = tile_y * self->tiles_x + tile_x;
+			tiles[tile / 64] |= uint64_t(1) << (tile % 64);
+		}
+	}
+}
+
+static bool
+_tiles_test(const uint64_t* tiles, size_t tile)
+{
+	return (tiles[tile / 64] >> (tile % 64)) & 1;
+}
+
+// Folds the rects the workers finished into the back buffer's stale tiles,
+// or all of them if some were dropped.
+static void
+_drain_finished_tiles(FrameBuffer* self)
+{
+	uint64_t* stale = self->stale[self->back];
+
+	size_t x, y, width, height;
+	while (tile_queue_pop(self->finished_tiles, x, y, width, height))
+		_tiles_add(self, stale, x, y, width, height);
+
+	if (tile_queue_take_dropped(self->finished_tiles))
+		_tiles_add(self, stale, 0, 0, self->width, self->height);
+}
+
+void
+application_state_mark_dirty(ApplicationState& self)
+{
+	if (!self.has_input)
+	{
+		self.has_input = true;
+		self.input_time = std::chrono::steady_clock::now();
+	}
+
+	self.is_dirty = true;
+	self.is_cancelled.store(true, std::memory_order_relaxed);
+}
+
 void
 _render_worker_thread(ApplicationWindow* self)
 {
@@ -43,21 +143,41 @@ _render_worker_thread(ApplicationWindow* self)
 		std::unique_lock<std::mutex> lock(g_state.mtx);
 
 		g_state.cv.wait(lock, []() {
-			return g_state.is_dirty || !g_state.is_running;
+			return g_state.is_dirty || g_state.is_refining || !g_state.is_running;
 		});
 
 		if (!g_state.is_running)
 			break;
 
 		g_state.is_dirty = false;
+		g_state.is_cancelled.store(false, std::memory_order_relaxed);
+
+		g_state.frame_has_input = g_state.has_input;
+		g_state.frame_input_time = g_state.input_time;
+		g_state.has_input = false;
+
+		g_state.is_rendering = true;
 		lock.unlock();
 
 		if (self->on_render_fn)
 			self->on_render_fn(self);
 
+		// Newer input arrived while rendering; whatever was drawn is stale.
+		if (!g_state.is_cancelled.load(std::memory_order_relaxed))
+		{
+			framebuffer_swap(self->frame_buffer);
+
+			SDL_Event event;
+			SDL_zero(event);
+			event.type = self->frame_event;
+			SDL_PushEvent(&event);
+		}
+
 		lock.lock();
-		framebuffer_swap(self->frame_buffer);
+		g_state.is_rendering = false;
 		lock.unlock();
+
+		g_state.frame_cv.notify_all();
 	}
 }
 
@@ -85,26 +205,68 @@ framebuffer_create(FrameBuffer* self, size_t width, size_t height, FrameBufferFo
 	self->height = height;
 	self->format = format;
 
+	// RGBA32 rows are whole vectors of pixels, for aligned stores.
 	self->pitch = self->width * framebuffer_get_bps(self);
+	if (format == FrameBufferFormat::FMT_RGBA32)
+		self->pitch = simd_round_up(self->pitch, SIMD_ALIGNMENT);
+
+	size_t buffer_size = self->pitch * self->height;
+
+	self->tiles_x = (width + FRAMEBUFFER_TILE_SIZE - 1) / FRAMEBUFFER_TILE_SIZE;
+	self->tiles_y = (height + FRAMEBUFFER_TILE_SIZE - 1) / FRAMEBUFFER_TILE_SIZE;
+	self->tile_words = (self->tiles_x * self->tiles_y + 63) / 64;
+
+	// Left untouched for the renderer to place, which calloc does and
+	// aligned allocations do not promise.
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		self->allocations[i] = calloc(buffer_size + SIMD_ALIGNMENT, 1);
+		self->buffers[i] = (void*)simd_round_up(uintptr_t(self->allocations[i]), SIMD_ALIGNMENT);
+		self->stale[i] = (uint64_t*)calloc(self->tile_words, sizeof(uint64_t));
+	}
 
-	size_t buffer_size = self->width * self->height * framebuffer_get_bps(self);
+	// A new texture needs all of the frame.
+	self->texture_stale = new std::atomic<uint64_t>[self->tile_words];
+	for (size_t i = 0; i < self->tile_words; i++)
+		self->texture_stale[i].store(~uint64_t(0), std::memory_order_relaxed);
 
-	self->front_buffer = malloc(buffer_size);
-	memset(self->front_buffer, 0, buffer_size);
+	self->uploads = (uint64_t*)calloc(self->tile_words, sizeof(uint64_t));
+	self->upload_right = (uint32_t*)calloc(self->tiles_x, sizeof(uint32_t));
+	self->upload_top = (uint32_t*)calloc(self->tiles_x, sizeof(uint32_t));
 
-	self->back_buffer = malloc(buffer_size);
-	memset(self->back_buffer, 0, buffer_size);
+	// Room for every tile of a frame down to 8 pixel tiles; past that the
+	// whole frame counts as changed.
+	tile_queue_create(self->finished_tiles, (width / 8 + 1) * (height / 8 + 1));
+
+	self->back = 0;
+	self->latest = self->ready = 1;
+	self->front = 2;
 }
 void
 framebuffer_destroy(FrameBuffer* self)
 {
 	assert(self);
 
-	free(self->front_buffer);
-	free(self->back_buffer);
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		free(self->allocations[i]);
+		free(self->stale[i]);
+
+		self->buffers[i] = self->allocations[i] = nullptr;
+		self->stale[i] = nullptr;
+	}
+
+	delete[] self->texture_stale;
+	self->texture_stale = nullptr;
 
-	self->front_buffer = nullptr;
-	self->back_buffer = nullptr;
+	free(self->uploads);
+	free(self->upload_right);
+	free(self->upload_top);
+
+	self->uploads = nullptr;
+	self->upload_right = self->upload_top = nullptr;
+
+	tile_queue_destroy(self->finished_tiles);
 }
 
 size_t
@@ -146,34 +308,108 @@ framebuffer_swap(FrameBuffer* self)
 {
 	assert(self);
 
-	void* temp = self->front_buffer;
-	self->front_buffer = self->back_buffer;
-	self->back_buffer = temp;
+	_drain_finished_tiles(self);
+
+	// Other buffers now lag wherever the new frame differs from the last.
+	uint64_t* changed = self->stale[self->back];
+	for (uint32_t i = 0; i < 3; i++)
+		if (i != self->back)
+			for (size_t word = 0; word < self->tile_words; word++)
+				self->stale[i][word] |= changed[word];
+
+	self->latest = self->back;
+	self->back = self->ready.exchange(self->back | FRAMEBUFFER_NEW, std::memory_order_acq_rel) & ~FRAMEBUFFER_NEW;
+
+	// Only once the frame is out, so the presenter never takes these tiles
+	// before it can take the frame they are from.
+	for (size_t word = 0; word < self->tile_words; word++)
+	{
+		if (changed[word])
+			self->texture_stale[word].fetch_or(changed[word], std::memory_order_release);
+
+		changed[word] = 0;
+	}
+}
+void
+framebuffer_resize(FrameBuffer* self, size_t width, size_t height)
+{
+	framebuffer_destroy(self);
+	framebuffer_create(self, width, height, self->format);
+}
+
+bool
+framebuffer_acquire_front(FrameBuffer* self)
+{
+	assert(self);
+
+	if (!(self->ready.load(std::memory_order_relaxed) & FRAMEBUFFER_NEW))
+		return false;
+
+	self->front = self->ready.exchange(self->front, std::memory_order_acq_rel) & ~FRAMEBUFFER_NEW;
+	return true;
+}
+const void*
+framebuffer_get_front_buffer(const FrameBuffer* self)
+{
+	assert(self);
+
+	return self->buffers[self->front];
+}
+
+TileQueue*
+framebuffer_get_finished_tiles(FrameBuffer* self)
+{
+	assert(self);
+
+	return &self->finished_tiles;
 }
+
+FrameBufferView
+framebuffer_get_back_buffer(FrameBuffer* self)
+{
+	assert(self);
+
+	return { (uint8_t*)self->buffers[self->back], self->width, self->height, self->pitch, self->format };
+}
+
 void
-framebuffer_update(FrameBuffer* self, void* buffer)
+framebuffer_mark_drawn(FrameBuffer* self, size_t x, size_t y, size_t width, size_t height)
 {
 	assert(self);
 
-	memcpy(self->back_buffer, buffer, self->pitch * self->height);
+	_tiles_add(self, self->stale[self->back], x, y, width, height);
 }
 void
-framebuffer_resize(FrameBuffer* self, size_t width, size_t height)
+framebuffer_sync_back_buffer(FrameBuffer* self)
 {
-	framebuffer_destroy(self);
+	assert(self);
 
-	self->width = width;
-	self->height = height;
+	_drain_finished_tiles(self);
 
-	self->pitch = self->width * framebuffer_get_bps(self);
+	// The latest frame may be on screen at the same time; both only read it.
+	const uint8_t* source = (const uint8_t*)self->buffers[self->latest];
+	uint8_t* destination = (uint8_t*)self->buffers[self->back];
+
+	uint64_t* stale = self->stale[self->back];
+	size_t bps = framebuffer_get_bps(self);
 
-	size_t buffer_size = self->width * self->height * framebuffer_get_bps(self);
+	for (size_t tile = 0; tile < self->tiles_x * self->tiles_y; tile++)
+	{
+		if (!_tiles_test(stale, tile))
+			continue;
+
+		size_t x = (tile % self->tiles_x) * FRAMEBUFFER_TILE_SIZE;
+		size_t y = (tile / self->tiles_x) * FRAMEBUFFER_TILE_SIZE;
 
-	self->front_buffer = malloc(buffer_size);
-	memset(self->front_buffer, 0, buffer_size);
+		size_t offset = x * bps;
+		size_t size = (std::min(x + FRAMEBUFFER_TILE_SIZE, self->width) - x) * bps;
+		size_t bottom = std::min(y + FRAMEBUFFER_TILE_SIZE, self->height);
 
-	self->back_buffer = malloc(buffer_size);
-	memset(self->back_buffer, 0, buffer_size);
+		for (; y < bottom; y++)
+			memcpy(destination + y * self->pitch + offset, source + y * self->pitch + offset, size);
+	}
+
+	memset(stale, 0, self->tile_words * sizeof(uint64_t));
 }
 
 
@@ -198,8 +434,20 @@ application_window_get_framebuffer(ApplicationWindow* self)
 	return self->frame_buffer;
 }
 
+// Texture format with the frame buffer's byte order.
+static SDL_PixelFormat
+_get_pixel_format(FrameBufferFormat format)
+{
+	switch (format)
+	{
+		case FrameBufferFormat::FMT_RGB24:  return SDL_PIXELFORMAT_RGB24;
+		case FrameBufferFormat::FMT_RGBA32: return SDL_PIXELFORMAT_RGBA32;
+		default: return SDL_PIXELFORMAT_UNKNOWN;
+	}
+}
+
 void
-application_window_create(ApplicationWindow* self, const char* title, size_t width, size_t height)
+application_window_create(ApplicationWindow* self, const char* title, size_t width, size_t height, FrameBufferFormat format)
 {
 	assert(self);
 
@@ -247,7 +495,7 @@ application_window_create(ApplicationWindow* self, const char* title, size_t wid
 	}
 
 	self->sdl_texture = SDL_CreateTexture(self->sdl_renderer,
-		SDL_PIXELFORMAT_RGB24, SDL_TEXTUREACCESS_TARGET, width, height);
+		_get_pixel_format(format), SDL_TEXTUREACCESS_STREAMING, width, height);
 	if (!self->sdl_texture)
 	{
 		SDL_Log("Failed to create texture: %s", SDL_GetError());
@@ -255,7 +503,9 @@ application_window_create(ApplicationWindow* self, const char* title, size_t wid
 	}
 
 	self->frame_buffer = framebuffer_new();
-	framebuffer_create(self->frame_buffer, width, height, FrameBufferFormat::FMT_RGB24);
+	framebuffer_create(self->frame_buffer, width, height, format);
+
+	self->frame_event = SDL_RegisterEvents(1);
 
 	g_state.is_running = true;
 
@@ -338,14 +588,121 @@ application_window_on_resize(ApplicationWindow* self, ApplicationResizeCallback
 	self->on_resize_fn = callback_fn;
 }
 
+// Copies a rect of tiles of the front buffer into the streaming texture,
+// row by row as the texture's pitch may differ.
+static void
+_upload_rect(ApplicationWindow* self, size_t tile_x, size_t tile_y, size_t tile_right, size_t tile_bottom)
+{
+	const FrameBuffer* frame_buffer = self->frame_buffer;
+
+	size_t x = tile_x * FRAMEBUFFER_TILE_SIZE;
+	size_t y = tile_y * FRAMEBUFFER_TILE_SIZE;
+	size_t width = std::min(tile_right * FRAMEBUFFER_TILE_SIZE, frame_buffer->width) - x;
+	size_t height = std::min(tile_bottom * FRAMEBUFFER_TILE_SIZE, frame_buffer->height) - y;
+
+	SDL_Rect rect = { int(x), int(y), int(width), int(height) };
+
+	void* pixels;
+	int pitch;
+
+	if (!SDL_LockTexture(self->sdl_texture, &rect, &pixels, &pitch))
+		return;
+
+	size_t bps = framebuffer_get_bps(frame_buffer);
+	const uint8_t* source = (const uint8_t*)framebuffer_get_front_buffer(frame_buffer) +
+		y * frame_buffer->pitch + x * bps;
+
+	for (size_t row = 0; row < height; row++)
+		memcpy((uint8_t*)pixels + row * size_t(pitch), source + row * frame_buffer->pitch, width * bps);
+
+	SDL_UnlockTexture(self->sdl_texture);
+}
+
+// Takes the latest frame and uploads the tiles the texture lags in. A run of
+// tiles on a row makes a rect, which grows down for as long as the rows below
+// have the very same run.
+static void
+_upload_frame(ApplicationWindow* self)
+{
+	FrameBuffer* frame_buffer = self->frame_buffer;
+
+	// Tiles are taken before the frame, so tiles of a frame published in
+	// between are uploaded once more next time rather than never.
+	bool has_uploads = false;
+	for (size_t word = 0; word < frame_buffer->tile_words; word++)
+	{
+		frame_buffer->uploads[word] = frame_buffer->texture_stale[word].exchange(0, std::memory_order_acquire);
+		has_uploads |= frame_buffer->uploads[word] != 0;
+	}
+
+	framebuffer_acquire_front(frame_buffer);
+
+	if (!has_uploads)
+		return;
+
+	size_t tiles_x = frame_buffer->tiles_x;
+	uint32_t* open_right = frame_buffer->upload_right;
+	uint32_t* open_top = frame_buffer->upload_top;
+
+	auto close = [self, open_right, open_top](size_t x, size_t y) -> void {
+		if (open_right[x])
+			_upload_rect(self, x, open_top[x], open_right[x], y);
+
+		open_right[x] = 0;
+	};
+
+	// The row past the last one is empty and closes what is still open.
+	for (size_t y = 0; y <= frame_buffer->tiles_y; y++)
+	{
+		for (size_t x = 0; x < tiles_x;)
+		{
+			size_t right = x;
+			while (y < frame_buffer->tiles_y && right < tiles_x && _tiles_test(frame_buffer->uploads, y * tiles_x + right))
+				right++;
+
+			if (right == x)
+			{
+				close(x++, y);
+				continue;
+			}
+
+			// Only a rect above with exactly this run carries on.
+			for (size_t column = x; column < right; column++)
+				if (column != x || open_right[column] != right)
+					close(column, y);
+
+			if (!open_right[x])
+			{
+				open_right[x] = uint32_t(right);
+				open_top[x] = uint32_t(y);
+			}
+
+			x = right;
+		}
+	}
+}
+
 void
 application_window_handle_loop(ApplicationWindow* self)
 {
+	// ImGui takes a few frames to settle after input, such as hover states
+	// following the mouse; after that the loop sleeps until the next event.
+	constexpr uint32_t SETTLE_FRAME_COUNT = 3;
+	uint32_t settle_frames = SETTLE_FRAME_COUNT;
+
 	while (g_state.is_running)
 	{
 		SDL_Event event;
-		while (SDL_PollEvent(&event))
+		bool has_event = settle_frames ? SDL_PollEvent(&event) : SDL_WaitEvent(&event);
+
+		for (; has_event; has_event = SDL_PollEvent(&event))
 		{
+			// New frames only need an upload.
+			if (event.type == self->frame_event)
+				continue;
+
+			settle_frames = SETTLE_FRAME_COUNT;
+
 			ImGui_ImplSDL3_ProcessEvent(&event);
 
 			if (event.type == SDL_EVENT_QUIT) {
@@ -362,16 +719,26 @@ application_window_handle_loop(ApplicationWindow* self)
 				int new_width = event.window.data1;
 				int new_height = event.window.data2;
 
+				// The worker draws into the back buffer outside the lock; the
+				// frame in flight is cancelled and waited out.
 				{
-					std::lock_guard<std::mutex> lock(g_state.mtx);
+					std::unique_lock<std::mutex> lock(g_state.mtx);
+					application_state_mark_dirty(g_state);
+
+					g_state.frame_cv.wait(lock, []() {
+						return !g_state.is_rendering;
+					});
+
 					framebuffer_resize(self->frame_buffer, new_width, new_height);
 				}
 
+				g_state.cv.notify_one();
+
 				if (self->sdl_texture)
 					SDL_DestroyTexture(self->sdl_texture);
 
 				self->sdl_texture = SDL_CreateTexture(self->sdl_renderer,
-					SDL_PIXELFORMAT_RGB24, SDL_TEXTUREACCESS_TARGET, new_width, new_height);
+					_get_pixel_format(self->frame_buffer->format), SDL_TEXTUREACCESS_STREAMING, new_width, new_height);
 				if (!self->sdl_texture)
 				{
 					SDL_Log("Failed to recreate texture after resize: %s", SDL_GetError());
@@ -391,11 +758,11 @@ application_window_handle_loop(ApplicationWindow* self)
 		{
 			SDL_RenderClear(self->sdl_renderer);
 
+			// The front buffer is ours until the next acquire. Only tiles
+			// that changed since the last upload go up again.
 			{
-				std::lock_guard<std::mutex> lock(g_state.mtx);
+				_upload_frame(self);
 
-				SDL_UpdateTexture(self->sdl_texture,
-					NULL, self->frame_buffer->front_buffer, self->frame_buffer->pitch);
 				SDL_RenderTexture(self->sdl_renderer,
 					self->sdl_texture, NULL, NULL);
 			}
@@ -414,5 +781,8 @@ application_window_handle_loop(ApplicationWindow* self)
 
 			SDL_RenderPresent(self->sdl_renderer);
 		}
+
+		if (settle_frames)
+			settle_frames--;
 	}
 }
\ No newline at end of file
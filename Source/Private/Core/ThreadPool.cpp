@@ -0,0 +1,263 @@
+#include <Core/ThreadPool.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+static void
+_worker_thread(ThreadPool* self, uint32_t thread_index)
+{
+	uint64_t generation = 0;
+
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(self->mtx);
+
+		self->start_cv.wait(lock, [self, generation]() {
+			return self->job_generation != generation || !self->is_running;
+		});
+
+		if (!self->is_running)
+			break;
+
+		generation = self->job_generation;
+		const ThreadPoolJob* job = self->job;
+		lock.unlock();
+
+		(*job)(thread_index);
+
+		lock.lock();
+		if (--self->busy_count == 0)
+			self->done_cv.notify_one();
+	}
+}
+
+void
+thread_pool_create(ThreadPool& self, uint32_t thread_count)
+{
+	if (!thread_count)
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+	self.job = nullptr;
+	self.job_generation = 0;
+	self.busy_count = 0;
+	self.is_running = true;
+
+	self.threads.reserve(thread_count - 1);
+	for (uint32_t i = 1; i < thread_count; i++)
+		self.threads.emplace_back(_worker_thread, &self, i);
+}
+void
+thread_pool_destroy(ThreadPool& self)
+{
+	{
+		std::lock_guard<std::mutex> lock(self.mtx);
+		self.is_running = false;
+	}
+
+	self.start_cv.notify_all();
+
+	for (std::thread& thread : self.threads)
+		thread.join();
+
+	self.threads.clear();
+
+	self.cpus.clear();
+	self.nodes.clear();
+}
+
+uint32_t
+thread_pool_get_thread_count(const ThreadPool& self)
+{
+	return uint32_t(self.threads.size() + 1);
+}
+
+void
+thread_pool_run(ThreadPool& self, const ThreadPoolJob& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(self.mtx);
+
+		self.job = &job;
+		self.job_generation++;
+		self.busy_count = uint32_t(self.threads.size());
+	}
+
+	self.start_cv.notify_all();
+
+	job(0);
+
+	std::unique_lock<std::mutex> lock(self.mtx);
+	self.done_cv.wait(lock, [&self]() {
+		return self.busy_count == 0;
+	});
+
+	self.job = nullptr;
+}
+
+#if defined(__linux__)
+// Reads a sysfs list such as "0-15,32-47" into values.
+static bool
+_read_cpu_list(const char* path, std::vector<uint32_t>& values)
+{
+	FILE* file = fopen(path, "r");
+	if (!file)
+		return false;
+
+	char line[4096];
+	bool is_read = fgets(line, sizeof(line), file) != nullptr;
+	fclose(file);
+
+	if (!is_read)
+		return false;
+
+	for (char* cursor = line; *cursor >= '0' && *cursor <= '9'; )
+	{
+		uint32_t first = uint32_t(strtoul(cursor, &cursor, 10));
+		uint32_t last = *cursor == '-' ? uint32_t(strtoul(cursor + 1, &cursor, 10)) : first;
+
+		for (uint32_t value = first; value <= last; value++)
+			values.push_back(value);
+
+		if (*cursor == ',')
+			cursor++;
+	}
+
+	return true;
+}
+#endif
+
+// Hardware threads the process may run on, grouped by NUMA node, and the node
+// of each.
+static bool
+_get_cpus(std::vector<uint32_t>& cpus, std::vector<uint32_t>& nodes)
+{
+#if defined(_WIN32)
+	DWORD_PTR process_mask, system_mask;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask))
+		return false;
+
+	std::vector<std::pair<uint32_t, uint32_t>> keys;
+	for (uint32_t cpu = 0; cpu < sizeof(DWORD_PTR) * 8; cpu++)
+	{
+		UCHAR node = 0;
+		if (process_mask & (DWORD_PTR(1) << cpu))
+			keys.push_back({ GetNumaProcessorNode(UCHAR(cpu), &node) ? node : 0, cpu });
+	}
+
+	std::stable_sort(keys.begin(), keys.end());
+
+	for (const auto& key : keys)
+	{
+		nodes.push_back(key.first);
+		cpus.push_back(key.second);
+	}
+
+	return !cpus.empty();
+#elif defined(__linux__)
+	cpu_set_t allowed;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+		return false;
+
+	std::vector<uint32_t> node_ids, node_cpus;
+	_read_cpu_list("/sys/devices/system/node/online", node_ids);
+
+	for (uint32_t node : node_ids)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+
+		node_cpus.clear();
+		_read_cpu_list(path, node_cpus);
+
+		for (uint32_t cpu : node_cpus)
+		{
+			if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed) && std::find(cpus.begin(), cpus.end(), cpu) == cpus.end())
+			{
+				cpus.push_back(cpu);
+				nodes.push_back(node);
+			}
+		}
+	}
+
+	// Without NUMA information everything is one node.
+	for (uint32_t cpu = 0; cpu < CPU_SETSIZE; cpu++)
+	{
+		if (CPU_ISSET(cpu, &allowed) && std::find(cpus.begin(), cpus.end(), cpu) == cpus.end())
+		{
+			cpus.push_back(cpu);
+			nodes.push_back(0);
+		}
+	}
+
+	return !cpus.empty();
+#else
+	return false;
+#endif
+}
+
+// Restricts the calling thread to count hardware threads starting at cpus.
+static void
+_set_affinity(const uint32_t* cpus, size_t count)
+{
+#if defined(_WIN32)
+	DWORD_PTR mask = 0;
+	for (size_t i = 0; i < count; i++)
+		mask |= DWORD_PTR(1) << cpus[i];
+
+	SetThreadAffinityMask(GetCurrentThread(), mask);
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (size_t i = 0; i < count; i++)
+		CPU_SET(cpus[i], &set);
+
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+	(void)cpus;
+	(void)count;
+#endif
+}
+
+bool
+thread_pool_set_pinned(ThreadPool& self, bool is_pinned)
+{
+	// Read once, before any thread was pinned; a pinned caller's affinity no
+	// longer tells what the process may use.
+	static std::vector<uint32_t> cpus, nodes;
+	static bool has_cpus = _get_cpus(cpus, nodes);
+
+	if (!has_cpus)
+		return false;
+
+	self.cpus.clear();
+	self.nodes.clear();
+
+	if (is_pinned)
+	{
+		uint32_t thread_count = thread_pool_get_thread_count(self);
+		for (uint32_t i = 0; i < thread_count; i++)
+		{
+			self.cpus.push_back(cpus[i % cpus.size()]);
+			self.nodes.push_back(nodes[i % nodes.size()]);
+		}
+	}
+
+	thread_pool_run(self, [&self](uint32_t thread_index) {
+		if (self.cpus.empty())
+			_set_affinity(cpus.data(), cpus.size());
+		else
+			_set_affinity(&self.cpus[thread_index], 1);
+	});
+
+	return true;
+}
@@ -0,0 +1,18 @@
+#ifndef THREAD_POOL_INL
+#define THREAD_POOL_INL
+
+#include <Core/ThreadPool.hpp>
+
+static inline bool
+thread_pool_is_pinned(const ThreadPool& self)
+{
+	return !self.cpus.empty();
+}
+
+static inline uint32_t
+thread_pool_get_node(const ThreadPool& self, uint32_t thread_index)
+{
+	return thread_index < self.nodes.size() ? self.nodes[thread_index] : 0;
+}
+
+#endif
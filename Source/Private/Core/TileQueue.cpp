@@ -0,0 +1,28 @@
+#include <Core/TileQueue.hpp>
+
+void
+tile_queue_create(TileQueue& self, size_t capacity)
+{
+	size_t size = 1;
+	while (size < capacity)
+		size <<= 1;
+
+	self.slots = new TileQueue::Slot[size];
+	self.mask = size - 1;
+
+	for (size_t i = 0; i < size; i++)
+		self.slots[i].sequence.store(i, std::memory_order_relaxed);
+
+	self.tail.store(0, std::memory_order_relaxed);
+	self.head = 0;
+
+	self.has_dropped.store(false, std::memory_order_relaxed);
+}
+void
+tile_queue_destroy(TileQueue& self)
+{
+	delete[] self.slots;
+
+	self.slots = nullptr;
+	self.mask = 0;
+}
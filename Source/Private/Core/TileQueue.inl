@@ -0,0 +1,64 @@
+#ifndef TILE_QUEUE_INL
+#define TILE_QUEUE_INL
+
+#include <Core/TileQueue.hpp>
+
+static inline void
+tile_queue_push(TileQueue& self, size_t x, size_t y, size_t width, size_t height)
+{
+	uint64_t rect = uint64_t(x) | (uint64_t(y) << 16) | (uint64_t(width) << 32) | (uint64_t(height) << 48);
+
+	size_t position = self.tail.load(std::memory_order_relaxed);
+
+	while (true)
+	{
+		TileQueue::Slot& slot = self.slots[position & self.mask];
+		size_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+		// The slot is free for this position, still holds an item from a lap
+		// ago, or another producer claimed the position first.
+		if (sequence == position)
+		{
+			if (self.tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				slot.rect = rect;
+				slot.sequence.store(position + 1, std::memory_order_release);
+				return;
+			}
+		}
+		else if (intptr_t(sequence - position) < 0)
+		{
+			self.has_dropped.store(true, std::memory_order_relaxed);
+			return;
+		}
+		else
+			position = self.tail.load(std::memory_order_relaxed);
+	}
+}
+
+static inline bool
+tile_queue_pop(TileQueue& self, size_t& x, size_t& y, size_t& width, size_t& height)
+{
+	TileQueue::Slot& slot = self.slots[self.head & self.mask];
+	if (slot.sequence.load(std::memory_order_acquire) != self.head + 1)
+		return false;
+
+	uint64_t rect = slot.rect;
+	slot.sequence.store(self.head + self.mask + 1, std::memory_order_release);
+	self.head++;
+
+	x = size_t(rect & 0xFFFF);
+	y = size_t((rect >> 16) & 0xFFFF);
+	width = size_t((rect >> 32) & 0xFFFF);
+	height = size_t(rect >> 48);
+
+	return true;
+}
+
+static inline bool
+tile_queue_take_dropped(TileQueue& self)
+{
+	return self.has_dropped.exchange(false, std::memory_order_acquire);
+}
+
+#endif
@@ -0,0 +1,22 @@
+#include <Core/WorkStealingDeque.hpp>
+
+void
+work_stealing_deque_create(WorkStealingDeque& self, size_t capacity)
+{
+	size_t size = 1;
+	while (size < capacity)
+		size <<= 1;
+
+	self.items = new std::atomic<uint64_t>[size];
+	self.mask = size - 1;
+
+	work_stealing_deque_reset(self);
+}
+void
+work_stealing_deque_destroy(WorkStealingDeque& self)
+{
+	delete[] self.items;
+
+	self.items = nullptr;
+	self.mask = 0;
+}
@@ -0,0 +1,78 @@
+#ifndef WORK_STEALING_DEQUE_INL
+#define WORK_STEALING_DEQUE_INL
+
+#include <Core/WorkStealingDeque.hpp>
+
+#include <cassert>
+
+static inline void
+work_stealing_deque_reset(WorkStealingDeque& self)
+{
+	self.top.store(0, std::memory_order_relaxed);
+	self.bottom.store(0, std::memory_order_relaxed);
+}
+
+static inline void
+work_stealing_deque_push(WorkStealingDeque& self, uint64_t item)
+{
+	int64_t bottom = self.bottom.load(std::memory_order_relaxed);
+	int64_t top = self.top.load(std::memory_order_acquire);
+
+	assert(size_t(bottom - top) <= self.mask && "work_stealing_deque_push: deque is full");
+	(void)top;
+
+	self.items[bottom & self.mask].store(item, std::memory_order_relaxed);
+
+	std::atomic_thread_fence(std::memory_order_release);
+	self.bottom.store(bottom + 1, std::memory_order_relaxed);
+}
+
+static inline bool
+work_stealing_deque_take(WorkStealingDeque& self, uint64_t& item)
+{
+	int64_t bottom = self.bottom.load(std::memory_order_relaxed) - 1;
+	self.bottom.store(bottom, std::memory_order_relaxed);
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = self.top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		self.bottom.store(bottom + 1, std::memory_order_relaxed);
+		return false;
+	}
+
+	item = self.items[bottom & self.mask].load(std::memory_order_relaxed);
+	if (top < bottom)
+		return true;
+
+	// Last item, which a thief may be taking at the same time.
+	bool taken = self.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	self.bottom.store(bottom + 1, std::memory_order_relaxed);
+
+	return taken;
+}
+
+static inline bool
+work_stealing_deque_steal(WorkStealingDeque& self, uint64_t& item)
+{
+	int64_t top = self.top.load(std::memory_order_acquire);
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t bottom = self.bottom.load(std::memory_order_acquire);
+
+	if (top >= bottom)
+		return false;
+
+	item = self.items[top & self.mask].load(std::memory_order_relaxed);
+
+	return self.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+static inline bool
+work_stealing_deque_empty(const WorkStealingDeque& self)
+{
+	return self.top.load(std::memory_order_relaxed) >= self.bottom.load(std::memory_order_relaxed);
+}
+
+#endif
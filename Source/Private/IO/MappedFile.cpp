@@ -0,0 +1,114 @@
+#include <IO/MappedFile.hpp>
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+bool
+mapped_file_open(MappedFile& self, const char* filename)
+{
+	self.data = nullptr;
+	self.size = 0;
+
+#if defined(_WIN32)
+	self.file = INVALID_HANDLE_VALUE;
+	self.mapping = nullptr;
+
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	self.file = file;
+	self.size = size_t(size.QuadPart);
+
+	// Zero-length files can not be mapped but are still valid to open.
+	if (!self.size)
+		return true;
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		mapped_file_close(self);
+		return false;
+	}
+
+	self.mapping = mapping;
+	self.data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	self.fd = open(filename, O_RDONLY);
+	if (self.fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(self.fd, &info) != 0)
+	{
+		mapped_file_close(self);
+		return false;
+	}
+
+	self.size = size_t(info.st_size);
+
+	// Zero-length files can not be mapped but are still valid to open.
+	if (!self.size)
+		return true;
+
+	void* data = mmap(nullptr, self.size, PROT_READ, MAP_PRIVATE, self.fd, 0);
+	if (data == MAP_FAILED)
+	{
+		mapped_file_close(self);
+		return false;
+	}
+
+	madvise(data, self.size, MADV_WILLNEED);
+
+	self.data = (const char*)data;
+#endif
+
+	if (!self.data)
+	{
+		mapped_file_close(self);
+		return false;
+	}
+
+	return true;
+}
+void
+mapped_file_close(MappedFile& self)
+{
+#if defined(_WIN32)
+	if (self.data)
+		UnmapViewOfFile(self.data);
+	if (self.mapping)
+		CloseHandle(self.mapping);
+	if (self.file != INVALID_HANDLE_VALUE)
+		CloseHandle(self.file);
+
+	self.file = INVALID_HANDLE_VALUE;
+	self.mapping = nullptr;
+#else
+	if (self.data)
+		munmap((void*)self.data, self.size);
+	if (self.fd >= 0)
+		close(self.fd);
+
+	self.fd = -1;
+#endif
+
+	self.data = nullptr;
+	self.size = 0;
+}
@@ -0,0 +1,80 @@
+#ifndef AABB_INL
+#define AABB_INL
+
+#include <Math/AABB.hpp>
+
+#include <limits>
+#include <algorithm>
+
+static inline AABB
+aabb_empty()
+{
+	const float inf = std::numeric_limits<float>::infinity();
+
+	return { { inf, inf, inf }, { -inf, -inf, -inf } };
+}
+
+static inline void
+aabb_expand(AABB& self, const Vec3f& point)
+{
+	for (size_t i = 0; i < 3; i++)
+	{
+		self.min[i] = std::min(self.min[i], point[i]);
+		self.max[i] = std::max(self.max[i], point[i]);
+	}
+}
+static inline void
+aabb_expand(AABB& self, const AABB& other)
+{
+	for (size_t i = 0; i < 3; i++)
+	{
+		self.min[i] = std::min(self.min[i], other.min[i]);
+		self.max[i] = std::max(self.max[i], other.max[i]);
+	}
+}
+
+static inline Vec3f
+aabb_extent(const AABB& self)
+{
+	return self.max - self.min;
+}
+static inline Vec3f
+aabb_centroid(const AABB& self)
+{
+	return (self.min + self.max) * 0.5f;
+}
+static inline float
+aabb_surface_area(const AABB& self)
+{
+	Vec3f extent = aabb_extent(self);
+	if (extent.x < 0.0f || extent.y < 0.0f || extent.z < 0.0f)
+		return 0.0f;
+
+	return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+static inline bool
+aabb_intersect(const AABB& self, const Ray& ray, const Vec3f& inv_direction, float ray_tmin, float ray_tmax, float& t)
+{
+	for (size_t i = 0; i < 3; i++)
+	{
+		float t0 = (self.min[i] - ray.origin[i]) * inv_direction[i];
+		float t1 = (self.max[i] - ray.origin[i]) * inv_direction[i];
+
+		if (t0 > t1)
+			std::swap(t0, t1);
+
+		t1 *= AABB_FAR_SCALE;
+
+		ray_tmin = t0 > ray_tmin ? t0 : ray_tmin;
+		ray_tmax = t1 < ray_tmax ? t1 : ray_tmax;
+
+		if (ray_tmax < ray_tmin)
+			return false;
+	}
+
+	t = ray_tmin;
+	return true;
+}
+
+#endif
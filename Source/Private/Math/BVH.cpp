@@ -0,0 +1,476 @@
+#include <Math/BVH.hpp>
+
+#include <chrono>
+#include <algorithm>
+
+static constexpr uint32_t BVH_BIN_COUNT = 16;
+static constexpr uint32_t BVH_MAX_LEAF_SIZE = 8;
+
+// Past this depth nodes are split at the median, which gets any 32-bit count
+// down to BVH_MAX_LEAF_SIZE within the levels left before BVH_MAX_DEPTH.
+// Skewed inputs can otherwise split one primitive off per level.
+static constexpr uint32_t BVH_MEDIAN_SPLIT_DEPTH = BVH_MAX_DEPTH - 32;
+
+static constexpr float BVH_TRAVERSAL_COST = 1.0f;
+static constexpr float BVH_INTERSECTION_COST = 1.0f;
+
+struct _Bin
+{
+	AABB bounds;
+	uint32_t count;
+};
+
+struct _Split
+{
+	int axis;
+	uint32_t bin;
+	float cost;
+};
+
+static _Split
+_find_sah_split(const BVH& self, const BVHNode& node, const AABB& centroid_bounds, const Vec3f* centroids, const AABB* bounds)
+{
+	_Split best_split { -1, 0, std::numeric_limits<float>::infinity() };
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float axis_min = centroid_bounds.min[axis];
+		float axis_extent = centroid_bounds.max[axis] - axis_min;
+		if (axis_extent <= 0.0f)
+			continue;
+
+		_Bin bins[BVH_BIN_COUNT];
+		for (auto& bin : bins)
+			bin = { aabb_empty(), 0 };
+
+		float scale = float(BVH_BIN_COUNT) / axis_extent;
+		for (uint32_t i = 0; i < node.count; i++)
+		{
+			uint32_t index = self.indices[node.offset + i];
+
+			uint32_t bin = std::min(BVH_BIN_COUNT - 1, uint32_t((centroids[index][axis] - axis_min) * scale));
+			bins[bin].count++;
+			aabb_expand(bins[bin].bounds, bounds[index]);
+		}
+
+		float right_area[BVH_BIN_COUNT - 1];
+		uint32_t right_count[BVH_BIN_COUNT - 1];
+
+		AABB right_bounds = aabb_empty();
+		uint32_t right_sum = 0;
+		for (uint32_t i = BVH_BIN_COUNT - 1; i > 0; i--)
+		{
+			aabb_expand(right_bounds, bins[i].bounds);
+			right_sum += bins[i].count;
+
+			right_area[i - 1] = aabb_surface_area(right_bounds);
+			right_count[i - 1] = right_sum;
+		}
+
+		AABB left_bounds = aabb_empty();
+		uint32_t left_sum = 0;
+		for (uint32_t i = 0; i < BVH_BIN_COUNT - 1; i++)
+		{
+			aabb_expand(left_bounds, bins[i].bounds);
+			left_sum += bins[i].count;
+
+			if (!left_sum || !right_count[i])
+				continue;
+
+			float cost = aabb_surface_area(left_bounds) * left_sum + right_area[i] * right_count[i];
+			if (cost < best_split.cost)
+				best_split = { axis, i, cost };
+		}
+	}
+
+	return best_split;
+}
+
+// Builds the subtree rooted at root, at depth root_depth, whose offset and
+// count describe a range of indices. New nodes are appended, so children
+// always follow their parent.
+static void
+_build_subtree(BVH& self, const AABB* bounds, const Vec3f* centroids, uint32_t root, uint32_t root_depth)
+{
+	struct PendingNode
+	{
+		uint32_t node;
+		uint32_t depth;
+	};
+
+	std::vector<PendingNode> pending = { { root, root_depth } };
+	while (!pending.empty())
+	{
+		uint32_t node_index = pending.back().node;
+		uint32_t depth = pending.back().depth;
+		pending.pop_back();
+
+		BVHNode node = self.nodes[node_index];
+
+		AABB centroid_bounds = aabb_empty();
+		for (uint32_t i = 0; i < node.count; i++)
+		{
+			uint32_t index = self.indices[node.offset + i];
+
+			aabb_expand(node.bounds, bounds[index]);
+			aabb_expand(centroid_bounds, centroids[index]);
+		}
+
+		self.nodes[node_index].bounds = node.bounds;
+
+		if (node.count == 1)
+			continue;
+
+		uint32_t* first = self.indices.data() + node.offset;
+		uint32_t* last = first + node.count;
+		uint32_t* middle = nullptr;
+
+		_Split split = { -1, 0, 0.0f };
+		if (depth < BVH_MEDIAN_SPLIT_DEPTH)
+			split = _find_sah_split(self, node, centroid_bounds, centroids, bounds);
+
+		if (split.axis >= 0)
+		{
+			float leaf_cost = BVH_INTERSECTION_COST * node.count;
+			float split_cost = BVH_TRAVERSAL_COST +
+				BVH_INTERSECTION_COST * split.cost / aabb_surface_area(node.bounds);
+
+			if (split_cost >= leaf_cost && node.count <= BVH_MAX_LEAF_SIZE)
+				continue;
+
+			float axis_min = centroid_bounds.min[split.axis];
+			float scale = float(BVH_BIN_COUNT) / (centroid_bounds.max[split.axis] - axis_min);
+
+			middle = std::partition(first, last, [&](uint32_t index) {
+				uint32_t bin = std::min(BVH_BIN_COUNT - 1, uint32_t((centroids[index][split.axis] - axis_min) * scale));
+				return bin <= split.bin;
+			});
+		}
+		else
+		{
+			// Every centroid coincides, so no plane separates them, or the node
+			// is too deep for another lopsided split; fall back to halving the
+			// range about the median on the widest axis once the leaf would
+			// grow too large.
+			if (node.count <= BVH_MAX_LEAF_SIZE)
+				continue;
+
+			middle = first + node.count / 2;
+
+			Vec3f extent = aabb_extent(centroid_bounds);
+			int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+			std::nth_element(first, middle, last, [&](uint32_t a, uint32_t b) {
+				return centroids[a][axis] < centroids[b][axis];
+			});
+		}
+
+		uint32_t left_count = uint32_t(middle - first);
+		uint32_t left_index = uint32_t(self.nodes.size());
+
+		self.nodes.push_back({ aabb_empty(), node.offset, left_count });
+		self.nodes.push_back({ aabb_empty(), node.offset + left_count, node.count - left_count });
+
+		self.nodes[node_index].offset = left_index;
+		self.nodes[node_index].count = 0;
+
+		pending.push_back({ left_index + 1, depth + 1 });
+		pending.push_back({ left_index, depth + 1 });
+	}
+}
+
+// SAH cost of every subtree relative to its own root area, computed bottom-up
+// since children always follow their parent.
+static void
+_compute_costs(const BVH& self, std::vector<float>& costs)
+{
+	costs.resize(self.nodes.size());
+
+	for (size_t i = self.nodes.size(); i-- > 0; )
+	{
+		const BVHNode& node = self.nodes[i];
+		if (node.count)
+		{
+			costs[i] = BVH_INTERSECTION_COST * node.count;
+			continue;
+		}
+
+		float area = aabb_surface_area(node.bounds);
+		float left_area = aabb_surface_area(self.nodes[node.offset].bounds);
+		float right_area = aabb_surface_area(self.nodes[node.offset + 1].bounds);
+
+		float children = area > 0.0f ?
+			(costs[node.offset] * left_area + costs[node.offset + 1] * right_area) / area :
+			costs[node.offset] + costs[node.offset + 1];
+
+		costs[i] = BVH_TRAVERSAL_COST + children;
+	}
+}
+
+// Renumbers the nodes reachable from the root depth first, dropping the ones
+// orphaned by subtree rebuilds. Costs are carried along.
+static void
+_compact(BVH& self)
+{
+	std::vector<BVHNode> nodes;
+	std::vector<float> costs;
+
+	nodes.reserve(self.nodes.size());
+	costs.reserve(self.nodes.size());
+
+	nodes.push_back(self.nodes[0]);
+	costs.push_back(self.costs[0]);
+
+	std::vector<std::pair<uint32_t, uint32_t>> pending = { { 0, 0 } };
+	while (!pending.empty())
+	{
+		auto [old_index, new_index] = pending.back();
+		pending.pop_back();
+
+		const BVHNode& node = self.nodes[old_index];
+		if (node.count)
+			continue;
+
+		uint32_t left_index = uint32_t(nodes.size());
+		nodes[new_index].offset = left_index;
+
+		for (uint32_t child = 0; child < 2; child++)
+		{
+			nodes.push_back(self.nodes[node.offset + child]);
+			costs.push_back(self.costs[node.offset + child]);
+		}
+
+		pending.push_back({ node.offset + 1, left_index + 1 });
+		pending.push_back({ node.offset, left_index });
+	}
+
+	self.nodes.swap(nodes);
+	self.costs.swap(costs);
+}
+
+static std::vector<Vec3f>
+_compute_centroids(const AABB* bounds, size_t count)
+{
+	std::vector<Vec3f> centroids(count);
+	for (size_t i = 0; i < count; i++)
+		centroids[i] = aabb_centroid(bounds[i]);
+
+	return centroids;
+}
+
+void
+bvh_build(BVH& self, const AABB* bounds, size_t count)
+{
+	bvh_clear(self);
+
+	if (!count)
+		return;
+
+	std::vector<Vec3f> centroids = _compute_centroids(bounds, count);
+
+	self.indices.resize(count);
+	for (size_t i = 0; i < count; i++)
+		self.indices[i] = uint32_t(i);
+
+	self.nodes.reserve(2 * count - 1);
+	self.nodes.push_back({ aabb_empty(), 0, uint32_t(count) });
+
+	_build_subtree(self, bounds, centroids.data(), 0, 0);
+	_compute_costs(self, self.costs);
+}
+void
+bvh_build(BVH& self, const HittableList& hittable_list)
+{
+	std::vector<AABB> bounds(hittable_list.size());
+	for (size_t i = 0; i < hittable_list.size(); i++)
+		bounds[i] = hittable_list[i]->bounds(hittable_list[i].get());
+
+	bvh_build(self, bounds.data(), bounds.size());
+}
+
+void
+bvh_clear(BVH& self)
+{
+	self.nodes.clear();
+	self.indices.clear();
+	self.costs.clear();
+}
+
+void
+bvh_refit(BVH& self, const AABB* bounds)
+{
+	for (size_t i = self.nodes.size(); i-- > 0; )
+	{
+		BVHNode& node = self.nodes[i];
+		node.bounds = aabb_empty();
+
+		if (node.count)
+		{
+			for (uint32_t j = 0; j < node.count; j++)
+				aabb_expand(node.bounds, bounds[self.indices[node.offset + j]]);
+		}
+		else
+		{
+			aabb_expand(node.bounds, self.nodes[node.offset].bounds);
+			aabb_expand(node.bounds, self.nodes[node.offset + 1].bounds);
+		}
+	}
+}
+
+BVHUpdateStats
+bvh_update(BVH& self, const AABB* bounds, size_t count, float threshold)
+{
+	BVHUpdateStats stats {};
+
+	if (self.nodes.empty() || count != self.indices.size())
+	{
+		auto build_start = std::chrono::steady_clock::now();
+		bvh_build(self, bounds, count);
+		auto build_end = std::chrono::steady_clock::now();
+
+		stats.type = BVHUpdateType::BU_FULL_REBUILD;
+		stats.rebuilt_primitives = uint32_t(count);
+		stats.refit_cost_ratio = stats.cost_ratio = 1.0f;
+		stats.rebuild_ms = std::chrono::duration<double, std::milli>(build_end - build_start).count();
+
+		return stats;
+	}
+
+	auto refit_start = std::chrono::steady_clock::now();
+
+	bvh_refit(self, bounds);
+
+	std::vector<float> costs;
+	_compute_costs(self, costs);
+
+	auto refit_end = std::chrono::steady_clock::now();
+
+	auto degraded = [&](uint32_t node) {
+		return costs[node] > threshold * self.costs[node];
+	};
+
+	stats.type = BVHUpdateType::BU_REFIT;
+	stats.refit_cost_ratio = stats.cost_ratio = costs[0] / self.costs[0];
+	stats.refit_ms = std::chrono::duration<double, std::milli>(refit_end - refit_start).count();
+
+	if (!degraded(0))
+		return stats;
+
+	// Descend while the degradation is confined to one interior child and
+	// rebuild the subtree where it spreads over both, so the rebuilt subtree
+	// also replaces the degraded splits inside it.
+	uint32_t root = 0, root_depth = 0;
+	for (;;)
+	{
+		const BVHNode& node = self.nodes[root];
+		if (node.count)
+			break;
+
+		bool left = degraded(node.offset), right = degraded(node.offset + 1);
+		if (left == right)
+			break;
+
+		uint32_t child = left ? node.offset : node.offset + 1;
+		if (self.nodes[child].count)
+			break;
+
+		root = child;
+		root_depth++;
+	}
+
+	auto rebuild_start = std::chrono::steady_clock::now();
+
+	bool full_rebuild = root == 0;
+	if (!full_rebuild)
+	{
+		// Index ranges of every subtree, the first leaf offset and the total
+		// primitive count below it.
+		std::vector<uint32_t> first(self.nodes.size()), primitives(self.nodes.size());
+		for (size_t i = self.nodes.size(); i-- > 0; )
+		{
+			const BVHNode& node = self.nodes[i];
+
+			first[i] = node.count ? node.offset : first[node.offset];
+			primitives[i] = node.count ? node.count : primitives[node.offset] + primitives[node.offset + 1];
+		}
+
+		std::vector<Vec3f> centroids = _compute_centroids(bounds, count);
+
+		size_t rebuilt_begin = self.nodes.size();
+		self.nodes[root] = { aabb_empty(), first[root], primitives[root] };
+		_build_subtree(self, bounds, centroids.data(), root, root_depth);
+
+		stats.rebuilt_primitives = primitives[root];
+
+		// The rebuilt subtree takes its fresh costs as the new baseline, the
+		// rest of the tree keeps the one it was built with.
+		_compute_costs(self, costs);
+
+		self.costs.resize(self.nodes.size());
+		self.costs[root] = costs[root];
+		for (size_t i = rebuilt_begin; i < self.nodes.size(); i++)
+			self.costs[i] = costs[i];
+
+		_compact(self);
+
+		stats.type = BVHUpdateType::BU_PARTIAL_REBUILD;
+		stats.cost_ratio = costs[0] / self.costs[0];
+
+		// Splits above the rebuilt subtree can be degraded too, which only a
+		// full rebuild repairs.
+		full_rebuild = stats.cost_ratio > threshold;
+	}
+
+	if (full_rebuild)
+	{
+		bvh_build(self, bounds, count);
+
+		stats.type = BVHUpdateType::BU_FULL_REBUILD;
+		stats.rebuilt_primitives = uint32_t(count);
+		stats.cost_ratio = 1.0f;
+	}
+
+	auto rebuild_end = std::chrono::steady_clock::now();
+
+	stats.rebuild_ms = std::chrono::duration<double, std::milli>(rebuild_end - rebuild_start).count();
+
+	return stats;
+}
+
+float
+bvh_sah_cost(const BVH& self)
+{
+	std::vector<float> costs;
+	_compute_costs(self, costs);
+
+	return costs.empty() ? 0.0f : costs[0];
+}
+
+void
+traversal_stats_merge(TraversalStats& self, const TraversalStats& other)
+{
+	self.rays += other.rays;
+	self.nodes_visited += other.nodes_visited;
+	self.leaves_visited += other.leaves_visited;
+}
+
+const HitRecord
+bvh_hit(const BVH& self, HittableList& hittable_list, const Ray& ray, float ray_tmin, float ray_tmax)
+{
+	HitRecord best_hit_record {};
+
+	bvh_traverse(self, ray, ray_tmin, ray_tmax, [&](uint32_t index, float tmin, float& tmax) {
+		auto& hittable = hittable_list[index];
+
+		HitRecord temp_record = hittable->hit(hittable.get(), ray, tmin, tmax);
+		if (!temp_record.hit)
+			return false;
+
+		tmax = temp_record.t;
+		best_hit_record = temp_record;
+
+		return true;
+	});
+
+	return best_hit_record;
+}
@@ -0,0 +1,113 @@
+#ifndef BVH_INL
+#define BVH_INL
+
+#include <Math/BVH.hpp>
+
+#include <cassert>
+
+// Invokes leaf_fn(offset, count, ray_tmin, ray_tmax) for every leaf the ray
+// reaches, nearest child first. The callback shrinks ray_tmax on a hit and
+// returns true, which lets the traversal cull everything further away.
+template<typename InLeafFn>
+inline bool
+bvh_traverse_leaves(const BVH& self, const Ray& ray, float ray_tmin, float& ray_tmax, InLeafFn leaf_fn, TraversalStats* stats)
+{
+	if (stats)
+		stats->rays++;
+
+	if (self.nodes.empty())
+		return false;
+
+	const Vec3f inv_direction = {
+		1.0f / ray.direction.x,
+		1.0f / ray.direction.y,
+		1.0f / ray.direction.z
+	};
+
+	struct StackEntry
+	{
+		uint32_t node;
+		float t;
+	};
+
+	StackEntry stack[BVH_MAX_DEPTH];
+	size_t stack_size = 0;
+
+	float t;
+	if (!aabb_intersect(self.nodes[0].bounds, ray, inv_direction, ray_tmin, ray_tmax, t))
+		return false;
+
+	bool hit = false;
+	stack[stack_size++] = { 0, t };
+
+	while (stack_size)
+	{
+		StackEntry entry = stack[--stack_size];
+		if (entry.t > ray_tmax)
+			continue;
+
+		const BVHNode* node = &self.nodes[entry.node];
+		while (!node->count)
+		{
+			if (stats)
+				stats->nodes_visited++;
+
+			const BVHNode* left = &self.nodes[node->offset];
+			const BVHNode* right = left + 1;
+
+			float t_left, t_right;
+			bool hit_left = aabb_intersect(left->bounds, ray, inv_direction, ray_tmin, ray_tmax, t_left);
+			bool hit_right = aabb_intersect(right->bounds, ray, inv_direction, ray_tmin, ray_tmax, t_right);
+
+			if (hit_left && hit_right)
+			{
+				if (t_right < t_left)
+				{
+					std::swap(left, right);
+					std::swap(t_left, t_right);
+				}
+
+				assert(stack_size < sizeof(stack) / sizeof(stack[0]));
+				stack[stack_size++] = { uint32_t(right - self.nodes.data()), t_right };
+
+				node = left;
+			}
+			else if (hit_left)
+				node = left;
+			else if (hit_right)
+				node = right;
+			else
+				break;
+		}
+
+		if (!node->count)
+			continue;
+
+		if (stats)
+			stats->leaves_visited++;
+
+		if (leaf_fn(node->offset, node->count, ray_tmin, ray_tmax))
+			hit = true;
+	}
+
+	return hit;
+}
+
+// Same as bvh_traverse_leaves, but calls leaf_fn(index, ray_tmin, ray_tmax) once
+// per primitive index stored in the leaf.
+template<typename InLeafFn>
+inline bool
+bvh_traverse(const BVH& self, const Ray& ray, float ray_tmin, float& ray_tmax, InLeafFn leaf_fn)
+{
+	return bvh_traverse_leaves(self, ray, ray_tmin, ray_tmax, [&](uint32_t offset, uint32_t count, float tmin, float& tmax) {
+		bool hit = false;
+
+		for (uint32_t i = 0; i < count; i++)
+			if (leaf_fn(self.indices[offset + i], tmin, tmax))
+				hit = true;
+
+		return hit;
+	});
+}
+
+#endif
@@ -1,11 +1,11 @@
 #include <Math/BoundingSphere.hpp>
 
 HitRecord
-_hit_impl(std::shared_ptr<Hittable> hittable, const Ray& ray, double ray_tmin, double ray_tmax)
+_hit_impl(const Hittable* hittable, const Ray& ray, float ray_tmin, float ray_tmax)
 {
 	HitRecord hit_record {};
 
-	BoundingSphere* sphere = (BoundingSphere*)hittable.get();
+	const BoundingSphere* sphere = (const BoundingSphere*)hittable;
 	hit_record.t = bounding_sphere_intersect(*sphere, ray);
 
 	if (hit_record.t != constants_infinity<float>())
@@ -34,10 +34,22 @@ _hit_impl(std::shared_ptr<Hittable> hittable, const Ray& ray, double ray_tmin, d
 	return hit_record;
 }
 
+AABB
+_bounds_impl(const Hittable* hittable)
+{
+	const BoundingSphere* sphere = (const BoundingSphere*)hittable;
+
+	Vec3f extent = { sphere->radius, sphere->radius, sphere->radius };
+	return { sphere->center - extent, sphere->center + extent };
+}
+
 void
 bound_sphere_create(BoundingSphere& self, float radius)
 {
+	self.type = HittableType::HT_SPHERE;
+
 	self.hit = _hit_impl;
+	self.bounds = _bounds_impl;
 
 	self.radius = radius;
 	self.center = { 0.0f, 0.0f, 0.0f };
@@ -45,7 +57,10 @@ bound_sphere_create(BoundingSphere& self, float radius)
 void
 bound_sphere_create(BoundingSphere& self, float radius, Vec3f center)
 {
+	self.type = HittableType::HT_SPHERE;
+
 	self.hit = _hit_impl;
+	self.bounds = _bounds_impl;
 
 	self.radius = radius;
 	self.center = center;
@@ -0,0 +1,451 @@
+#include <Math/Geometry.hpp>
+
+#include <chrono>
+#include <cassert>
+#include <algorithm>
+
+#include <Math/BoundingSphere.hpp>
+
+template<HittableType InType>
+struct _GeometryKernel;
+
+template<>
+struct _GeometryKernel<HittableType::HT_SPHERE>
+{
+	static inline void
+	append(GeometryScene& self, const Hittable* hittable, GeometryHandle& handle)
+	{
+		const BoundingSphere* sphere = (const BoundingSphere*)hittable;
+
+		handle.index = sphere_soa_add(self.spheres, sphere->radius, sphere->center);
+	}
+
+	static inline GeometryHit
+	intersect(const GeometryScene& self, uint32_t first, uint32_t count, const Ray& ray, float ray_tmin, float ray_tmax)
+	{
+		SphereSoAHit hit = sphere_soa_intersect(self.spheres, first, count, ray, ray_tmin, ray_tmax);
+
+		return { hit.t, { HittableType::HT_SPHERE, hit.index }, hit.hit, 0, 0.0f, 0.0f };
+	}
+
+	static inline HitRecord
+	hit_record(const GeometryScene& self, const GeometryHit& hit, const Ray& ray)
+	{
+		return sphere_soa_hit_record(self.spheres, hit.handle.index, ray, hit.t);
+	}
+};
+
+template<>
+struct _GeometryKernel<HittableType::HT_MESH>
+{
+	static inline void
+	append(GeometryScene& self, const Hittable* hittable, GeometryHandle& handle)
+	{
+		handle.index = uint32_t(self.meshes.size());
+
+		self.meshes.push_back((const TriangleMesh*)hittable);
+	}
+
+	static inline GeometryHit
+	intersect(const GeometryScene& self, uint32_t first, uint32_t count, const Ray& ray, float ray_tmin, float ray_tmax)
+	{
+		GeometryHit best_hit {};
+
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			TriangleHit hit = triangle_mesh_intersect(*self.meshes[i], ray, ray_tmin, ray_tmax);
+			if (!hit.hit)
+				continue;
+
+			ray_tmax = hit.t;
+			best_hit = { hit.t, { HittableType::HT_MESH, i }, true, hit.index, hit.u, hit.v };
+		}
+
+		return best_hit;
+	}
+
+	static inline HitRecord
+	hit_record(const GeometryScene& self, const GeometryHit& hit, const Ray& ray)
+	{
+		TriangleHit triangle_hit = { hit.t, hit.u, hit.v, hit.primitive, true };
+
+		return triangle_mesh_hit_record(*self.meshes[hit.handle.index], triangle_hit, ray);
+	}
+};
+
+template<>
+struct _GeometryKernel<HittableType::HT_INSTANCE>
+{
+	static inline void
+	append(GeometryScene& self, const Hittable* hittable, GeometryHandle& handle)
+	{
+		handle.index = uint32_t(self.instances.size());
+
+		self.instances.push_back((const Instance*)hittable);
+	}
+
+	static inline GeometryHit
+	intersect(const GeometryScene& self, uint32_t first, uint32_t count, const Ray& ray, float ray_tmin, float ray_tmax)
+	{
+		GeometryHit best_hit {};
+
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			TriangleHit hit = instance_intersect(*self.instances[i], ray, ray_tmin, ray_tmax);
+			if (!hit.hit)
+				continue;
+
+			ray_tmax = hit.t;
+			best_hit = { hit.t, { HittableType::HT_INSTANCE, i }, true, hit.index, hit.u, hit.v };
+		}
+
+		return best_hit;
+	}
+
+	static inline HitRecord
+	hit_record(const GeometryScene& self, const GeometryHit& hit, const Ray& ray)
+	{
+		TriangleHit triangle_hit = { hit.t, hit.u, hit.v, hit.primitive, true };
+
+		return instance_hit_record(*self.instances[hit.handle.index], triangle_hit, ray);
+	}
+};
+
+template<HittableType InType>
+static inline bool
+_intersect_run(const GeometryScene& self, uint32_t first, uint32_t count, const Ray& ray, float ray_tmin, float& ray_tmax, GeometryHit& best_hit)
+{
+	GeometryHit hit = _GeometryKernel<InType>::intersect(self,
+		self.handles[first].index, count, ray, ray_tmin, ray_tmax);
+
+	if (!hit.hit)
+		return false;
+
+	ray_tmax = hit.t;
+	best_hit = hit;
+
+	return true;
+}
+
+static void
+_build_wide_bvh(GeometryScene& self)
+{
+	switch (self.acceleration)
+	{
+		case AccelerationType::AT_BVH4:
+			if (self.bvh4.nodes.empty())
+				wide_bvh_build(self.bvh4, self.bvh);
+			break;
+		case AccelerationType::AT_BVH8:
+			if (self.bvh8.nodes.empty())
+				wide_bvh_build(self.bvh8, self.bvh);
+			break;
+		default:
+			break;
+	}
+}
+
+static inline bool
+_intersect_leaf(const GeometryScene& self, uint32_t offset, uint32_t count, const Ray& ray, float ray_tmin, float& ray_tmax, GeometryHit& best_hit)
+{
+	bool hit = false;
+
+	uint32_t end = offset + count;
+	while (offset < end)
+	{
+		HittableType type = self.handles[offset].type;
+
+		uint32_t run_end = offset + 1;
+		while (run_end < end && self.handles[run_end].type == type)
+			run_end++;
+
+		switch (type)
+		{
+			case HittableType::HT_SPHERE:
+				hit |= _intersect_run<HittableType::HT_SPHERE>(self, offset, run_end - offset, ray, ray_tmin, ray_tmax, best_hit);
+				break;
+			case HittableType::HT_MESH:
+				hit |= _intersect_run<HittableType::HT_MESH>(self, offset, run_end - offset, ray, ray_tmin, ray_tmax, best_hit);
+				break;
+			case HittableType::HT_INSTANCE:
+				hit |= _intersect_run<HittableType::HT_INSTANCE>(self, offset, run_end - offset, ray, ray_tmin, ray_tmax, best_hit);
+				break;
+			default:
+				break;
+		}
+
+		offset = run_end;
+	}
+
+	return hit;
+}
+
+void
+geometry_scene_create(GeometryScene& self)
+{
+	self.acceleration = AccelerationType::AT_BVH2;
+
+	sphere_soa_create(self.spheres);
+}
+void
+geometry_scene_destroy(GeometryScene& self)
+{
+	bvh_clear(self.bvh);
+	wide_bvh_clear(self.bvh4);
+	wide_bvh_clear(self.bvh8);
+	sphere_soa_destroy(self.spheres);
+
+	self.meshes.clear();
+	self.instances.clear();
+	self.handles.clear();
+	self.sources.clear();
+}
+
+// Copies the hittables into their batches in the order of bvh.indices, which
+// map leaf slots to hittable_list positions, and makes the indices identity.
+static void
+_pack(GeometryScene& self, const HittableList& hittable_list)
+{
+	sphere_soa_clear(self.spheres);
+	sphere_soa_reserve(self.spheres, hittable_list.size());
+
+	self.meshes.clear();
+	self.instances.clear();
+
+	self.handles.resize(hittable_list.size());
+	self.sources.resize(hittable_list.size());
+
+	auto by_type = [&](uint32_t lhs, uint32_t rhs) {
+		return hittable_list[lhs]->type < hittable_list[rhs]->type;
+	};
+
+	for (const BVHNode& node : self.bvh.nodes)
+	{
+		if (!node.count)
+			continue;
+
+		uint32_t* first = self.bvh.indices.data() + node.offset;
+		std::stable_sort(first, first + node.count, by_type);
+	}
+
+	for (size_t i = 0; i < self.bvh.indices.size(); i++)
+	{
+		const Hittable* hittable = hittable_list[self.bvh.indices[i]].get();
+
+		GeometryHandle& handle = self.handles[i];
+		handle.type = hittable->type;
+
+		switch (hittable->type)
+		{
+			case HittableType::HT_SPHERE:
+				_GeometryKernel<HittableType::HT_SPHERE>::append(self, hittable, handle);
+				break;
+			case HittableType::HT_MESH:
+				_GeometryKernel<HittableType::HT_MESH>::append(self, hittable, handle);
+				break;
+			case HittableType::HT_INSTANCE:
+				_GeometryKernel<HittableType::HT_INSTANCE>::append(self, hittable, handle);
+				break;
+			default:
+				assert(!"geometry_scene_build: unsupported hittable type");
+				break;
+		}
+
+		self.sources[i] = self.bvh.indices[i];
+		self.bvh.indices[i] = uint32_t(i);
+	}
+
+	wide_bvh_clear(self.bvh4);
+	wide_bvh_clear(self.bvh8);
+
+	_build_wide_bvh(self);
+}
+
+void
+geometry_scene_build(GeometryScene& self, const HittableList& hittable_list)
+{
+	bvh_build(self.bvh, hittable_list);
+
+	_pack(self, hittable_list);
+}
+
+// Whether every handle still refers to a hittable of its type, and meshes and
+// instances to the very objects the batches point at. Spheres are copied into
+// the batch, so any sphere can take the place of another.
+static bool
+_matches(const GeometryScene& self, const HittableList& hittable_list)
+{
+	if (hittable_list.size() != self.handles.size())
+		return false;
+
+	for (size_t i = 0; i < self.handles.size(); i++)
+	{
+		const Hittable* hittable = hittable_list[self.sources[i]].get();
+		const GeometryHandle& handle = self.handles[i];
+
+		if (hittable->type != handle.type)
+			return false;
+
+		if (handle.type == HittableType::HT_MESH && (const Hittable*)self.meshes[handle.index] != hittable)
+			return false;
+		if (handle.type == HittableType::HT_INSTANCE && (const Hittable*)self.instances[handle.index] != hittable)
+			return false;
+	}
+
+	return true;
+}
+
+BVHUpdateStats
+geometry_scene_update(GeometryScene& self, const HittableList& hittable_list, float threshold)
+{
+	if (!_matches(self, hittable_list))
+	{
+		auto build_start = std::chrono::steady_clock::now();
+		geometry_scene_build(self, hittable_list);
+		auto build_end = std::chrono::steady_clock::now();
+
+		BVHUpdateStats stats {};
+		stats.type = BVHUpdateType::BU_FULL_REBUILD;
+		stats.rebuilt_primitives = uint32_t(hittable_list.size());
+		stats.refit_cost_ratio = stats.cost_ratio = 1.0f;
+		stats.rebuild_ms = std::chrono::duration<double, std::milli>(build_end - build_start).count();
+
+		return stats;
+	}
+
+	auto refresh_start = std::chrono::steady_clock::now();
+
+	// Bounds per leaf slot, which is what the tree indexes since packing.
+	std::vector<AABB> bounds(self.handles.size());
+	for (size_t i = 0; i < self.handles.size(); i++)
+	{
+		const Hittable* hittable = hittable_list[self.sources[i]].get();
+		bounds[i] = hittable->bounds(hittable);
+
+		if (self.handles[i].type == HittableType::HT_SPHERE)
+		{
+			const BoundingSphere* sphere = (const BoundingSphere*)hittable;
+			sphere_soa_set(self.spheres, self.handles[i].index, sphere->radius, sphere->center);
+		}
+	}
+
+	auto refresh_end = std::chrono::steady_clock::now();
+
+	BVHUpdateStats stats = bvh_update(self.bvh, bounds.data(), bounds.size(), threshold);
+
+	auto repack_start = std::chrono::steady_clock::now();
+
+	if (stats.type == BVHUpdateType::BU_REFIT)
+	{
+		// Same topology, so the wide trees only need collapsing again.
+		wide_bvh_clear(self.bvh4);
+		wide_bvh_clear(self.bvh8);
+
+		_build_wide_bvh(self);
+	}
+	else
+	{
+		// Rebuilds permute the slots, which the batches have to follow.
+		for (uint32_t& index : self.bvh.indices)
+			index = self.sources[index];
+
+		_pack(self, hittable_list);
+	}
+
+	auto repack_end = std::chrono::steady_clock::now();
+
+	double refresh_ms = std::chrono::duration<double, std::milli>(refresh_end - refresh_start).count();
+	double repack_ms = std::chrono::duration<double, std::milli>(repack_end - repack_start).count();
+
+	stats.refit_ms += refresh_ms;
+	if (stats.type == BVHUpdateType::BU_REFIT)
+		stats.refit_ms += repack_ms;
+	else
+		stats.rebuild_ms += repack_ms;
+
+	return stats;
+}
+
+void
+geometry_scene_set_acceleration(GeometryScene& self, AccelerationType acceleration)
+{
+	self.acceleration = acceleration;
+
+	_build_wide_bvh(self);
+}
+
+const GeometryHit
+geometry_scene_intersect(const GeometryScene& self, const Ray& ray, float ray_tmin, float ray_tmax, TraversalStats* stats)
+{
+	GeometryHit best_hit {};
+
+	auto leaf_fn = [&](uint32_t offset, uint32_t count, float tmin, float& tmax) {
+		return _intersect_leaf(self, offset, count, ray, tmin, tmax, best_hit);
+	};
+
+	switch (self.acceleration)
+	{
+		case AccelerationType::AT_BVH4:
+			wide_bvh_traverse_leaves(self.bvh4, ray, ray_tmin, ray_tmax, leaf_fn, stats);
+			break;
+		case AccelerationType::AT_BVH8:
+			wide_bvh_traverse_leaves(self.bvh8, ray, ray_tmin, ray_tmax, leaf_fn, stats);
+			break;
+		default:
+			bvh_traverse_leaves(self.bvh, ray, ray_tmin, ray_tmax, leaf_fn, stats);
+			break;
+	}
+
+	return best_hit;
+}
+
+void
+geometry_scene_intersect_packet(const GeometryScene& self, RayPacket& packet, GeometryHit* hits, TraversalStats* stats)
+{
+	for (uint32_t i = 0; i < packet.count; i++)
+		hits[i] = {};
+
+	if (!packet.coherent)
+	{
+		for (uint32_t i = 0; i < packet.count; i++)
+		{
+			hits[i] = geometry_scene_intersect(self, ray_packet_get_ray(packet, i), packet.tmin, packet.tmax[i], stats);
+			if (hits[i].hit)
+				packet.tmax[i] = hits[i].t;
+		}
+
+		return;
+	}
+
+	ray_packet_traverse_leaves(self.bvh, packet, [&](uint32_t offset, uint32_t count, uint32_t first_active) {
+		for (uint32_t i = first_active; i < packet.count; i++)
+		{
+			Ray ray = ray_packet_get_ray(packet, i);
+			_intersect_leaf(self, offset, count, ray, packet.tmin, packet.tmax[i], hits[i]);
+		}
+	}, stats);
+}
+
+const HitRecord
+geometry_scene_hit_record(const GeometryScene& self, const GeometryHit& hit, const Ray& ray)
+{
+	if (!hit.hit)
+		return {};
+
+	switch (hit.handle.type)
+	{
+		case HittableType::HT_SPHERE:
+			return _GeometryKernel<HittableType::HT_SPHERE>::hit_record(self, hit, ray);
+		case HittableType::HT_MESH:
+			return _GeometryKernel<HittableType::HT_MESH>::hit_record(self, hit, ray);
+		case HittableType::HT_INSTANCE:
+			return _GeometryKernel<HittableType::HT_INSTANCE>::hit_record(self, hit, ray);
+		default:
+			return {};
+	}
+}
+const HitRecord
+geometry_scene_hit(const GeometryScene& self, const Ray& ray, float ray_tmin, float ray_tmax, TraversalStats* stats)
+{
+	return geometry_scene_hit_record(self, geometry_scene_intersect(self, ray, ray_tmin, ray_tmax, stats), ray);
+}
@@ -14,7 +14,7 @@ hittable_list_hit(HittableList& hittable_list, const Ray& ray, float ray_tmin, f
 	float closest = ray_tmax;
 	for (auto& hittable : hittable_list)
 	{
-		HitRecord temp_record = hittable->hit(hittable, ray, ray_tmin, closest);
+		HitRecord temp_record = hittable->hit(hittable.get(), ray, ray_tmin, closest);
 		if (temp_record.hit)
 		{
 			closest = temp_record.t;
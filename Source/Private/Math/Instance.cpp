@@ -0,0 +1,77 @@
+#include <Math/Instance.hpp>
+
+static float
+_determinant(const Transform& transform)
+{
+	const float (*m)[4] = transform.m;
+
+	return
+		m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+		m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+		m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+static HitRecord
+_hit_impl(const Hittable* hittable, const Ray& ray, float ray_tmin, float ray_tmax)
+{
+	const Instance* instance = (const Instance*)hittable;
+
+	return instance_hit_record(*instance, instance_intersect(*instance, ray, ray_tmin, ray_tmax), ray);
+}
+
+static AABB
+_bounds_impl(const Hittable* hittable)
+{
+	const Instance* instance = (const Instance*)hittable;
+
+	return instance->bounding_box;
+}
+
+void
+instance_create(Instance& self, const TriangleMesh* mesh, const Transform& object_to_world)
+{
+	self.type = HittableType::HT_INSTANCE;
+
+	self.hit = _hit_impl;
+	self.bounds = _bounds_impl;
+
+	self.mesh = mesh;
+
+	instance_set_transform(self, object_to_world);
+}
+
+void
+instance_set_transform(Instance& self, const Transform& object_to_world)
+{
+	self.object_to_world = object_to_world;
+	self.world_to_object = transform_inverse(object_to_world);
+
+	self.bounding_box = transform_aabb(object_to_world, self.mesh->bounding_box);
+}
+
+const TriangleHit
+instance_intersect(const Instance& self, const Ray& ray, float ray_tmin, float ray_tmax, TraversalStats* stats)
+{
+	// The object space direction keeps the scale of the transform, so t is
+	// the same parameter along both rays and needs no conversion.
+	return triangle_mesh_intersect(*self.mesh, transform_ray(self.world_to_object, ray), ray_tmin, ray_tmax, stats);
+}
+const HitRecord
+instance_hit_record(const Instance& self, const TriangleHit& hit, const Ray& ray)
+{
+	HitRecord hit_record = triangle_mesh_hit_record(*self.mesh, hit, transform_ray(self.world_to_object, ray));
+	if (!hit_record.hit)
+		return hit_record;
+
+	hit_record.point = ray_point_at(ray, hit.t);
+
+	// The inverse transpose keeps the normal facing against the ray, but a
+	// mirroring transform reverses the winding that front_face refers to.
+	Vec3f normal = transform_normal(self.world_to_object, hit_record.normal);
+	hit_record.normal = vector_normalize(normal);
+
+	if (_determinant(self.object_to_world) < 0.0f)
+		hit_record.front_face = !hit_record.front_face;
+
+	return hit_record;
+}
@@ -0,0 +1,149 @@
+#include <Math/RayPacket.hpp>
+
+#include <cmath>
+#include <limits>
+#include <cassert>
+
+void
+ray_packet_create(RayPacket& self, const Vec3f& origin, float ray_tmin, float ray_tmax)
+{
+	self.origin = origin;
+	self.tmin = ray_tmin;
+	self.count = 0;
+
+	for (uint32_t i = 0; i < RAY_PACKET_SIZE; i++)
+		self.tmax[i] = ray_tmax;
+}
+void
+ray_packet_add(RayPacket& self, const Vec3f& direction)
+{
+	assert(self.count < RAY_PACKET_SIZE);
+
+	uint32_t index = self.count++;
+
+	self.direction_x[index] = direction.x;
+	self.direction_y[index] = direction.y;
+	self.direction_z[index] = direction.z;
+
+	self.inv_direction_x[index] = 1.0f / direction.x;
+	self.inv_direction_y[index] = 1.0f / direction.y;
+	self.inv_direction_z[index] = 1.0f / direction.z;
+}
+void
+ray_packet_finalize(RayPacket& self)
+{
+	const float inf = std::numeric_limits<float>::infinity();
+
+	self.mean_direction = { 0.0f, 0.0f, 0.0f };
+	self.inv_direction_min = { inf, inf, inf };
+	self.inv_direction_max = { -inf, -inf, -inf };
+
+	for (uint32_t i = 0; i < self.count; i++)
+	{
+		Vec3f inv_direction = { self.inv_direction_x[i], self.inv_direction_y[i], self.inv_direction_z[i] };
+
+		self.mean_direction += Vec3f{ self.direction_x[i], self.direction_y[i], self.direction_z[i] };
+
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			self.inv_direction_min[axis] = std::min(self.inv_direction_min[axis], inv_direction[axis]);
+			self.inv_direction_max[axis] = std::max(self.inv_direction_max[axis], inv_direction[axis]);
+		}
+	}
+
+	self.coherent = self.count > 0;
+	for (size_t axis = 0; axis < 3; axis++)
+	{
+		bool same_sign = (self.inv_direction_min[axis] > 0.0f) == (self.inv_direction_max[axis] > 0.0f);
+		bool finite = std::isfinite(self.inv_direction_min[axis]) && std::isfinite(self.inv_direction_max[axis]);
+
+		if (!same_sign || !finite)
+			self.coherent = false;
+	}
+
+	uint32_t padded_count = uint32_t(simd_round_up(self.count, SIMD_WIDTH));
+	for (uint32_t i = self.count; i < padded_count; i++)
+	{
+		self.direction_x[i] = self.direction_y[i] = self.direction_z[i] = 0.0f;
+		self.inv_direction_x[i] = self.inv_direction_y[i] = self.inv_direction_z[i] = 0.0f;
+
+		self.tmax[i] = -inf;
+	}
+}
+
+// Bounds the slab distances of every ray in the packet at once: with a shared
+// origin and the inverse directions confined to [min, max] on each axis, the
+// entry distance of any ray is at least the largest per-axis lower bound, and
+// its exit distance at most the smallest per-axis upper bound, widened by
+// AABB_FAR_SCALE as in aabb_intersect.
+bool
+ray_packet_cull(const RayPacket& self, const AABB& bounds, float packet_tmax)
+{
+	float t_entry = self.tmin;
+	float t_exit = packet_tmax;
+
+	for (size_t axis = 0; axis < 3; axis++)
+	{
+		float lo = self.inv_direction_min[axis];
+		float hi = self.inv_direction_max[axis];
+
+		float near_plane = (lo > 0.0f ? bounds.min[axis] : bounds.max[axis]) - self.origin[axis];
+		float far_plane = (lo > 0.0f ? bounds.max[axis] : bounds.min[axis]) - self.origin[axis];
+
+		t_entry = std::max(t_entry, std::min(near_plane * lo, near_plane * hi));
+		t_exit = std::min(t_exit, std::max(far_plane * lo, far_plane * hi) * AABB_FAR_SCALE);
+	}
+
+	return t_entry > t_exit;
+}
+
+uint32_t
+ray_packet_first_hit(const RayPacket& self, const AABB& bounds, uint32_t first)
+{
+	uint32_t i = first - first % SIMD_WIDTH;
+
+#if defined(SIMD_AVX2)
+	const __m256 min_x = _mm256_set1_ps(bounds.min.x - self.origin.x);
+	const __m256 min_y = _mm256_set1_ps(bounds.min.y - self.origin.y);
+	const __m256 min_z = _mm256_set1_ps(bounds.min.z - self.origin.z);
+	const __m256 max_x = _mm256_set1_ps(bounds.max.x - self.origin.x);
+	const __m256 max_y = _mm256_set1_ps(bounds.max.y - self.origin.y);
+	const __m256 max_z = _mm256_set1_ps(bounds.max.z - self.origin.z);
+
+	const __m256 tmin = _mm256_set1_ps(self.tmin);
+
+	for (; i < self.count; i += 8)
+	{
+		__m256 inv_x = _mm256_load_ps(self.inv_direction_x + i);
+		__m256 inv_y = _mm256_load_ps(self.inv_direction_y + i);
+		__m256 inv_z = _mm256_load_ps(self.inv_direction_z + i);
+
+		__m256 t0_x = _mm256_mul_ps(min_x, inv_x), t1_x = _mm256_mul_ps(max_x, inv_x);
+		__m256 t0_y = _mm256_mul_ps(min_y, inv_y), t1_y = _mm256_mul_ps(max_y, inv_y);
+		__m256 t0_z = _mm256_mul_ps(min_z, inv_z), t1_z = _mm256_mul_ps(max_z, inv_z);
+
+		__m256 entry = _mm256_max_ps(
+			_mm256_max_ps(_mm256_min_ps(t0_x, t1_x), _mm256_min_ps(t0_y, t1_y)),
+			_mm256_max_ps(_mm256_min_ps(t0_z, t1_z), tmin));
+		__m256 exit = _mm256_min_ps(
+			_mm256_min_ps(_mm256_max_ps(t0_x, t1_x), _mm256_max_ps(t0_y, t1_y)), _mm256_max_ps(t0_z, t1_z));
+		exit = _mm256_min_ps(_mm256_mul_ps(exit, _mm256_set1_ps(AABB_FAR_SCALE)), _mm256_load_ps(self.tmax + i));
+
+		uint32_t mask = uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(entry, exit, _CMP_LE_OQ)));
+		if (i < first)
+			mask &= ~0u << (first - i);
+
+		if (mask)
+			return std::min(self.count, i + simd_count_trailing_zeros(mask));
+	}
+#else
+	for (i = first; i < self.count; i++)
+	{
+		float t;
+		if (aabb_intersect(bounds, ray_packet_get_ray(self, i), { self.inv_direction_x[i], self.inv_direction_y[i], self.inv_direction_z[i] }, self.tmin, self.tmax[i], t))
+			return i;
+	}
+#endif
+
+	return self.count;
+}
@@ -0,0 +1,88 @@
+#ifndef RAY_PACKET_INL
+#define RAY_PACKET_INL
+
+#include <Math/RayPacket.hpp>
+
+#include <cassert>
+
+static inline Ray
+ray_packet_get_ray(const RayPacket& self, uint32_t index)
+{
+	return { self.origin, { self.direction_x[index], self.direction_y[index], self.direction_z[index] } };
+}
+
+// Traverses the binary BVH with the whole packet, carrying the index of the
+// first ray known to reach each node. Coherent packets first try to cull a node
+// with interval arithmetic, then search for the first ray that really hits it.
+// leaf_fn(offset, count, first_active) intersects rays [first_active, count)
+// and shrinks packet.tmax on hits.
+template<typename InLeafFn>
+inline void
+ray_packet_traverse_leaves(const BVH& bvh, RayPacket& packet, InLeafFn leaf_fn, TraversalStats* stats)
+{
+	if (stats)
+		stats->rays += packet.count;
+
+	if (bvh.nodes.empty() || !packet.count)
+		return;
+
+	struct StackEntry
+	{
+		uint32_t node;
+		uint32_t first_active;
+	};
+
+	StackEntry stack[BVH_MAX_DEPTH + 1];
+	size_t stack_size = 0;
+
+	float packet_tmax = packet.tmax[0];
+	for (uint32_t i = 1; i < packet.count; i++)
+		packet_tmax = std::max(packet_tmax, packet.tmax[i]);
+
+	stack[stack_size++] = { 0, 0 };
+	while (stack_size)
+	{
+		StackEntry entry = stack[--stack_size];
+		const BVHNode& node = bvh.nodes[entry.node];
+
+		if (packet.coherent && ray_packet_cull(packet, node.bounds, packet_tmax))
+			continue;
+
+		uint32_t first_active = ray_packet_first_hit(packet, node.bounds, entry.first_active);
+		if (first_active == packet.count)
+			continue;
+
+		if (node.count)
+		{
+			if (stats)
+				stats->leaves_visited++;
+
+			leaf_fn(node.offset, node.count, first_active);
+
+			packet_tmax = packet.tmax[0];
+			for (uint32_t i = 1; i < packet.count; i++)
+				packet_tmax = std::max(packet_tmax, packet.tmax[i]);
+
+			continue;
+		}
+
+		if (stats)
+			stats->nodes_visited++;
+
+		uint32_t near_child = node.offset;
+		uint32_t far_child = node.offset + 1;
+
+		Vec3f to_near = aabb_centroid(bvh.nodes[near_child].bounds) - packet.origin;
+		Vec3f to_far = aabb_centroid(bvh.nodes[far_child].bounds) - packet.origin;
+
+		if (vector_dot(to_far, packet.mean_direction) < vector_dot(to_near, packet.mean_direction))
+			std::swap(near_child, far_child);
+
+		assert(stack_size + 2 <= sizeof(stack) / sizeof(stack[0]));
+
+		stack[stack_size++] = { far_child, first_active };
+		stack[stack_size++] = { near_child, first_active };
+	}
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SIMD_INL
+#define SIMD_INL
+
+#include <Math/SIMD.hpp>
+
+#if defined(_WIN32)
+	#include <malloc.h>
+#endif
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+static inline void*
+simd_aligned_alloc(size_t size, size_t alignment)
+{
+	size = simd_round_up(size ? size : 1, alignment);
+
+#if defined(_WIN32)
+	return _aligned_malloc(size, alignment);
+#else
+	return aligned_alloc(alignment, size);
+#endif
+}
+static inline void
+simd_aligned_free(void* ptr)
+{
+#if defined(_WIN32)
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+static inline size_t
+simd_round_up(size_t count, size_t multiple)
+{
+	return (count + multiple - 1) / multiple * multiple;
+}
+
+static inline uint32_t
+simd_count_trailing_zeros(uint32_t mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return uint32_t(index);
+#else
+	return uint32_t(__builtin_ctz(mask));
+#endif
+}
+
+#endif
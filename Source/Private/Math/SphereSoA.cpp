@@ -0,0 +1,330 @@
+#include <Math/SphereSoA.hpp>
+
+#include <cstring>
+#include <limits>
+
+static float*
+_alloc_component(size_t capacity)
+{
+	size_t size = (simd_round_up(capacity, SIMD_WIDTH) + SIMD_WIDTH) * sizeof(float);
+
+	float* component = (float*)simd_aligned_alloc(size);
+	memset(component, 0, size);
+
+	return component;
+}
+
+static void
+_realloc_component(float*& component, size_t count, size_t capacity)
+{
+	float* new_component = _alloc_component(capacity);
+
+	if (component)
+		memcpy(new_component, component, count * sizeof(float));
+
+	simd_aligned_free(component);
+	component = new_component;
+}
+
+#if !defined(SIMD_AVX2) && !defined(SIMD_SSE2)
+static inline float
+_intersect_scalar(const SphereSoA& self, size_t index, const Ray& ray, float a)
+{
+	Vec3f ray_to_sphere = {
+		self.center_x[index] - ray.origin.x,
+		self.center_y[index] - ray.origin.y,
+		self.center_z[index] - ray.origin.z
+	};
+
+	float t_closest = vector_dot(ray.direction, ray_to_sphere) / a;
+	Vec3f offset = ray_to_sphere - t_closest * ray.direction;
+
+	float det = self.radius[index] * self.radius[index] - vector_length_squared(offset);
+	if (det < 0.0f)
+		return std::numeric_limits<float>::infinity();
+
+	float root = sqrtf(det / a);
+
+	if (t_closest - root >= 0.0f)
+		return t_closest - root;
+	if (t_closest + root >= 0.0f)
+		return 0.0f;
+
+	return std::numeric_limits<float>::infinity();
+}
+#endif
+
+void
+sphere_soa_create(SphereSoA& self, size_t capacity)
+{
+	memset(&self, 0, sizeof(SphereSoA));
+
+	sphere_soa_reserve(self, capacity ? capacity : SIMD_WIDTH);
+}
+void
+sphere_soa_destroy(SphereSoA& self)
+{
+	simd_aligned_free(self.center_x);
+	simd_aligned_free(self.center_y);
+	simd_aligned_free(self.center_z);
+	simd_aligned_free(self.radius);
+
+	memset(&self, 0, sizeof(SphereSoA));
+}
+
+void
+sphere_soa_reserve(SphereSoA& self, size_t capacity)
+{
+	if (capacity <= self.capacity)
+		return;
+
+	_realloc_component(self.center_x, self.count, capacity);
+	_realloc_component(self.center_y, self.count, capacity);
+	_realloc_component(self.center_z, self.count, capacity);
+	_realloc_component(self.radius, self.count, capacity);
+
+	self.capacity = capacity;
+}
+uint32_t
+sphere_soa_add(SphereSoA& self, float radius, Vec3f center)
+{
+	if (self.count == self.capacity)
+		sphere_soa_reserve(self, self.capacity ? self.capacity * 2 : SIMD_WIDTH);
+
+	size_t index = self.count++;
+
+	self.center_x[index] = center.x;
+	self.center_y[index] = center.y;
+	self.center_z[index] = center.z;
+	self.radius[index] = radius;
+
+	return uint32_t(index);
+}
+void
+sphere_soa_set(SphereSoA& self, uint32_t index, float radius, Vec3f center)
+{
+	self.center_x[index] = center.x;
+	self.center_y[index] = center.y;
+	self.center_z[index] = center.z;
+	self.radius[index] = radius;
+}
+void
+sphere_soa_clear(SphereSoA& self)
+{
+	self.count = 0;
+}
+
+const SphereSoAHit
+sphere_soa_intersect(const SphereSoA& self, const Ray& ray, float ray_tmin, float ray_tmax)
+{
+	return sphere_soa_intersect(self, 0, self.count, ray, ray_tmin, ray_tmax);
+}
+
+// Same root selection as bounding_sphere_intersect: the nearest non-negative
+// root, or zero when the origin lies inside the sphere. The discriminant is
+// taken from the distance between the center and the closest point on the ray,
+// r^2 - |oc - t_closest * d|^2, rather than b^2 - a*c, which cancels badly for
+// small spheres far from the ray origin and reports hits past the silhouette.
+const SphereSoAHit
+sphere_soa_intersect(const SphereSoA& self, size_t first, size_t count, const Ray& ray, float ray_tmin, float ray_tmax)
+{
+	const float inf = std::numeric_limits<float>::infinity();
+	const float a = vector_length_squared(ray.direction);
+
+	SphereSoAHit result { inf, 0, false };
+
+	size_t end = first + count;
+	size_t i = first;
+
+#if defined(SIMD_AVX2)
+	{
+		const __m256 origin_x = _mm256_set1_ps(ray.origin.x);
+		const __m256 origin_y = _mm256_set1_ps(ray.origin.y);
+		const __m256 origin_z = _mm256_set1_ps(ray.origin.z);
+
+		const __m256 direction_x = _mm256_set1_ps(ray.direction.x);
+		const __m256 direction_y = _mm256_set1_ps(ray.direction.y);
+		const __m256 direction_z = _mm256_set1_ps(ray.direction.z);
+
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 infinity = _mm256_set1_ps(inf);
+		const __m256 tmin = _mm256_set1_ps(ray_tmin);
+		const __m256 inv_a = _mm256_set1_ps(1.0f / a);
+
+		const __m256i lane_offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const __m256i end_index = _mm256_set1_epi32(int(end));
+
+		__m256 best_t = _mm256_set1_ps(ray_tmax);
+		__m256i best_index = _mm256_set1_epi32(-1);
+
+		for (; i < end; i += 8)
+		{
+			__m256i index = _mm256_add_epi32(_mm256_set1_epi32(int(i)), lane_offsets);
+
+			__m256 oc_x = _mm256_sub_ps(_mm256_loadu_ps(self.center_x + i), origin_x);
+			__m256 oc_y = _mm256_sub_ps(_mm256_loadu_ps(self.center_y + i), origin_y);
+			__m256 oc_z = _mm256_sub_ps(_mm256_loadu_ps(self.center_z + i), origin_z);
+			__m256 radius = _mm256_loadu_ps(self.radius + i);
+
+			__m256 t_closest = _mm256_mul_ps(direction_x, oc_x);
+			t_closest = _mm256_fmadd_ps(direction_y, oc_y, t_closest);
+			t_closest = _mm256_fmadd_ps(direction_z, oc_z, t_closest);
+			t_closest = _mm256_mul_ps(t_closest, inv_a);
+
+			__m256 offset_x = _mm256_fnmadd_ps(t_closest, direction_x, oc_x);
+			__m256 offset_y = _mm256_fnmadd_ps(t_closest, direction_y, oc_y);
+			__m256 offset_z = _mm256_fnmadd_ps(t_closest, direction_z, oc_z);
+
+			__m256 det = _mm256_mul_ps(radius, radius);
+			det = _mm256_fnmadd_ps(offset_x, offset_x, det);
+			det = _mm256_fnmadd_ps(offset_y, offset_y, det);
+			det = _mm256_fnmadd_ps(offset_z, offset_z, det);
+
+			__m256 root = _mm256_sqrt_ps(_mm256_mul_ps(_mm256_max_ps(det, zero), inv_a));
+
+			__m256 root_near = _mm256_sub_ps(t_closest, root);
+			__m256 root_far = _mm256_add_ps(t_closest, root);
+
+			__m256 t = _mm256_blendv_ps(infinity, zero, _mm256_cmp_ps(root_far, zero, _CMP_GE_OQ));
+			t = _mm256_blendv_ps(t, root_near, _mm256_cmp_ps(root_near, zero, _CMP_GE_OQ));
+
+			__m256 mask = _mm256_cmp_ps(det, zero, _CMP_GE_OQ);
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, tmin, _CMP_GT_OQ));
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, best_t, _CMP_LT_OQ));
+			mask = _mm256_and_ps(mask, _mm256_castsi256_ps(_mm256_cmpgt_epi32(end_index, index)));
+
+			best_t = _mm256_blendv_ps(best_t, t, mask);
+			best_index = _mm256_castps_si256(_mm256_blendv_ps(
+				_mm256_castsi256_ps(best_index), _mm256_castsi256_ps(index), mask));
+		}
+
+		alignas(32) float lane_t[8];
+		alignas(32) int32_t lane_index[8];
+
+		_mm256_store_ps(lane_t, best_t);
+		_mm256_store_si256((__m256i*)lane_index, best_index);
+
+		for (int lane = 0; lane < 8; lane++)
+		{
+			if (lane_index[lane] >= 0 && lane_t[lane] < result.t)
+				result = { lane_t[lane], uint32_t(lane_index[lane]), true };
+		}
+	}
+#elif defined(SIMD_SSE2)
+	{
+		const __m128 origin_x = _mm_set1_ps(ray.origin.x);
+		const __m128 origin_y = _mm_set1_ps(ray.origin.y);
+		const __m128 origin_z = _mm_set1_ps(ray.origin.z);
+
+		const __m128 direction_x = _mm_set1_ps(ray.direction.x);
+		const __m128 direction_y = _mm_set1_ps(ray.direction.y);
+		const __m128 direction_z = _mm_set1_ps(ray.direction.z);
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 infinity = _mm_set1_ps(inf);
+		const __m128 tmin = _mm_set1_ps(ray_tmin);
+		const __m128 inv_a = _mm_set1_ps(1.0f / a);
+
+		const __m128i lane_offsets = _mm_setr_epi32(0, 1, 2, 3);
+		const __m128i end_index = _mm_set1_epi32(int(end));
+
+		__m128 best_t = _mm_set1_ps(ray_tmax);
+		__m128i best_index = _mm_set1_epi32(-1);
+
+		for (; i < end; i += 4)
+		{
+			__m128i index = _mm_add_epi32(_mm_set1_epi32(int(i)), lane_offsets);
+
+			__m128 oc_x = _mm_sub_ps(_mm_loadu_ps(self.center_x + i), origin_x);
+			__m128 oc_y = _mm_sub_ps(_mm_loadu_ps(self.center_y + i), origin_y);
+			__m128 oc_z = _mm_sub_ps(_mm_loadu_ps(self.center_z + i), origin_z);
+			__m128 radius = _mm_loadu_ps(self.radius + i);
+
+			__m128 t_closest = _mm_mul_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(direction_x, oc_x), _mm_mul_ps(direction_y, oc_y)), _mm_mul_ps(direction_z, oc_z)), inv_a);
+
+			__m128 offset_x = _mm_sub_ps(oc_x, _mm_mul_ps(t_closest, direction_x));
+			__m128 offset_y = _mm_sub_ps(oc_y, _mm_mul_ps(t_closest, direction_y));
+			__m128 offset_z = _mm_sub_ps(oc_z, _mm_mul_ps(t_closest, direction_z));
+
+			__m128 det = _mm_sub_ps(_mm_mul_ps(radius, radius), _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(offset_x, offset_x), _mm_mul_ps(offset_y, offset_y)), _mm_mul_ps(offset_z, offset_z)));
+			__m128 root = _mm_sqrt_ps(_mm_mul_ps(_mm_max_ps(det, zero), inv_a));
+
+			__m128 root_near = _mm_sub_ps(t_closest, root);
+			__m128 root_far = _mm_add_ps(t_closest, root);
+
+			__m128 far_mask = _mm_cmpge_ps(root_far, zero);
+			__m128 near_mask = _mm_cmpge_ps(root_near, zero);
+
+			__m128 t = _mm_or_ps(_mm_and_ps(far_mask, zero), _mm_andnot_ps(far_mask, infinity));
+			t = _mm_or_ps(_mm_and_ps(near_mask, root_near), _mm_andnot_ps(near_mask, t));
+
+			__m128 mask = _mm_cmpge_ps(det, zero);
+			mask = _mm_and_ps(mask, _mm_cmpgt_ps(t, tmin));
+			mask = _mm_and_ps(mask, _mm_cmplt_ps(t, best_t));
+			mask = _mm_and_ps(mask, _mm_castsi128_ps(_mm_cmpgt_epi32(end_index, index)));
+
+			best_t = _mm_or_ps(_mm_and_ps(mask, t), _mm_andnot_ps(mask, best_t));
+			best_index = _mm_or_si128(
+				_mm_and_si128(_mm_castps_si128(mask), index),
+				_mm_andnot_si128(_mm_castps_si128(mask), best_index));
+		}
+
+		alignas(16) float lane_t[4];
+		alignas(16) int32_t lane_index[4];
+
+		_mm_store_ps(lane_t, best_t);
+		_mm_store_si128((__m128i*)lane_index, best_index);
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if (lane_index[lane] >= 0 && lane_t[lane] < result.t)
+				result = { lane_t[lane], uint32_t(lane_index[lane]), true };
+		}
+	}
+#else
+	{
+		float closest = ray_tmax;
+		for (; i < end; i++)
+		{
+			float t = _intersect_scalar(self, i, ray, a);
+			if (t > ray_tmin && t < closest)
+			{
+				closest = t;
+				result = { t, uint32_t(i), true };
+			}
+		}
+	}
+#endif
+
+	return result;
+}
+
+const HitRecord
+sphere_soa_hit_record(const SphereSoA& self, uint32_t index, const Ray& ray, float t)
+{
+	HitRecord hit_record {};
+
+	hit_record.t = t;
+	hit_record.hit = true;
+	hit_record.point = ray_point_at(ray, t);
+
+	Vec3f center = { self.center_x[index], self.center_y[index], self.center_z[index] };
+
+	Vec3f normal = hit_record.point - center;
+	normal = vector_normalize(normal);
+
+	if (vector_dot(ray.direction, normal) > 0.0f)
+	{
+		hit_record.normal = -normal;
+		hit_record.front_face = false;
+	}
+	else
+	{
+		hit_record.normal = normal;
+		hit_record.front_face = true;
+	}
+
+	return hit_record;
+}
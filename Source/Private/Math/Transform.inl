@@ -0,0 +1,162 @@
+#ifndef TRANSFORM_INL
+#define TRANSFORM_INL
+
+#include <Math/Transform.hpp>
+
+#include <cmath>
+
+static inline Transform
+transform_identity()
+{
+	return { {
+		{ 1.0f, 0.0f, 0.0f, 0.0f },
+		{ 0.0f, 1.0f, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f, 0.0f },
+	} };
+}
+static inline Transform
+transform_translate(const Vec3f& translation)
+{
+	Transform result = transform_identity();
+	for (size_t i = 0; i < 3; i++)
+		result.m[i][3] = translation[i];
+
+	return result;
+}
+static inline Transform
+transform_scale(const Vec3f& scale)
+{
+	Transform result = transform_identity();
+	for (size_t i = 0; i < 3; i++)
+		result.m[i][i] = scale[i];
+
+	return result;
+}
+static inline Transform
+transform_rotate(const Vec3f& axis, float radians)
+{
+	Vec3f a = axis;
+	a = vector_normalize(a);
+
+	float s = std::sin(radians);
+	float c = std::cos(radians);
+	float t = 1.0f - c;
+
+	return { {
+		{ t * a.x * a.x + c,       t * a.x * a.y - s * a.z, t * a.x * a.z + s * a.y, 0.0f },
+		{ t * a.x * a.y + s * a.z, t * a.y * a.y + c,       t * a.y * a.z - s * a.x, 0.0f },
+		{ t * a.x * a.z - s * a.y, t * a.y * a.z + s * a.x, t * a.z * a.z + c,       0.0f },
+	} };
+}
+
+static inline Transform
+transform_multiply(const Transform& lhs, const Transform& rhs)
+{
+	Transform result;
+	for (size_t i = 0; i < 3; i++)
+	{
+		for (size_t j = 0; j < 4; j++)
+		{
+			result.m[i][j] =
+				lhs.m[i][0] * rhs.m[0][j] +
+				lhs.m[i][1] * rhs.m[1][j] +
+				lhs.m[i][2] * rhs.m[2][j];
+		}
+
+		result.m[i][3] += lhs.m[i][3];
+	}
+
+	return result;
+}
+static inline Transform
+transform_inverse(const Transform& self)
+{
+	const float (*m)[4] = self.m;
+
+	// Inverse of the linear part by cofactors, then the translation is moved
+	// through it.
+	float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+	float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+	float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+
+	float inv_det = 1.0f / (m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02);
+
+	Transform result;
+	result.m[0][0] = c00 * inv_det;
+	result.m[1][0] = c01 * inv_det;
+	result.m[2][0] = c02 * inv_det;
+	result.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det;
+	result.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det;
+	result.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det;
+	result.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det;
+	result.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det;
+	result.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det;
+
+	for (size_t i = 0; i < 3; i++)
+	{
+		result.m[i][3] = -(
+			result.m[i][0] * m[0][3] +
+			result.m[i][1] * m[1][3] +
+			result.m[i][2] * m[2][3]);
+	}
+
+	return result;
+}
+
+static inline Vec3f
+transform_point(const Transform& self, const Vec3f& point)
+{
+	Vec3f result;
+	for (size_t i = 0; i < 3; i++)
+		result[i] = self.m[i][0] * point.x + self.m[i][1] * point.y + self.m[i][2] * point.z + self.m[i][3];
+
+	return result;
+}
+static inline Vec3f
+transform_vector(const Transform& self, const Vec3f& vector)
+{
+	Vec3f result;
+	for (size_t i = 0; i < 3; i++)
+		result[i] = self.m[i][0] * vector.x + self.m[i][1] * vector.y + self.m[i][2] * vector.z;
+
+	return result;
+}
+static inline Vec3f
+transform_normal(const Transform& inverse, const Vec3f& normal)
+{
+	Vec3f result;
+	for (size_t i = 0; i < 3; i++)
+		result[i] = inverse.m[0][i] * normal.x + inverse.m[1][i] * normal.y + inverse.m[2][i] * normal.z;
+
+	return result;
+}
+
+static inline Ray
+transform_ray(const Transform& self, const Ray& ray)
+{
+	return { transform_point(self, ray.origin), transform_vector(self, ray.direction) };
+}
+static inline AABB
+transform_aabb(const Transform& self, const AABB& aabb)
+{
+	// Arvo's method: every output extent is the sum of the extremes each
+	// input axis contributes, starting from the translation.
+	AABB result;
+	for (size_t i = 0; i < 3; i++)
+	{
+		result.min[i] = result.max[i] = self.m[i][3];
+
+		for (size_t j = 0; j < 3; j++)
+		{
+			float a = self.m[i][j] * aabb.min[j];
+			float b = self.m[i][j] * aabb.max[j];
+
+			result.min[i] += std::min(a, b);
+			result.max[i] += std::max(a, b);
+		}
+	}
+
+	return result;
+}
+
+#endif
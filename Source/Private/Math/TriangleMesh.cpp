@@ -0,0 +1,532 @@
+#include <Math/TriangleMesh.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// Per-ray constants of the watertight test (Woop, Benthin, Wald 2013). The
+// dominant direction axis becomes z, and the ray is sheared so that it runs
+// along +z through the origin. Edge functions are then evaluated in 2D, and
+// edges shared by two triangles produce exactly negated values. This is why
+// the file is built without floating point contraction.
+struct _WatertightRay
+{
+	int kx, ky, kz;
+	float sx, sy, sz;
+
+	Vec3f origin;
+};
+
+static _WatertightRay
+_watertight_ray(const Ray& ray)
+{
+	_WatertightRay result;
+
+	result.kz = 0;
+	for (int axis = 1; axis < 3; axis++)
+		if (std::abs(ray.direction[axis]) > std::abs(ray.direction[result.kz]))
+			result.kz = axis;
+
+	result.kx = (result.kz + 1) % 3;
+	result.ky = (result.kx + 1) % 3;
+
+	if (ray.direction[result.kz] < 0.0f)
+		std::swap(result.kx, result.ky);
+
+	result.sx = ray.direction[result.kx] / ray.direction[result.kz];
+	result.sy = ray.direction[result.ky] / ray.direction[result.kz];
+	result.sz = 1.0f / ray.direction[result.kz];
+
+	result.origin = ray.origin;
+
+	return result;
+}
+
+static void
+_barycentrics(const TriangleSoA& self, size_t index, const _WatertightRay& ray, float& u, float& v)
+{
+	const float* v0[3] = { self.v0_x, self.v0_y, self.v0_z };
+	const float* v1[3] = { self.v1_x, self.v1_y, self.v1_z };
+	const float* v2[3] = { self.v2_x, self.v2_y, self.v2_z };
+
+	float ax = v0[ray.kx][index] - ray.origin[ray.kx], ay = v0[ray.ky][index] - ray.origin[ray.ky], az = v0[ray.kz][index] - ray.origin[ray.kz];
+	float bx = v1[ray.kx][index] - ray.origin[ray.kx], by = v1[ray.ky][index] - ray.origin[ray.ky], bz = v1[ray.kz][index] - ray.origin[ray.kz];
+	float cx = v2[ray.kx][index] - ray.origin[ray.kx], cy = v2[ray.ky][index] - ray.origin[ray.ky], cz = v2[ray.kz][index] - ray.origin[ray.kz];
+
+	ax -= ray.sx * az; ay -= ray.sy * az;
+	bx -= ray.sx * bz; by -= ray.sy * bz;
+	cx -= ray.sx * cz; cy -= ray.sy * cz;
+
+	float edge_u = cx * by - cy * bx;
+	float edge_v = ax * cy - ay * cx;
+	float edge_w = bx * ay - by * ax;
+
+	float det = edge_u + edge_v + edge_w;
+
+	u = edge_v / det;
+	v = edge_w / det;
+}
+
+#if !defined(SIMD_AVX2) && !defined(SIMD_SSE2)
+static inline float
+_intersect_scalar(const TriangleSoA& self, size_t index, const _WatertightRay& ray)
+{
+	const float inf = std::numeric_limits<float>::infinity();
+
+	const float* v0[3] = { self.v0_x, self.v0_y, self.v0_z };
+	const float* v1[3] = { self.v1_x, self.v1_y, self.v1_z };
+	const float* v2[3] = { self.v2_x, self.v2_y, self.v2_z };
+
+	float ax = v0[ray.kx][index] - ray.origin[ray.kx], ay = v0[ray.ky][index] - ray.origin[ray.ky], az = v0[ray.kz][index] - ray.origin[ray.kz];
+	float bx = v1[ray.kx][index] - ray.origin[ray.kx], by = v1[ray.ky][index] - ray.origin[ray.ky], bz = v1[ray.kz][index] - ray.origin[ray.kz];
+	float cx = v2[ray.kx][index] - ray.origin[ray.kx], cy = v2[ray.ky][index] - ray.origin[ray.ky], cz = v2[ray.kz][index] - ray.origin[ray.kz];
+
+	ax -= ray.sx * az; ay -= ray.sy * az;
+	bx -= ray.sx * bz; by -= ray.sy * bz;
+	cx -= ray.sx * cz; cy -= ray.sy * cz;
+
+	float edge_u = cx * by - cy * bx;
+	float edge_v = ax * cy - ay * cx;
+	float edge_w = bx * ay - by * ax;
+
+	if ((edge_u < 0.0f || edge_v < 0.0f || edge_w < 0.0f) && (edge_u > 0.0f || edge_v > 0.0f || edge_w > 0.0f))
+		return inf;
+
+	float det = edge_u + edge_v + edge_w;
+	if (det == 0.0f)
+		return inf;
+
+	float t = (edge_u * ray.sz * az + edge_v * ray.sz * bz + edge_w * ray.sz * cz) / det;
+	return t;
+}
+#endif
+
+static float*
+_alloc_component(size_t count)
+{
+	size_t size = (simd_round_up(count, SIMD_WIDTH) + SIMD_WIDTH) * sizeof(float);
+
+	float* component = (float*)simd_aligned_alloc(size);
+	memset(component, 0, size);
+
+	return component;
+}
+
+static void
+_free_triangles(TriangleSoA& self)
+{
+	float** components[] = {
+		&self.v0_x, &self.v0_y, &self.v0_z,
+		&self.v1_x, &self.v1_y, &self.v1_z,
+		&self.v2_x, &self.v2_y, &self.v2_z
+	};
+
+	for (float** component : components)
+	{
+		simd_aligned_free(*component);
+		*component = nullptr;
+	}
+
+	free(self.primitive);
+
+	self.primitive = nullptr;
+	self.count = 0;
+}
+
+// Drops the render data, freeing it unless it belongs to someone else.
+static void
+_release(TriangleMesh& self)
+{
+	if (self.is_external)
+		memset(&self.triangles, 0, sizeof(TriangleSoA));
+	else
+		_free_triangles(self.triangles);
+
+	wide_bvh_clear(self.wide_bvh);
+
+	self.nodes = nullptr;
+	self.node_count = 0;
+	self.is_external = false;
+}
+
+static HitRecord
+_hit_impl(const Hittable* hittable, const Ray& ray, float ray_tmin, float ray_tmax)
+{
+	const TriangleMesh* mesh = (const TriangleMesh*)hittable;
+
+	return triangle_mesh_hit_record(*mesh, triangle_mesh_intersect(*mesh, ray, ray_tmin, ray_tmax), ray);
+}
+
+static AABB
+_bounds_impl(const Hittable* hittable)
+{
+	const TriangleMesh* mesh = (const TriangleMesh*)hittable;
+
+	return mesh->bounding_box;
+}
+
+void
+triangle_mesh_create(TriangleMesh& self)
+{
+	self.type = HittableType::HT_MESH;
+
+	self.hit = _hit_impl;
+	self.bounds = _bounds_impl;
+
+	memset(&self.triangles, 0, sizeof(TriangleSoA));
+
+	self.nodes = nullptr;
+	self.node_count = 0;
+	self.is_external = false;
+
+	self.positions.clear();
+	self.indices.clear();
+
+	self.bounding_box = aabb_empty();
+}
+void
+triangle_mesh_create(TriangleMesh& self, const Vec3f* positions, size_t vertex_count, const uint32_t* indices, size_t index_count)
+{
+	triangle_mesh_create(self);
+
+	self.positions.assign(positions, positions + vertex_count);
+	self.indices.assign(indices, indices + index_count);
+
+	triangle_mesh_build(self);
+}
+void
+triangle_mesh_create(TriangleMesh& self, const AABB& bounds, const MeshBVHNode* nodes, size_t node_count, const TriangleSoA& triangles)
+{
+	triangle_mesh_create(self);
+
+	self.bounding_box = bounds;
+	self.triangles = triangles;
+
+	self.nodes = nodes;
+	self.node_count = node_count;
+	self.is_external = true;
+}
+void
+triangle_mesh_destroy(TriangleMesh& self)
+{
+	_release(self);
+
+	bvh_clear(self.bvh);
+
+	self.positions.clear();
+	self.indices.clear();
+}
+
+void
+triangle_mesh_build(TriangleMesh& self)
+{
+	size_t triangle_count = self.indices.size() / 3;
+
+	std::vector<AABB> bounds(triangle_count);
+
+	self.bounding_box = aabb_empty();
+	for (size_t i = 0; i < triangle_count; i++)
+	{
+		bounds[i] = aabb_empty();
+		for (size_t corner = 0; corner < 3; corner++)
+			aabb_expand(bounds[i], self.positions[self.indices[i * 3 + corner]]);
+
+		aabb_expand(self.bounding_box, bounds[i]);
+	}
+
+	bvh_build(self.bvh, bounds.data(), triangle_count);
+
+	_release(self);
+
+	TriangleSoA& triangles = self.triangles;
+
+	float** components[] = {
+		&triangles.v0_x, &triangles.v0_y, &triangles.v0_z,
+		&triangles.v1_x, &triangles.v1_y, &triangles.v1_z,
+		&triangles.v2_x, &triangles.v2_y, &triangles.v2_z
+	};
+
+	for (float** component : components)
+		*component = _alloc_component(triangle_count);
+
+	triangles.primitive = (uint32_t*)malloc(triangle_count * sizeof(uint32_t));
+	triangles.count = triangle_count;
+
+	for (size_t i = 0; i < triangle_count; i++)
+	{
+		uint32_t primitive = self.bvh.indices[i];
+		triangles.primitive[i] = primitive;
+
+		for (size_t corner = 0; corner < 3; corner++)
+		{
+			const Vec3f& position = self.positions[self.indices[primitive * 3 + corner]];
+
+			(*components[corner * 3 + 0])[i] = position.x;
+			(*components[corner * 3 + 1])[i] = position.y;
+			(*components[corner * 3 + 2])[i] = position.z;
+		}
+
+		self.bvh.indices[i] = uint32_t(i);
+	}
+
+	wide_bvh_build(self.wide_bvh, self.bvh);
+
+	self.nodes = self.wide_bvh.nodes.data();
+	self.node_count = self.wide_bvh.nodes.size();
+}
+
+size_t
+triangle_mesh_get_triangle_count(const TriangleMesh& self)
+{
+	return self.triangles.count;
+}
+
+const TriangleHit
+triangle_mesh_intersect(const TriangleMesh& self, const Ray& ray, float ray_tmin, float ray_tmax, TraversalStats* stats)
+{
+	TriangleHit best_hit {};
+
+	wide_bvh_traverse_leaves(self.nodes, self.node_count, ray, ray_tmin, ray_tmax, [&](uint32_t offset, uint32_t count, float tmin, float& tmax) {
+		TriangleHit hit = triangle_soa_intersect(self.triangles, offset, count, ray, tmin, tmax);
+		if (!hit.hit)
+			return false;
+
+		tmax = hit.t;
+		best_hit = hit;
+
+		return true;
+	}, stats);
+
+	return best_hit;
+}
+const HitRecord
+triangle_mesh_hit_record(const TriangleMesh& self, const TriangleHit& hit, const Ray& ray)
+{
+	HitRecord hit_record {};
+
+	if (!hit.hit)
+		return hit_record;
+
+	// The leaf ordered copy is what was intersected, and is all that external
+	// meshes have.
+	const TriangleSoA& triangles = self.triangles;
+
+	Vec3f v0 = { triangles.v0_x[hit.index], triangles.v0_y[hit.index], triangles.v0_z[hit.index] };
+	Vec3f v1 = { triangles.v1_x[hit.index], triangles.v1_y[hit.index], triangles.v1_z[hit.index] };
+	Vec3f v2 = { triangles.v2_x[hit.index], triangles.v2_y[hit.index], triangles.v2_z[hit.index] };
+
+	hit_record.t = hit.t;
+	hit_record.u = hit.u;
+	hit_record.v = hit.v;
+	hit_record.hit = true;
+	hit_record.point = ray_point_at(ray, hit.t);
+
+	Vec3f normal = vector_cross(v1 - v0, v2 - v0);
+	normal = vector_normalize(normal);
+
+	if (vector_dot(ray.direction, normal) > 0.0f)
+	{
+		hit_record.normal = -normal;
+		hit_record.front_face = false;
+	}
+	else
+	{
+		hit_record.normal = normal;
+		hit_record.front_face = true;
+	}
+
+	return hit_record;
+}
+
+const TriangleHit
+triangle_soa_intersect(const TriangleSoA& self, size_t first, size_t count, const Ray& ray, float ray_tmin, float ray_tmax)
+{
+	const float inf = std::numeric_limits<float>::infinity();
+
+	_WatertightRay wray = _watertight_ray(ray);
+
+	TriangleHit result { inf, 0.0f, 0.0f, 0, false };
+
+	size_t end = first + count;
+	size_t i = first;
+
+#if defined(SIMD_AVX2)
+	{
+		const float* v0[3] = { self.v0_x, self.v0_y, self.v0_z };
+		const float* v1[3] = { self.v1_x, self.v1_y, self.v1_z };
+		const float* v2[3] = { self.v2_x, self.v2_y, self.v2_z };
+
+		const __m256 origin_x = _mm256_set1_ps(wray.origin[wray.kx]);
+		const __m256 origin_y = _mm256_set1_ps(wray.origin[wray.ky]);
+		const __m256 origin_z = _mm256_set1_ps(wray.origin[wray.kz]);
+
+		const __m256 sx = _mm256_set1_ps(wray.sx);
+		const __m256 sy = _mm256_set1_ps(wray.sy);
+		const __m256 sz = _mm256_set1_ps(wray.sz);
+
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 tmin = _mm256_set1_ps(ray_tmin);
+
+		const __m256i lane_offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const __m256i end_index = _mm256_set1_epi32(int(end));
+
+		__m256 best_t = _mm256_set1_ps(ray_tmax);
+		__m256i best_index = _mm256_set1_epi32(-1);
+
+		for (; i < end; i += 8)
+		{
+			__m256i index = _mm256_add_epi32(_mm256_set1_epi32(int(i)), lane_offsets);
+
+			__m256 az = _mm256_sub_ps(_mm256_loadu_ps(v0[wray.kz] + i), origin_z);
+			__m256 bz = _mm256_sub_ps(_mm256_loadu_ps(v1[wray.kz] + i), origin_z);
+			__m256 cz = _mm256_sub_ps(_mm256_loadu_ps(v2[wray.kz] + i), origin_z);
+
+			__m256 ax = _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(v0[wray.kx] + i), origin_x), _mm256_mul_ps(sx, az));
+			__m256 ay = _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(v0[wray.ky] + i), origin_y), _mm256_mul_ps(sy, az));
+			__m256 bx = _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(v1[wray.kx] + i), origin_x), _mm256_mul_ps(sx, bz));
+			__m256 by = _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(v1[wray.ky] + i), origin_y), _mm256_mul_ps(sy, bz));
+			__m256 cx = _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(v2[wray.kx] + i), origin_x), _mm256_mul_ps(sx, cz));
+			__m256 cy = _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(v2[wray.ky] + i), origin_y), _mm256_mul_ps(sy, cz));
+
+			__m256 edge_u = _mm256_sub_ps(_mm256_mul_ps(cx, by), _mm256_mul_ps(cy, bx));
+			__m256 edge_v = _mm256_sub_ps(_mm256_mul_ps(ax, cy), _mm256_mul_ps(ay, cx));
+			__m256 edge_w = _mm256_sub_ps(_mm256_mul_ps(bx, ay), _mm256_mul_ps(by, ax));
+
+			__m256 any_negative = _mm256_or_ps(_mm256_or_ps(
+				_mm256_cmp_ps(edge_u, zero, _CMP_LT_OQ), _mm256_cmp_ps(edge_v, zero, _CMP_LT_OQ)),
+				_mm256_cmp_ps(edge_w, zero, _CMP_LT_OQ));
+			__m256 any_positive = _mm256_or_ps(_mm256_or_ps(
+				_mm256_cmp_ps(edge_u, zero, _CMP_GT_OQ), _mm256_cmp_ps(edge_v, zero, _CMP_GT_OQ)),
+				_mm256_cmp_ps(edge_w, zero, _CMP_GT_OQ));
+
+			__m256 det = _mm256_add_ps(_mm256_add_ps(edge_u, edge_v), edge_w);
+
+			__m256 scaled_t = _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(edge_u, _mm256_mul_ps(sz, az)),
+				_mm256_mul_ps(edge_v, _mm256_mul_ps(sz, bz))),
+				_mm256_mul_ps(edge_w, _mm256_mul_ps(sz, cz)));
+
+			__m256 t = _mm256_div_ps(scaled_t, det);
+
+			__m256 mask = _mm256_andnot_ps(_mm256_and_ps(any_negative, any_positive),
+				_mm256_cmp_ps(det, zero, _CMP_NEQ_OQ));
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, tmin, _CMP_GT_OQ));
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, best_t, _CMP_LT_OQ));
+			mask = _mm256_and_ps(mask, _mm256_castsi256_ps(_mm256_cmpgt_epi32(end_index, index)));
+
+			best_t = _mm256_blendv_ps(best_t, t, mask);
+			best_index = _mm256_castps_si256(_mm256_blendv_ps(
+				_mm256_castsi256_ps(best_index), _mm256_castsi256_ps(index), mask));
+		}
+
+		alignas(32) float lane_t[8];
+		alignas(32) int32_t lane_index[8];
+
+		_mm256_store_ps(lane_t, best_t);
+		_mm256_store_si256((__m256i*)lane_index, best_index);
+
+		for (int lane = 0; lane < 8; lane++)
+		{
+			if (lane_index[lane] >= 0 && lane_t[lane] < result.t)
+				result = { lane_t[lane], 0.0f, 0.0f, uint32_t(lane_index[lane]), true };
+		}
+	}
+#elif defined(SIMD_SSE2)
+	{
+		const float* v0[3] = { self.v0_x, self.v0_y, self.v0_z };
+		const float* v1[3] = { self.v1_x, self.v1_y, self.v1_z };
+		const float* v2[3] = { self.v2_x, self.v2_y, self.v2_z };
+
+		const __m128 origin_x = _mm_set1_ps(wray.origin[wray.kx]);
+		const __m128 origin_y = _mm_set1_ps(wray.origin[wray.ky]);
+		const __m128 origin_z = _mm_set1_ps(wray.origin[wray.kz]);
+
+		const __m128 sx = _mm_set1_ps(wray.sx);
+		const __m128 sy = _mm_set1_ps(wray.sy);
+		const __m128 sz = _mm_set1_ps(wray.sz);
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 tmin = _mm_set1_ps(ray_tmin);
+
+		const __m128i lane_offsets = _mm_setr_epi32(0, 1, 2, 3);
+		const __m128i end_index = _mm_set1_epi32(int(end));
+
+		__m128 best_t = _mm_set1_ps(ray_tmax);
+		__m128i best_index = _mm_set1_epi32(-1);
+
+		for (; i < end; i += 4)
+		{
+			__m128i index = _mm_add_epi32(_mm_set1_epi32(int(i)), lane_offsets);
+
+			__m128 az = _mm_sub_ps(_mm_loadu_ps(v0[wray.kz] + i), origin_z);
+			__m128 bz = _mm_sub_ps(_mm_loadu_ps(v1[wray.kz] + i), origin_z);
+			__m128 cz = _mm_sub_ps(_mm_loadu_ps(v2[wray.kz] + i), origin_z);
+
+			__m128 ax = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(v0[wray.kx] + i), origin_x), _mm_mul_ps(sx, az));
+			__m128 ay = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(v0[wray.ky] + i), origin_y), _mm_mul_ps(sy, az));
+			__m128 bx = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(v1[wray.kx] + i), origin_x), _mm_mul_ps(sx, bz));
+			__m128 by = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(v1[wray.ky] + i), origin_y), _mm_mul_ps(sy, bz));
+			__m128 cx = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(v2[wray.kx] + i), origin_x), _mm_mul_ps(sx, cz));
+			__m128 cy = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(v2[wray.ky] + i), origin_y), _mm_mul_ps(sy, cz));
+
+			__m128 edge_u = _mm_sub_ps(_mm_mul_ps(cx, by), _mm_mul_ps(cy, bx));
+			__m128 edge_v = _mm_sub_ps(_mm_mul_ps(ax, cy), _mm_mul_ps(ay, cx));
+			__m128 edge_w = _mm_sub_ps(_mm_mul_ps(bx, ay), _mm_mul_ps(by, ax));
+
+			__m128 any_negative = _mm_or_ps(_mm_or_ps(
+				_mm_cmplt_ps(edge_u, zero), _mm_cmplt_ps(edge_v, zero)), _mm_cmplt_ps(edge_w, zero));
+			__m128 any_positive = _mm_or_ps(_mm_or_ps(
+				_mm_cmpgt_ps(edge_u, zero), _mm_cmpgt_ps(edge_v, zero)), _mm_cmpgt_ps(edge_w, zero));
+
+			__m128 det = _mm_add_ps(_mm_add_ps(edge_u, edge_v), edge_w);
+
+			__m128 scaled_t = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(edge_u, _mm_mul_ps(sz, az)),
+				_mm_mul_ps(edge_v, _mm_mul_ps(sz, bz))),
+				_mm_mul_ps(edge_w, _mm_mul_ps(sz, cz)));
+
+			__m128 t = _mm_div_ps(scaled_t, det);
+
+			__m128 mask = _mm_andnot_ps(_mm_and_ps(any_negative, any_positive), _mm_cmpneq_ps(det, zero));
+			mask = _mm_and_ps(mask, _mm_cmpgt_ps(t, tmin));
+			mask = _mm_and_ps(mask, _mm_cmplt_ps(t, best_t));
+			mask = _mm_and_ps(mask, _mm_castsi128_ps(_mm_cmpgt_epi32(end_index, index)));
+
+			best_t = _mm_or_ps(_mm_and_ps(mask, t), _mm_andnot_ps(mask, best_t));
+			best_index = _mm_or_si128(
+				_mm_and_si128(_mm_castps_si128(mask), index),
+				_mm_andnot_si128(_mm_castps_si128(mask), best_index));
+		}
+
+		alignas(16) float lane_t[4];
+		alignas(16) int32_t lane_index[4];
+
+		_mm_store_ps(lane_t, best_t);
+		_mm_store_si128((__m128i*)lane_index, best_index);
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if (lane_index[lane] >= 0 && lane_t[lane] < result.t)
+				result = { lane_t[lane], 0.0f, 0.0f, uint32_t(lane_index[lane]), true };
+		}
+	}
+#else
+	{
+		float closest = ray_tmax;
+		for (; i < end; i++)
+		{
+			float t = _intersect_scalar(self, i, wray);
+			if (t > ray_tmin && t < closest)
+			{
+				closest = t;
+				result = { t, 0.0f, 0.0f, uint32_t(i), true };
+			}
+		}
+	}
+#endif
+
+	if (result.hit)
+		_barycentrics(self, result.index, wray, result.u, result.v);
+
+	return result;
+}
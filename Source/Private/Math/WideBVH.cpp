@@ -0,0 +1,134 @@
+#include <Math/WideBVH.hpp>
+
+#include <limits>
+
+template<size_t InWidth>
+static void
+_set_child(WideBVHNode<InWidth>& node, size_t slot, const BVHNode& child)
+{
+	node.min_x[slot] = child.bounds.min.x;
+	node.min_y[slot] = child.bounds.min.y;
+	node.min_z[slot] = child.bounds.min.z;
+	node.max_x[slot] = child.bounds.max.x;
+	node.max_y[slot] = child.bounds.max.y;
+	node.max_z[slot] = child.bounds.max.z;
+
+	node.offset[slot] = child.offset;
+	node.count[slot] = child.count;
+}
+
+template<size_t InWidth>
+static uint32_t
+_push_empty_node(WideBVH<InWidth>& self)
+{
+	const float inf = std::numeric_limits<float>::infinity();
+
+	WideBVHNode<InWidth> node;
+	for (size_t i = 0; i < InWidth; i++)
+	{
+		node.min_x[i] = node.min_y[i] = node.min_z[i] = inf;
+		node.max_x[i] = node.max_y[i] = node.max_z[i] = -inf;
+
+		node.offset[i] = 0;
+		node.count[i] = 0;
+	}
+
+	self.nodes.push_back(node);
+	return uint32_t(self.nodes.size() - 1);
+}
+
+// Collapses the binary hierarchy top-down: every wide node starts from the two
+// children of a binary node and keeps opening its largest interior child until
+// all InWidth slots are used, so the surface-area ordering of the SAH build is
+// preserved.
+template<size_t InWidth>
+void
+wide_bvh_build(WideBVH<InWidth>& self, const BVH& bvh)
+{
+	wide_bvh_clear(self);
+
+	if (bvh.nodes.empty())
+		return;
+
+	self.nodes.reserve(bvh.nodes.size() / (InWidth / 2) + 1);
+
+	struct PendingNode
+	{
+		uint32_t wide_node;
+		uint32_t binary_node;
+	};
+
+	std::vector<PendingNode> pending;
+
+	uint32_t root = _push_empty_node(self);
+	if (bvh.nodes[0].count)
+	{
+		_set_child(self.nodes[root], 0, bvh.nodes[0]);
+		return;
+	}
+
+	pending.push_back({ root, 0 });
+	while (!pending.empty())
+	{
+		PendingNode current = pending.back();
+		pending.pop_back();
+
+		const BVHNode& parent = bvh.nodes[current.binary_node];
+
+		uint32_t children[InWidth] = { parent.offset, parent.offset + 1 };
+		size_t child_count = 2;
+
+		while (child_count < InWidth)
+		{
+			int largest = -1;
+			float largest_area = -1.0f;
+
+			for (size_t i = 0; i < child_count; i++)
+			{
+				const BVHNode& child = bvh.nodes[children[i]];
+				if (child.count)
+					continue;
+
+				float area = aabb_surface_area(child.bounds);
+				if (area > largest_area)
+				{
+					largest = int(i);
+					largest_area = area;
+				}
+			}
+
+			if (largest < 0)
+				break;
+
+			uint32_t opened = children[largest];
+			children[largest] = bvh.nodes[opened].offset;
+			children[child_count++] = bvh.nodes[opened].offset + 1;
+		}
+
+		for (size_t i = 0; i < child_count; i++)
+		{
+			const BVHNode& child = bvh.nodes[children[i]];
+			_set_child(self.nodes[current.wide_node], i, child);
+
+			if (child.count)
+				continue;
+
+			uint32_t wide_child = _push_empty_node(self);
+			self.nodes[current.wide_node].offset[i] = wide_child;
+
+			pending.push_back({ wide_child, children[i] });
+		}
+	}
+}
+template<size_t InWidth>
+void
+wide_bvh_clear(WideBVH<InWidth>& self)
+{
+	self.nodes.clear();
+}
+
+template void wide_bvh_build<4>(WideBVH<4>& self, const BVH& bvh);
+template void wide_bvh_build<8>(WideBVH<8>& self, const BVH& bvh);
+
+template void wide_bvh_clear<4>(WideBVH<4>& self);
+template void wide_bvh_clear<8>(WideBVH<8>& self);
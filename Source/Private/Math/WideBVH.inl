@@ -0,0 +1,192 @@
+#ifndef WIDE_BVH_INL
+#define WIDE_BVH_INL
+
+#include <Math/WideBVH.hpp>
+
+#include <cassert>
+
+struct _WideRay
+{
+	float origin[3];
+	float inv_direction[3];
+
+	bool negative[3];
+};
+
+// Slab test of one ray against every child of a node. Near and far planes are
+// picked by the sign of the direction, which keeps empty slots empty. Returns a
+// bit mask of the children hit and writes their entry distances to t.
+template<size_t InWidth>
+static inline uint32_t
+_wide_bvh_intersect_node(const WideBVHNode<InWidth>& node, const _WideRay& ray, float ray_tmin, float ray_tmax, float* t)
+{
+	const float* near_x = ray.negative[0] ? node.max_x : node.min_x;
+	const float* near_y = ray.negative[1] ? node.max_y : node.min_y;
+	const float* near_z = ray.negative[2] ? node.max_z : node.min_z;
+	const float* far_x = ray.negative[0] ? node.min_x : node.max_x;
+	const float* far_y = ray.negative[1] ? node.min_y : node.max_y;
+	const float* far_z = ray.negative[2] ? node.min_z : node.max_z;
+
+	uint32_t mask = 0;
+	for (size_t i = 0; i < InWidth; i++)
+	{
+		float t0 = std::max(std::max(
+			(near_x[i] - ray.origin[0]) * ray.inv_direction[0],
+			(near_y[i] - ray.origin[1]) * ray.inv_direction[1]),
+			std::max((near_z[i] - ray.origin[2]) * ray.inv_direction[2], ray_tmin));
+		float t1 = std::min(std::min(
+			(far_x[i] - ray.origin[0]) * ray.inv_direction[0],
+			(far_y[i] - ray.origin[1]) * ray.inv_direction[1]),
+			(far_z[i] - ray.origin[2]) * ray.inv_direction[2]);
+		t1 = std::min(t1 * AABB_FAR_SCALE, ray_tmax);
+
+		t[i] = t0;
+		if (t0 <= t1)
+			mask |= 1u << i;
+	}
+
+	return mask;
+}
+
+#if defined(SIMD_SSE2)
+template<>
+inline uint32_t
+_wide_bvh_intersect_node<4>(const WideBVHNode<4>& node, const _WideRay& ray, float ray_tmin, float ray_tmax, float* t)
+{
+	const __m128 origin_x = _mm_set1_ps(ray.origin[0]);
+	const __m128 origin_y = _mm_set1_ps(ray.origin[1]);
+	const __m128 origin_z = _mm_set1_ps(ray.origin[2]);
+
+	const __m128 inv_x = _mm_set1_ps(ray.inv_direction[0]);
+	const __m128 inv_y = _mm_set1_ps(ray.inv_direction[1]);
+	const __m128 inv_z = _mm_set1_ps(ray.inv_direction[2]);
+
+	__m128 near_x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(ray.negative[0] ? node.max_x : node.min_x), origin_x), inv_x);
+	__m128 near_y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(ray.negative[1] ? node.max_y : node.min_y), origin_y), inv_y);
+	__m128 near_z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(ray.negative[2] ? node.max_z : node.min_z), origin_z), inv_z);
+	__m128 far_x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(ray.negative[0] ? node.min_x : node.max_x), origin_x), inv_x);
+	__m128 far_y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(ray.negative[1] ? node.min_y : node.max_y), origin_y), inv_y);
+	__m128 far_z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(ray.negative[2] ? node.min_z : node.max_z), origin_z), inv_z);
+
+	__m128 t0 = _mm_max_ps(_mm_max_ps(near_x, near_y), _mm_max_ps(near_z, _mm_set1_ps(ray_tmin)));
+	__m128 t1 = _mm_mul_ps(_mm_min_ps(_mm_min_ps(far_x, far_y), far_z), _mm_set1_ps(AABB_FAR_SCALE));
+	t1 = _mm_min_ps(t1, _mm_set1_ps(ray_tmax));
+
+	_mm_storeu_ps(t, t0);
+	return uint32_t(_mm_movemask_ps(_mm_cmple_ps(t0, t1)));
+}
+#endif
+
+#if defined(SIMD_AVX2)
+template<>
+inline uint32_t
+_wide_bvh_intersect_node<8>(const WideBVHNode<8>& node, const _WideRay& ray, float ray_tmin, float ray_tmax, float* t)
+{
+	const __m256 origin_x = _mm256_set1_ps(ray.origin[0]);
+	const __m256 origin_y = _mm256_set1_ps(ray.origin[1]);
+	const __m256 origin_z = _mm256_set1_ps(ray.origin[2]);
+
+	const __m256 inv_x = _mm256_set1_ps(ray.inv_direction[0]);
+	const __m256 inv_y = _mm256_set1_ps(ray.inv_direction[1]);
+	const __m256 inv_z = _mm256_set1_ps(ray.inv_direction[2]);
+
+	__m256 near_x = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ray.negative[0] ? node.max_x : node.min_x), origin_x), inv_x);
+	__m256 near_y = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ray.negative[1] ? node.max_y : node.min_y), origin_y), inv_y);
+	__m256 near_z = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ray.negative[2] ? node.max_z : node.min_z), origin_z), inv_z);
+	__m256 far_x = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ray.negative[0] ? node.min_x : node.max_x), origin_x), inv_x);
+	__m256 far_y = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ray.negative[1] ? node.min_y : node.max_y), origin_y), inv_y);
+	__m256 far_z = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(ray.negative[2] ? node.min_z : node.max_z), origin_z), inv_z);
+
+	__m256 t0 = _mm256_max_ps(_mm256_max_ps(near_x, near_y), _mm256_max_ps(near_z, _mm256_set1_ps(ray_tmin)));
+	__m256 t1 = _mm256_mul_ps(_mm256_min_ps(_mm256_min_ps(far_x, far_y), far_z), _mm256_set1_ps(AABB_FAR_SCALE));
+	t1 = _mm256_min_ps(t1, _mm256_set1_ps(ray_tmax));
+
+	_mm256_storeu_ps(t, t0);
+	return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(t0, t1, _CMP_LE_OQ)));
+}
+#endif
+
+template<size_t InWidth, typename InLeafFn>
+inline bool
+wide_bvh_traverse_leaves(const WideBVH<InWidth>& self, const Ray& ray, float ray_tmin, float& ray_tmax, InLeafFn leaf_fn, TraversalStats* stats)
+{
+	return wide_bvh_traverse_leaves(self.nodes.data(), self.nodes.size(), ray, ray_tmin, ray_tmax, leaf_fn, stats);
+}
+template<size_t InWidth, typename InLeafFn>
+inline bool
+wide_bvh_traverse_leaves(const WideBVHNode<InWidth>* nodes, size_t node_count, const Ray& ray, float ray_tmin, float& ray_tmax, InLeafFn leaf_fn, TraversalStats* stats)
+{
+	if (stats)
+		stats->rays++;
+
+	if (!node_count)
+		return false;
+
+	_WideRay wide_ray;
+	for (size_t i = 0; i < 3; i++)
+	{
+		wide_ray.origin[i] = ray.origin[i];
+		wide_ray.inv_direction[i] = 1.0f / ray.direction[i];
+		wide_ray.negative[i] = wide_ray.inv_direction[i] < 0.0f;
+	}
+
+	struct StackEntry
+	{
+		uint32_t offset;
+		uint32_t count;
+		float t;
+	};
+
+	StackEntry stack[BVH_MAX_DEPTH * InWidth];
+	size_t stack_size = 0;
+
+	bool hit = false;
+	stack[stack_size++] = { 0, 0, ray_tmin };
+
+	while (stack_size)
+	{
+		StackEntry entry = stack[--stack_size];
+		if (entry.t > ray_tmax)
+			continue;
+
+		if (entry.count)
+		{
+			if (stats)
+				stats->leaves_visited++;
+
+			if (leaf_fn(entry.offset, entry.count, ray_tmin, ray_tmax))
+				hit = true;
+
+			continue;
+		}
+
+		if (stats)
+			stats->nodes_visited++;
+
+		const WideBVHNode<InWidth>& node = nodes[entry.offset];
+
+		alignas(32) float t[InWidth];
+		uint32_t mask = _wide_bvh_intersect_node<InWidth>(node, wide_ray, ray_tmin, ray_tmax, t);
+
+		// Push the hit children far to near so that the nearest one is popped
+		// first; the insertion sort only ever sees a handful of entries.
+		size_t first = stack_size;
+		for (; mask; mask &= mask - 1)
+		{
+			uint32_t child = simd_count_trailing_zeros(mask);
+
+			StackEntry child_entry = { node.offset[child], node.count[child], t[child] };
+
+			size_t i = stack_size++;
+			for (; i > first && stack[i - 1].t < child_entry.t; i--)
+				stack[i] = stack[i - 1];
+			stack[i] = child_entry;
+
+			assert(stack_size < sizeof(stack) / sizeof(stack[0]));
+		}
+	}
+
+	return hit;
+}
+
+#endif
@@ -0,0 +1,423 @@
+#include <Mesh/MeshCache.hpp>
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char MESH_CACHE_MAGIC[8] = { 'M', 'R', 'T', 'B', 'V', 'H', '\r', '\n' };
+
+static constexpr size_t MESH_CACHE_ALIGNMENT = 64;
+static constexpr size_t MESH_CACHE_HASH_CHUNK = 4 << 20;
+
+static constexpr size_t MESH_CACHE_COMPONENT_COUNT = 9;
+
+// All offsets are from the start of the file and sizes in elements. Every
+// component of the triangles is padded to component_stride floats, as the
+// SIMD kernel reads whole vectors past the last triangle of a leaf.
+struct _MeshCacheHeader
+{
+	char magic[8];
+	uint32_t version;
+
+	uint32_t node_width;
+	uint32_t node_size;
+	uint32_t component_stride;
+
+	uint64_t source_hash;
+	uint64_t file_size;
+
+	AABB bounds;
+
+	uint64_t node_count;
+	uint64_t node_offset;
+
+	uint64_t triangle_count;
+	uint64_t component_offsets[MESH_CACHE_COMPONENT_COUNT];
+	uint64_t primitive_offset;
+};
+
+// Hashing, four independent multiply-rotate lanes over 8 byte words
+
+static constexpr uint64_t HASH_PRIME_1 = 0x9E3779B185EBCA87ull;
+static constexpr uint64_t HASH_PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr uint64_t HASH_PRIME_3 = 0x165667B19E3779F9ull;
+
+static inline uint64_t
+_rotate_left(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+static inline uint64_t
+_hash_round(uint64_t lane, uint64_t word)
+{
+	return _rotate_left(lane + word * HASH_PRIME_2, 31) * HASH_PRIME_1;
+}
+static inline uint64_t
+_hash_avalanche(uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= HASH_PRIME_2;
+	hash ^= hash >> 29;
+	hash *= HASH_PRIME_3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+static uint64_t
+_hash_block(const uint8_t* data, size_t size, uint64_t seed)
+{
+	uint64_t lanes[4] = { seed + HASH_PRIME_1, seed + HASH_PRIME_2, seed, seed - HASH_PRIME_1 };
+
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		for (size_t lane = 0; lane < 4; lane++)
+		{
+			uint64_t word;
+			memcpy(&word, data + i + lane * 8, 8);
+
+			lanes[lane] = _hash_round(lanes[lane], word);
+		}
+	}
+
+	// The tail is zero padded to whole words; the size below keeps it apart
+	// from data that really ends in zeros.
+	for (size_t lane = 0; i < size; i += 8, lane++)
+	{
+		uint64_t word = 0;
+		memcpy(&word, data + i, std::min<size_t>(8, size - i));
+
+		lanes[lane] = _hash_round(lanes[lane], word);
+	}
+
+	uint64_t hash = _rotate_left(lanes[0], 1) + _rotate_left(lanes[1], 7) + _rotate_left(lanes[2], 12) + _rotate_left(lanes[3], 18);
+
+	return _hash_avalanche(hash ^ (uint64_t(size) * HASH_PRIME_3));
+}
+
+// Layout
+
+static uint64_t
+_align(uint64_t offset)
+{
+	return (offset + MESH_CACHE_ALIGNMENT - 1) & ~uint64_t(MESH_CACHE_ALIGNMENT - 1);
+}
+
+static void
+_layout(_MeshCacheHeader& header)
+{
+	uint64_t offset = _align(sizeof(_MeshCacheHeader));
+
+	header.node_offset = offset;
+	offset = _align(offset + header.node_count * header.node_size);
+
+	for (uint64_t& component_offset : header.component_offsets)
+	{
+		component_offset = offset;
+		offset = _align(offset + uint64_t(header.component_stride) * sizeof(float));
+	}
+
+	header.primitive_offset = offset;
+	offset = _align(offset + header.triangle_count * sizeof(uint32_t));
+
+	header.file_size = offset;
+}
+
+static bool
+_validate(const _MeshCacheHeader& header, size_t file_size, uint64_t source_hash)
+{
+	if (memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0)
+		return false;
+	if (header.version != MESH_CACHE_VERSION || header.source_hash != source_hash)
+		return false;
+	if (header.node_width != MESH_BVH_WIDTH || header.node_size != sizeof(MeshBVHNode))
+		return false;
+	if (header.component_stride < simd_round_up(size_t(header.triangle_count), SIMD_WIDTH) + SIMD_WIDTH)
+		return false;
+
+	// A truncated or hand edited file must not send traversal out of bounds,
+	// so the sections are checked against a layout recomputed from the counts
+	// and their contents by _validate_contents.
+	_MeshCacheHeader expected = header;
+	_layout(expected);
+
+	if (expected.file_size != header.file_size || header.file_size != file_size)
+		return false;
+	if (expected.node_offset != header.node_offset || expected.primitive_offset != header.primitive_offset)
+		return false;
+
+	return memcmp(expected.component_offsets, header.component_offsets, sizeof(header.component_offsets)) == 0;
+}
+
+// Checks every index the kernels follow in place. Interior children come after
+// their parent, as the builder lays them out, which rules out cycles and
+// bounds the depth to BVH_MAX_DEPTH, as the traversal stacks need, in the same
+// pass. Unused slots are the builder's inverted boxes, which traversal never
+// enters.
+static bool
+_validate_contents(const _MeshCacheHeader& header, const char* data)
+{
+	const MeshBVHNode* nodes = (const MeshBVHNode*)(data + header.node_offset);
+	const uint32_t* primitives = (const uint32_t*)(data + header.primitive_offset);
+
+	std::vector<uint32_t> depths(size_t(header.node_count), 0);
+
+	for (uint64_t i = 0; i < header.node_count; i++)
+	{
+		const MeshBVHNode& node = nodes[i];
+
+		for (size_t slot = 0; slot < MESH_BVH_WIDTH; slot++)
+		{
+			uint64_t offset = node.offset[slot];
+			uint64_t count = node.count[slot];
+
+			if (count)
+			{
+				if (offset + count > header.triangle_count)
+					return false;
+			}
+			else if (offset)
+			{
+				if (offset <= i || offset >= header.node_count)
+					return false;
+
+				depths[offset] = std::max(depths[offset], depths[i] + 1);
+				if (depths[offset] >= BVH_MAX_DEPTH)
+					return false;
+			}
+			else if (!(node.min_x[slot] > node.max_x[slot]))
+				return false;
+		}
+	}
+
+	for (uint64_t i = 0; i < header.triangle_count; i++)
+		if (primitives[i] >= header.triangle_count)
+			return false;
+
+	return true;
+}
+
+void
+mesh_cache_create(MeshCache& self)
+{
+	self.is_open = false;
+}
+
+bool
+mesh_cache_open(MeshCache& self, TriangleMesh& mesh, const char* filename, uint64_t source_hash)
+{
+	mesh_cache_close(self);
+
+	if (!mapped_file_open(self.file, filename))
+		return false;
+
+	self.is_open = true;
+
+	_MeshCacheHeader header;
+	if (self.file.size < sizeof(header))
+	{
+		mesh_cache_close(self);
+		return false;
+	}
+
+	memcpy(&header, self.file.data, sizeof(header));
+	if (!_validate(header, self.file.size, source_hash) || !_validate_contents(header, self.file.data))
+	{
+		mesh_cache_close(self);
+		return false;
+	}
+
+	// The mapping is read only; the kernels never write through these.
+	auto component = [&](size_t i) {
+		return (float*)(self.file.data + header.component_offsets[i]);
+	};
+
+	TriangleSoA triangles;
+	triangles.v0_x = component(0); triangles.v0_y = component(1); triangles.v0_z = component(2);
+	triangles.v1_x = component(3); triangles.v1_y = component(4); triangles.v1_z = component(5);
+	triangles.v2_x = component(6); triangles.v2_y = component(7); triangles.v2_z = component(8);
+	triangles.primitive = (uint32_t*)(self.file.data + header.primitive_offset);
+	triangles.count = size_t(header.triangle_count);
+
+	const MeshBVHNode* nodes = (const MeshBVHNode*)(self.file.data + header.node_offset);
+
+	triangle_mesh_create(mesh, header.bounds, nodes, size_t(header.node_count), triangles);
+
+	return true;
+}
+void
+mesh_cache_close(MeshCache& self)
+{
+	if (self.is_open)
+		mapped_file_close(self.file);
+
+	self.is_open = false;
+}
+
+bool
+mesh_cache_write(const TriangleMesh& mesh, const char* filename, uint64_t source_hash)
+{
+	const TriangleSoA& triangles = mesh.triangles;
+
+	_MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+
+	memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+	header.version = MESH_CACHE_VERSION;
+	header.node_width = uint32_t(MESH_BVH_WIDTH);
+	header.node_size = uint32_t(sizeof(MeshBVHNode));
+	header.component_stride = uint32_t(simd_round_up(triangles.count, SIMD_WIDTH) + SIMD_WIDTH);
+	header.source_hash = source_hash;
+	header.bounds = mesh.bounding_box;
+	header.node_count = mesh.node_count;
+	header.triangle_count = triangles.count;
+
+	_layout(header);
+
+	std::string temp_filename = std::string(filename) + ".tmp";
+
+	FILE* fp = fopen(temp_filename.c_str(), "wb");
+	if (!fp)
+		return false;
+
+	uint64_t written = 0;
+	bool ok = true;
+
+	auto write = [&](const void* data, uint64_t size) {
+		ok = ok && fwrite(data, 1, size_t(size), fp) == size_t(size);
+		written += size;
+	};
+	auto pad_to = [&](uint64_t offset) {
+		static const char zeros[MESH_CACHE_ALIGNMENT] = {};
+		while (written < offset)
+			write(zeros, std::min<uint64_t>(offset - written, sizeof(zeros)));
+	};
+
+	write(&header, sizeof(header));
+
+	pad_to(header.node_offset);
+	write(mesh.nodes, header.node_count * sizeof(MeshBVHNode));
+
+	const float* components[MESH_CACHE_COMPONENT_COUNT] = {
+		triangles.v0_x, triangles.v0_y, triangles.v0_z,
+		triangles.v1_x, triangles.v1_y, triangles.v1_z,
+		triangles.v2_x, triangles.v2_y, triangles.v2_z
+	};
+
+	// Only the triangles themselves are written; the stride padding is zeros,
+	// like the padding of freshly allocated components.
+	for (size_t i = 0; i < MESH_CACHE_COMPONENT_COUNT; i++)
+	{
+		pad_to(header.component_offsets[i]);
+		write(components[i], header.triangle_count * sizeof(float));
+	}
+
+	pad_to(header.primitive_offset);
+	write(triangles.primitive, header.triangle_count * sizeof(uint32_t));
+
+	pad_to(header.file_size);
+
+	ok = fclose(fp) == 0 && ok;
+
+	if (ok)
+	{
+		// rename() does not replace an existing file everywhere.
+		remove(filename);
+		ok = rename(temp_filename.c_str(), filename) == 0;
+	}
+
+	if (!ok)
+		remove(temp_filename.c_str());
+
+	return ok;
+}
+
+uint64_t
+mesh_cache_hash(const void* data, size_t size, uint32_t thread_count)
+{
+	if (!thread_count)
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+	const uint8_t* bytes = (const uint8_t*)data;
+
+	size_t chunk_count = (size + MESH_CACHE_HASH_CHUNK - 1) / MESH_CACHE_HASH_CHUNK;
+	std::vector<uint64_t> chunk_hashes(chunk_count);
+
+	std::atomic<size_t> next_chunk { 0 };
+	auto hash_chunks = [&]() {
+		for (size_t chunk; (chunk = next_chunk.fetch_add(1)) < chunk_count; )
+		{
+			size_t offset = chunk * MESH_CACHE_HASH_CHUNK;
+			chunk_hashes[chunk] = _hash_block(bytes + offset, std::min(MESH_CACHE_HASH_CHUNK, size - offset), chunk);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < std::min<size_t>(thread_count, chunk_count); i++)
+		threads.emplace_back(hash_chunks);
+
+	hash_chunks();
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	return _hash_block((const uint8_t*)chunk_hashes.data(), chunk_hashes.size() * sizeof(uint64_t), size);
+}
+
+bool
+triangle_mesh_load_cached(TriangleMesh& self, MeshCache& cache, const char* filename, const char* cache_filename,
+	uint32_t thread_count, MeshCacheStats* stats)
+{
+	MeshCacheStats local_stats {};
+
+	std::string default_cache_filename;
+	if (!cache_filename)
+	{
+		default_cache_filename = std::string(filename) + ".bvh";
+		cache_filename = default_cache_filename.c_str();
+	}
+
+	MappedFile source;
+	if (!mapped_file_open(source, filename))
+		return false;
+
+	auto hash_start = std::chrono::steady_clock::now();
+	uint64_t source_hash = mesh_cache_hash(source.data, source.size, thread_count);
+	auto hash_end = std::chrono::steady_clock::now();
+
+	mapped_file_close(source);
+
+	local_stats.hash_ms = std::chrono::duration<double, std::milli>(hash_end - hash_start).count();
+
+	auto open_start = std::chrono::steady_clock::now();
+	local_stats.hit = mesh_cache_open(cache, self, cache_filename, source_hash);
+	auto open_end = std::chrono::steady_clock::now();
+
+	local_stats.open_ms = std::chrono::duration<double, std::milli>(open_end - open_start).count();
+
+	if (local_stats.hit)
+		local_stats.bytes = cache.file.size;
+	else
+	{
+		if (!triangle_mesh_load(self, filename, thread_count, &local_stats.load))
+			return false;
+
+		// A cache that can not be written only costs the next start-up.
+		auto write_start = std::chrono::steady_clock::now();
+		mesh_cache_write(self, cache_filename, source_hash);
+		auto write_end = std::chrono::steady_clock::now();
+
+		local_stats.write_ms = std::chrono::duration<double, std::milli>(write_end - write_start).count();
+	}
+
+	if (stats)
+		*stats = local_stats;
+
+	return true;
+}
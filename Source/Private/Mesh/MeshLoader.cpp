@@ -0,0 +1,893 @@
+#include <Mesh/MeshLoader.hpp>
+
+#include <IO/MappedFile.hpp>
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Number parsing
+
+static inline bool
+_is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+static inline bool
+_is_digit(char c)
+{
+	return uint8_t(c - '0') < 10;
+}
+
+static inline const char*
+_skip_space(const char* p, const char* end)
+{
+	while (p < end && _is_space(*p))
+		p++;
+
+	return p;
+}
+static inline const char*
+_skip_token(const char* p, const char* end)
+{
+	while (p < end && !_is_space(*p) && *p != '\n')
+		p++;
+
+	return p;
+}
+static inline const char*
+_skip_line(const char* p, const char* end)
+{
+	const char* newline = (const char*)memchr(p, '\n', size_t(end - p));
+
+	return newline ? newline + 1 : end;
+}
+
+static double
+_pow10(int exponent)
+{
+	static const double table[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	return exponent < 23 ? table[exponent] : std::pow(10.0, double(exponent));
+}
+
+// Parses a decimal float with optional sign, fraction and exponent. Up to 19
+// significant digits are accumulated exactly and scaled once, which is well
+// within float precision. Returns nullptr when no digits were found.
+static const char*
+_parse_float(const char* p, const char* end, float& value)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	int digits = 0;
+	bool any_digit = false;
+
+	for (; p < end && _is_digit(*p); p++)
+	{
+		any_digit = true;
+
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + uint64_t(*p - '0');
+			digits += mantissa != 0;
+		}
+		else
+			exponent++;
+	}
+
+	if (p < end && *p == '.')
+	{
+		for (p++; p < end && _is_digit(*p); p++)
+		{
+			any_digit = true;
+
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + uint64_t(*p - '0');
+				digits += mantissa != 0;
+				exponent--;
+			}
+		}
+	}
+
+	if (!any_digit)
+		return nullptr;
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char* q = p + 1;
+
+		bool negative_exponent = false;
+		if (q < end && (*q == '-' || *q == '+'))
+			negative_exponent = *q++ == '-';
+
+		if (q < end && _is_digit(*q))
+		{
+			int explicit_exponent = 0;
+			for (; q < end && _is_digit(*q); q++)
+				if (explicit_exponent < 1000)
+					explicit_exponent = explicit_exponent * 10 + (*q - '0');
+
+			exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+			p = q;
+		}
+	}
+
+	double result = double(mantissa);
+	if (mantissa)
+		result = exponent < 0 ? result / _pow10(-exponent) : result * _pow10(exponent);
+
+	value = float(negative ? -result : result);
+	return p;
+}
+static const char*
+_parse_int(const char* p, const char* end, int64_t& value)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	if (p == end || !_is_digit(*p))
+		return nullptr;
+
+	int64_t result = 0;
+	for (; p < end && _is_digit(*p); p++)
+		result = result * 10 + (*p - '0');
+
+	value = negative ? -result : result;
+	return p;
+}
+
+// Chunking
+
+// Splits [begin, end) into at most chunk_count ranges that each start at the
+// beginning of a line. Returns chunk_count + 1 boundaries.
+static std::vector<const char*>
+_split_lines(const char* begin, const char* end, size_t chunk_count)
+{
+	std::vector<const char*> boundaries(chunk_count + 1, end);
+	boundaries[0] = begin;
+
+	size_t size = size_t(end - begin);
+	for (size_t i = 1; i < chunk_count; i++)
+	{
+		const char* split = begin + size * i / chunk_count;
+		if (split < boundaries[i - 1])
+			split = boundaries[i - 1];
+
+		boundaries[i] = split == begin ? begin : _skip_line(split - 1, end);
+	}
+
+	return boundaries;
+}
+
+template<typename InFn>
+static void
+_parallel_for(size_t count, InFn fn)
+{
+	std::vector<std::thread> threads;
+	threads.reserve(count);
+
+	for (size_t i = 1; i < count; i++)
+		threads.emplace_back(fn, i);
+
+	fn(size_t(0));
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+// Wavefront OBJ
+
+struct _ObjChunk
+{
+	size_t vertex_count;
+	size_t triangle_count;
+
+	size_t vertex_offset;
+	size_t triangle_offset;
+};
+
+static inline bool
+_obj_is_command(const char* p, const char* end, char command)
+{
+	return p + 1 < end && p[0] == command && _is_space(p[1]);
+}
+
+static void
+_obj_count(const char* p, const char* end, _ObjChunk& chunk)
+{
+	chunk.vertex_count = 0;
+	chunk.triangle_count = 0;
+
+	while (p < end)
+	{
+		p = _skip_space(p, end);
+
+		if (_obj_is_command(p, end, 'v'))
+			chunk.vertex_count++;
+		else if (_obj_is_command(p, end, 'f'))
+		{
+			size_t corner_count = 0;
+			for (p = _skip_space(p + 1, end); p < end && *p != '\n' && *p != '#'; p = _skip_space(p, end))
+			{
+				p = _skip_token(p, end);
+				corner_count++;
+			}
+
+			if (corner_count >= 3)
+				chunk.triangle_count += corner_count - 2;
+		}
+
+		p = _skip_line(p, end);
+	}
+}
+
+static bool
+_obj_parse(const char* p, const char* end, const _ObjChunk& chunk, size_t total_vertex_count, Vec3f* positions, uint32_t* indices)
+{
+	size_t vertex_index = chunk.vertex_offset;
+	uint32_t* index = indices + chunk.triangle_offset * 3;
+
+	while (p < end)
+	{
+		p = _skip_space(p, end);
+
+		if (_obj_is_command(p, end, 'v'))
+		{
+			Vec3f& position = positions[vertex_index++];
+
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				p = _parse_float(_skip_space(p + (axis ? 0 : 1), end), end, position[axis]);
+				if (!p)
+					return false;
+			}
+		}
+		else if (_obj_is_command(p, end, 'f'))
+		{
+			uint32_t first = 0, previous = 0;
+			size_t corner_count = 0;
+
+			for (p = _skip_space(p + 1, end); p < end && *p != '\n' && *p != '#'; p = _skip_space(p, end))
+			{
+				int64_t reference;
+				p = _parse_int(p, end, reference);
+				if (!p)
+					return false;
+
+				// Skip the texture coordinate and normal references.
+				p = _skip_token(p, end);
+
+				// Negative references are relative to the vertices read so far.
+				int64_t resolved = reference < 0 ? int64_t(vertex_index) + reference : reference - 1;
+				if (resolved < 0 || uint64_t(resolved) >= total_vertex_count)
+					return false;
+
+				uint32_t current = uint32_t(resolved);
+
+				if (corner_count == 0)
+					first = current;
+				else if (corner_count >= 2)
+				{
+					index[0] = first;
+					index[1] = previous;
+					index[2] = current;
+					index += 3;
+				}
+
+				previous = current;
+				corner_count++;
+			}
+		}
+
+		p = _skip_line(p, end);
+	}
+
+	return true;
+}
+
+static bool
+_load_obj(TriangleMesh& self, const char* data, size_t size, size_t thread_count)
+{
+	std::vector<const char*> boundaries = _split_lines(data, data + size, thread_count);
+	std::vector<_ObjChunk> chunks(thread_count);
+
+	_parallel_for(thread_count, [&](size_t i) {
+		_obj_count(boundaries[i], boundaries[i + 1], chunks[i]);
+	});
+
+	size_t vertex_count = 0, triangle_count = 0;
+	for (_ObjChunk& chunk : chunks)
+	{
+		chunk.vertex_offset = vertex_count;
+		chunk.triangle_offset = triangle_count;
+
+		vertex_count += chunk.vertex_count;
+		triangle_count += chunk.triangle_count;
+	}
+
+	self.positions.resize(vertex_count);
+	self.indices.resize(triangle_count * 3);
+
+	std::atomic<bool> valid { true };
+	_parallel_for(thread_count, [&](size_t i) {
+		if (!_obj_parse(boundaries[i], boundaries[i + 1], chunks[i], vertex_count, self.positions.data(), self.indices.data()))
+			valid = false;
+	});
+
+	return valid;
+}
+
+// Stanford PLY
+
+enum class _PlyType : uint8_t
+{
+	PT_NULL = 0,
+
+	PT_INT8, PT_UINT8,
+	PT_INT16, PT_UINT16,
+	PT_INT32, PT_UINT32,
+	PT_FLOAT32, PT_FLOAT64,
+};
+
+struct _PlyProperty
+{
+	_PlyType type;
+	_PlyType count_type;
+
+	bool list;
+
+	// Position component written by this property, or -1.
+	int axis;
+	bool vertex_indices;
+};
+
+struct _PlyElement
+{
+	enum Kind { EK_OTHER = 0, EK_VERTEX, EK_FACE } kind;
+
+	size_t count;
+	std::vector<_PlyProperty> properties;
+
+	const char* begin;
+	const char* end;
+};
+
+static size_t
+_ply_type_size(_PlyType type)
+{
+	switch (type)
+	{
+		case _PlyType::PT_INT8: case _PlyType::PT_UINT8: return 1;
+		case _PlyType::PT_INT16: case _PlyType::PT_UINT16: return 2;
+		case _PlyType::PT_INT32: case _PlyType::PT_UINT32: case _PlyType::PT_FLOAT32: return 4;
+		case _PlyType::PT_FLOAT64: return 8;
+		default: return 0;
+	}
+}
+
+static inline double
+_ply_read(const char* p, _PlyType type)
+{
+	switch (type)
+	{
+		case _PlyType::PT_INT8: { int8_t v; memcpy(&v, p, 1); return v; }
+		case _PlyType::PT_UINT8: { uint8_t v; memcpy(&v, p, 1); return v; }
+		case _PlyType::PT_INT16: { int16_t v; memcpy(&v, p, 2); return v; }
+		case _PlyType::PT_UINT16: { uint16_t v; memcpy(&v, p, 2); return v; }
+		case _PlyType::PT_INT32: { int32_t v; memcpy(&v, p, 4); return v; }
+		case _PlyType::PT_UINT32: { uint32_t v; memcpy(&v, p, 4); return v; }
+		case _PlyType::PT_FLOAT32: { float v; memcpy(&v, p, 4); return v; }
+		case _PlyType::PT_FLOAT64: { double v; memcpy(&v, p, 8); return v; }
+		default: return 0.0;
+	}
+}
+
+static inline bool
+_token_equals(const char* p, const char* end, const char* token)
+{
+	size_t length = strlen(token);
+
+	return size_t(end - p) >= length && !memcmp(p, token, length) &&
+		(p + length == end || _is_space(p[length]) || p[length] == '\n');
+}
+
+static _PlyType
+_ply_parse_type(const char* p, const char* end)
+{
+	static const struct { const char* name; _PlyType type; } types[] = {
+		{ "char", _PlyType::PT_INT8 }, { "int8", _PlyType::PT_INT8 },
+		{ "uchar", _PlyType::PT_UINT8 }, { "uint8", _PlyType::PT_UINT8 },
+		{ "short", _PlyType::PT_INT16 }, { "int16", _PlyType::PT_INT16 },
+		{ "ushort", _PlyType::PT_UINT16 }, { "uint16", _PlyType::PT_UINT16 },
+		{ "int", _PlyType::PT_INT32 }, { "int32", _PlyType::PT_INT32 },
+		{ "uint", _PlyType::PT_UINT32 }, { "uint32", _PlyType::PT_UINT32 },
+		{ "float", _PlyType::PT_FLOAT32 }, { "float32", _PlyType::PT_FLOAT32 },
+		{ "double", _PlyType::PT_FLOAT64 }, { "float64", _PlyType::PT_FLOAT64 },
+	};
+
+	for (const auto& entry : types)
+		if (_token_equals(p, end, entry.name))
+			return entry.type;
+
+	return _PlyType::PT_NULL;
+}
+
+// Parses the header up to and including "end_header". Returns the first byte
+// of the body, or nullptr if the header is malformed or unsupported.
+static const char*
+_ply_parse_header(const char* p, const char* end, bool& binary, std::vector<_PlyElement>& elements)
+{
+	if (!_token_equals(p, end, "ply"))
+		return nullptr;
+
+	bool has_format = false;
+
+	for (p = _skip_line(p, end); p < end; p = _skip_line(p, end))
+	{
+		const char* line_end = (const char*)memchr(p, '\n', size_t(end - p));
+		if (!line_end)
+			line_end = end;
+
+		const char* token = _skip_space(p, line_end);
+		const char* next = _skip_space(_skip_token(token, line_end), line_end);
+
+		if (_token_equals(token, line_end, "end_header"))
+			return has_format ? _skip_line(p, end) : nullptr;
+
+		if (_token_equals(token, line_end, "format"))
+		{
+			if (_token_equals(next, line_end, "ascii"))
+				binary = false;
+			else if (_token_equals(next, line_end, "binary_little_endian"))
+				binary = true;
+			else
+				return nullptr;
+
+			has_format = true;
+		}
+		else if (_token_equals(token, line_end, "element"))
+		{
+			_PlyElement element {};
+
+			if (_token_equals(next, line_end, "vertex"))
+				element.kind = _PlyElement::EK_VERTEX;
+			else if (_token_equals(next, line_end, "face"))
+				element.kind = _PlyElement::EK_FACE;
+
+			int64_t count;
+			if (!_parse_int(_skip_space(_skip_token(next, line_end), line_end), line_end, count) || count < 0)
+				return nullptr;
+
+			element.count = size_t(count);
+			elements.push_back(element);
+		}
+		else if (_token_equals(token, line_end, "property"))
+		{
+			if (elements.empty())
+				return nullptr;
+
+			_PlyProperty property {};
+			property.axis = -1;
+
+			if (_token_equals(next, line_end, "list"))
+			{
+				property.list = true;
+
+				next = _skip_space(_skip_token(next, line_end), line_end);
+				property.count_type = _ply_parse_type(next, line_end);
+
+				next = _skip_space(_skip_token(next, line_end), line_end);
+			}
+
+			property.type = _ply_parse_type(next, line_end);
+			if (property.type == _PlyType::PT_NULL || (property.list && property.count_type == _PlyType::PT_NULL))
+				return nullptr;
+
+			const char* name = _skip_space(_skip_token(next, line_end), line_end);
+
+			_PlyElement& element = elements.back();
+			if (element.kind == _PlyElement::EK_VERTEX && !property.list)
+			{
+				if (_token_equals(name, line_end, "x")) property.axis = 0;
+				if (_token_equals(name, line_end, "y")) property.axis = 1;
+				if (_token_equals(name, line_end, "z")) property.axis = 2;
+			}
+			else if (element.kind == _PlyElement::EK_FACE && property.list)
+			{
+				property.vertex_indices = _token_equals(name, line_end, "vertex_indices") ||
+					_token_equals(name, line_end, "vertex_index");
+			}
+
+			element.properties.push_back(property);
+		}
+	}
+
+	return nullptr;
+}
+
+// Walks one binary element and returns the byte after it. Corner indices of
+// the vertex index list are passed to corner_fn.
+template<typename InCornerFn>
+static inline const char*
+_ply_binary_element(const char* p, const char* end, const _PlyElement& element, InCornerFn corner_fn)
+{
+	for (const _PlyProperty& property : element.properties)
+	{
+		size_t size = _ply_type_size(property.type);
+
+		if (!property.list)
+		{
+			p += size;
+			continue;
+		}
+
+		size_t count_size = _ply_type_size(property.count_type);
+		if (p + count_size > end)
+			return nullptr;
+
+		size_t count = size_t(_ply_read(p, property.count_type));
+		p += count_size;
+
+		if (size_t(end - p) < count * size)
+			return nullptr;
+
+		if (property.vertex_indices)
+			for (size_t i = 0; i < count; i++)
+				corner_fn(i, _ply_read(p + i * size, property.type));
+
+		p += count * size;
+	}
+
+	return p <= end ? p : nullptr;
+}
+
+// Walks one ascii element line and returns the start of the next line.
+template<typename InCornerFn>
+static inline const char*
+_ply_ascii_element(const char* p, const char* end, const _PlyElement& element, Vec3f* position, InCornerFn corner_fn)
+{
+	for (const _PlyProperty& property : element.properties)
+	{
+		p = _skip_space(p, end);
+
+		if (!property.list)
+		{
+			if (position && property.axis >= 0)
+			{
+				p = _parse_float(p, end, (*position)[property.axis]);
+				if (!p)
+					return nullptr;
+			}
+			else
+				p = _skip_token(p, end);
+
+			continue;
+		}
+
+		int64_t count;
+		p = _parse_int(p, end, count);
+		if (!p || count < 0)
+			return nullptr;
+
+		for (int64_t i = 0; i < count; i++)
+		{
+			p = _skip_space(p, end);
+
+			if (property.vertex_indices)
+			{
+				int64_t index;
+				p = _parse_int(p, end, index);
+				if (!p)
+					return nullptr;
+
+				corner_fn(size_t(i), double(index));
+			}
+			else
+				p = _skip_token(p, end);
+		}
+	}
+
+	return _skip_line(p, end);
+}
+
+// Fan triangulates the corners of one face. Out of range indices are clamped
+// to zero and reported through valid.
+struct _PlyFan
+{
+	uint32_t* index;
+	size_t vertex_count;
+
+	uint32_t first, previous;
+	bool valid;
+
+	inline void
+	operator()(size_t corner, double value)
+	{
+		uint32_t current = uint32_t(value);
+		if (value < 0.0 || value >= double(vertex_count))
+		{
+			current = 0;
+			valid = false;
+		}
+
+		if (corner == 0)
+			first = current;
+		else if (corner >= 2)
+		{
+			index[0] = first;
+			index[1] = previous;
+			index[2] = current;
+			index += 3;
+		}
+
+		previous = current;
+	}
+};
+
+static bool
+_load_ply(TriangleMesh& self, const char* data, size_t size, size_t thread_count)
+{
+	const char* end = data + size;
+
+	bool binary = false;
+	std::vector<_PlyElement> elements;
+
+	const char* p = _ply_parse_header(data, end, binary, elements);
+	if (!p)
+		return false;
+
+	const _PlyElement* vertex = nullptr;
+	const _PlyElement* face = nullptr;
+
+	// Locate every element section. Fixed-size binary elements are skipped
+	// in one step, everything else is walked once.
+	for (_PlyElement& element : elements)
+	{
+		element.begin = p;
+
+		size_t stride = 0;
+		bool fixed = binary;
+		for (const _PlyProperty& property : element.properties)
+		{
+			fixed &= !property.list;
+			stride += _ply_type_size(property.type);
+		}
+
+		if (fixed)
+		{
+			if (size_t(end - p) < element.count * stride)
+				return false;
+
+			p += element.count * stride;
+		}
+		else if (binary)
+		{
+			for (size_t i = 0; i < element.count && p; i++)
+				p = _ply_binary_element(p, end, element, [](size_t, double) {});
+		}
+		else
+		{
+			size_t i = 0;
+			for (; i < element.count && p < end; i++)
+				p = _skip_line(p, end);
+
+			// Running out of lines leaves the missing elements behind.
+			if (i < element.count)
+				return false;
+		}
+
+		if (!p)
+			return false;
+
+		element.end = p;
+
+		if (element.kind == _PlyElement::EK_VERTEX)
+			vertex = &element;
+		if (element.kind == _PlyElement::EK_FACE)
+			face = &element;
+	}
+
+	if (!vertex || !face)
+		return false;
+
+	self.positions.resize(vertex->count);
+
+	std::atomic<bool> valid { true };
+
+	// Vertices
+	if (binary)
+	{
+		size_t stride = 0;
+		for (const _PlyProperty& property : vertex->properties)
+			stride += _ply_type_size(property.type);
+
+		// Vertices with list properties have no fixed stride.
+		if (size_t(vertex->end - vertex->begin) != vertex->count * stride)
+			return false;
+
+		_parallel_for(thread_count, [&](size_t i) {
+			size_t first = vertex->count * i / thread_count;
+			size_t last = vertex->count * (i + 1) / thread_count;
+
+			for (size_t v = first; v < last; v++)
+			{
+				const char* q = vertex->begin + v * stride;
+				for (const _PlyProperty& property : vertex->properties)
+				{
+					if (property.axis >= 0)
+						self.positions[v][property.axis] = float(_ply_read(q, property.type));
+
+					q += _ply_type_size(property.type);
+				}
+			}
+		});
+	}
+	else
+	{
+		std::vector<const char*> boundaries = _split_lines(vertex->begin, vertex->end, thread_count);
+		std::vector<size_t> offsets(thread_count + 1, 0);
+
+		_parallel_for(thread_count, [&](size_t i) {
+			size_t line_count = 0;
+			for (const char* q = boundaries[i]; q < boundaries[i + 1]; q = _skip_line(q, boundaries[i + 1]))
+				line_count++;
+
+			offsets[i + 1] = line_count;
+		});
+
+		for (size_t i = 0; i < thread_count; i++)
+			offsets[i + 1] += offsets[i];
+
+		_parallel_for(thread_count, [&](size_t i) {
+			Vec3f* position = self.positions.data() + offsets[i];
+			for (const char* q = boundaries[i]; q < boundaries[i + 1]; position++)
+			{
+				q = _ply_ascii_element(q, boundaries[i + 1], *vertex, position, [](size_t, double) {});
+				if (!q)
+				{
+					valid = false;
+					break;
+				}
+			}
+		});
+	}
+
+	// Faces. The count pass sizes the index buffer exactly, so the fill pass
+	// writes straight into it.
+	size_t triangle_count = 0;
+	auto count_corner = [&triangle_count](size_t corner, double) {
+		triangle_count += corner >= 2;
+	};
+
+	if (binary)
+	{
+		const char* q = face->begin;
+		for (size_t i = 0; i < face->count && q; i++)
+			q = _ply_binary_element(q, face->end, *face, count_corner);
+
+		self.indices.resize(triangle_count * 3);
+
+		_PlyFan fan = { self.indices.data(), vertex->count, 0, 0, true };
+
+		q = face->begin;
+		for (size_t i = 0; i < face->count && q; i++)
+			q = _ply_binary_element(q, face->end, *face, std::ref(fan));
+
+		valid = fan.valid;
+	}
+	else
+	{
+		std::vector<const char*> boundaries = _split_lines(face->begin, face->end, thread_count);
+		std::vector<size_t> offsets(thread_count + 1, 0);
+
+		_parallel_for(thread_count, [&](size_t i) {
+			size_t chunk_triangle_count = 0;
+			auto count_chunk_corner = [&chunk_triangle_count](size_t corner, double) {
+				chunk_triangle_count += corner >= 2;
+			};
+
+			for (const char* q = boundaries[i]; q && q < boundaries[i + 1]; )
+				q = _ply_ascii_element(q, boundaries[i + 1], *face, nullptr, count_chunk_corner);
+
+			offsets[i + 1] = chunk_triangle_count;
+		});
+
+		for (size_t i = 0; i < thread_count; i++)
+			offsets[i + 1] += offsets[i];
+
+		self.indices.resize(offsets[thread_count] * 3);
+
+		_parallel_for(thread_count, [&](size_t i) {
+			_PlyFan fan = { self.indices.data() + offsets[i] * 3, vertex->count, 0, 0, true };
+
+			for (const char* q = boundaries[i]; q && q < boundaries[i + 1]; )
+			{
+				q = _ply_ascii_element(q, boundaries[i + 1], *face, nullptr, std::ref(fan));
+				fan.valid &= q != nullptr;
+			}
+
+			if (!fan.valid)
+				valid = false;
+		});
+	}
+
+	return valid;
+}
+
+static bool
+_has_extension(const char* filename, const char* extension)
+{
+	const char* dot = strrchr(filename, '.');
+	if (!dot)
+		return false;
+
+	for (dot++; *dot && *extension; dot++, extension++)
+		if ((*dot | 0x20) != *extension)
+			return false;
+
+	return !*dot && !*extension;
+}
+
+bool
+triangle_mesh_load(TriangleMesh& self, const char* filename, uint32_t thread_count, MeshLoadStats* stats)
+{
+	if (!thread_count)
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+	MappedFile file;
+	if (!mapped_file_open(file, filename))
+		return false;
+
+	triangle_mesh_create(self);
+
+	// Small files are not worth the thread start-up.
+	size_t chunk_count = std::min<size_t>(thread_count, file.size / (1 << 20) + 1);
+
+	auto parse_start = std::chrono::steady_clock::now();
+
+	bool loaded = false;
+	if (_has_extension(filename, "obj"))
+		loaded = _load_obj(self, file.data, file.size, chunk_count);
+	else if (_has_extension(filename, "ply"))
+		loaded = _load_ply(self, file.data, file.size, chunk_count);
+
+	auto parse_end = std::chrono::steady_clock::now();
+
+	size_t bytes = file.size;
+	mapped_file_close(file);
+
+	if (!loaded)
+	{
+		triangle_mesh_destroy(self);
+		return false;
+	}
+
+	triangle_mesh_build(self);
+
+	auto build_end = std::chrono::steady_clock::now();
+
+	if (stats)
+	{
+		stats->bytes = bytes;
+		stats->vertex_count = self.positions.size();
+		stats->triangle_count = triangle_mesh_get_triangle_count(self);
+		stats->thread_count = uint32_t(chunk_count);
+		stats->parse_ms = std::chrono::duration<double, std::milli>(parse_end - parse_start).count();
+		stats->build_ms = std::chrono::duration<double, std::milli>(build_end - parse_end).count();
+	}
+
+	return true;
+}
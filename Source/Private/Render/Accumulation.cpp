@@ -0,0 +1,315 @@
+#include <Render/Accumulation.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include <Math/SIMD.hpp>
+
+static inline float
+_luminance(float r, float g, float b)
+{
+	return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+}
+
+#if defined(SIMD_AVX2)
+// Means of 8 pixels of RGB sums as opaque RGBA32 pixels, rounded like the
+// scalar resolve.
+static inline __m256i
+_resolve_rgba32x8(const float* color, const uint32_t* sample_counts)
+{
+	__m256 counts = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)sample_counts));
+	__m256 scales = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(255.0f), counts),
+		_mm256_cmp_ps(counts, _mm256_setzero_ps(), _CMP_NEQ_OQ));
+
+	// Each pixel's scale repeated for its three channels.
+	__m256 scales0 = _mm256_permutevar8x32_ps(scales, _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2));
+	__m256 scales1 = _mm256_permutevar8x32_ps(scales, _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5));
+	__m256 scales2 = _mm256_permutevar8x32_ps(scales, _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7));
+
+	__m256i channels0 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(color), scales0));
+	__m256i channels1 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(color + 8), scales1));
+	__m256i channels2 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(color + 16), scales2));
+
+	// Packing works within 128-bit lanes, leaving the channels of pixels 0-3
+	// and 4-7 spread over both in 4 byte groups, which are put back in order
+	// with one group of padding after each half.
+	__m256i channels = _mm256_packus_epi16(_mm256_packus_epi32(channels0, channels1),
+		_mm256_packus_epi32(channels2, _mm256_setzero_si256()));
+	channels = _mm256_permutevar8x32_epi32(channels, _mm256_setr_epi32(0, 4, 1, 3, 5, 2, 6, 7));
+
+	__m256i spread = _mm256_setr_epi8(
+		0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+		0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+	return _mm256_or_si256(_mm256_shuffle_epi8(channels, spread), _mm256_set1_epi32(int32_t(0xFF000000)));
+}
+#endif
+
+void
+accumulation_buffer_create(AccumulationBuffer& self)
+{
+	memset(&self, 0, sizeof(AccumulationBuffer));
+}
+void
+accumulation_buffer_destroy(AccumulationBuffer& self)
+{
+	free(self.color);
+	free(self.squares);
+	free(self.sample_counts);
+	free(self.active_blocks);
+
+	memset(&self, 0, sizeof(AccumulationBuffer));
+}
+
+void
+accumulation_buffer_reset(AccumulationBuffer& self)
+{
+	size_t pixel_count = self.width * self.height;
+	size_t block_count = self.blocks_x * self.blocks_y;
+
+	if (!self.is_empty)
+	{
+		if (self.color)
+			memset(self.color, 0, pixel_count * 3 * sizeof(float));
+		if (self.squares)
+			memset(self.squares, 0, pixel_count * sizeof(float));
+		if (self.sample_counts)
+			memset(self.sample_counts, 0, pixel_count * sizeof(uint32_t));
+
+		self.is_empty = true;
+	}
+
+	if (self.active_blocks)
+		memset(self.active_blocks, 1, block_count);
+
+	self.active_block_count = block_count;
+
+	self.pass_count = 0;
+	self.elapsed_ms = 0.0;
+}
+
+void
+accumulation_buffer_reset_region(AccumulationBuffer& self, const RenderRect& region)
+{
+	size_t right = std::min(region.x + region.width, self.width);
+	size_t bottom = std::min(region.y + region.height, self.height);
+
+	if (region.x >= right || region.y >= bottom)
+		return;
+
+	for (size_t y = region.y; y < bottom; y++)
+	{
+		size_t index = y * self.width + region.x;
+		size_t count = right - region.x;
+
+		memset(self.color + index * 3, 0, count * 3 * sizeof(float));
+		memset(self.squares + index, 0, count * sizeof(float));
+		memset(self.sample_counts + index, 0, count * sizeof(uint32_t));
+	}
+
+	for (size_t block_y = region.y / ACCUMULATION_BLOCK_SIZE; block_y * ACCUMULATION_BLOCK_SIZE < bottom; block_y++)
+	{
+		for (size_t block_x = region.x / ACCUMULATION_BLOCK_SIZE; block_x * ACCUMULATION_BLOCK_SIZE < right; block_x++)
+		{
+			uint8_t& block = self.active_blocks[block_y * self.blocks_x + block_x];
+
+			self.active_block_count += !block;
+			block = 1;
+		}
+	}
+}
+
+bool
+accumulation_buffer_prepare(AccumulationBuffer& self, size_t width, size_t height, const RenderView& view)
+{
+	if (width != self.width || height != self.height)
+	{
+		free(self.color);
+		free(self.squares);
+		free(self.sample_counts);
+		free(self.active_blocks);
+
+		self.width = width;
+		self.height = height;
+
+		self.blocks_x = (width + ACCUMULATION_BLOCK_SIZE - 1) / ACCUMULATION_BLOCK_SIZE;
+		self.blocks_y = (height + ACCUMULATION_BLOCK_SIZE - 1) / ACCUMULATION_BLOCK_SIZE;
+
+		// Large zeroed allocations come straight from the system, untouched.
+		self.color = (float*)calloc(width * height * 3, sizeof(float));
+		self.squares = (float*)calloc(width * height, sizeof(float));
+		self.sample_counts = (uint32_t*)calloc(width * height, sizeof(uint32_t));
+		self.active_blocks = (uint8_t*)malloc(self.blocks_x * self.blocks_y);
+
+		self.is_empty = true;
+	}
+	else if (memcmp(&view, &self.view, sizeof(RenderView)) == 0)
+		return false;
+
+	self.view = view;
+	accumulation_buffer_reset(self);
+
+	return true;
+}
+
+void
+accumulation_buffer_set_error_threshold(AccumulationBuffer& self, float error_threshold)
+{
+	if (error_threshold == self.error_threshold)
+		return;
+
+	if (self.active_blocks)
+		memset(self.active_blocks, 1, self.blocks_x * self.blocks_y);
+
+	self.active_block_count = self.blocks_x * self.blocks_y;
+	self.error_threshold = error_threshold;
+}
+
+bool
+accumulation_buffer_update_block(AccumulationBuffer& self, size_t block_x, size_t block_y)
+{
+	size_t x0 = block_x * ACCUMULATION_BLOCK_SIZE, x1 = std::min(x0 + ACCUMULATION_BLOCK_SIZE, self.width);
+	size_t y0 = block_y * ACCUMULATION_BLOCK_SIZE, y1 = std::min(y0 + ACCUMULATION_BLOCK_SIZE, self.height);
+
+	// Squared standard error of the mean, s^2 / n with the unbiased sample
+	// variance, compared against the squared threshold.
+	float max_error = 0.0f;
+
+	for (size_t y = y0; y < y1; y++)
+	{
+		for (size_t x = x0; x < x1; x++)
+		{
+			size_t index = y * self.width + x;
+
+			uint32_t n = self.sample_counts[index];
+			if (n < 2)
+			{
+				max_error = INFINITY;
+				continue;
+			}
+
+			const float* sum = self.color + index * 3;
+			float mean = _luminance(sum[0], sum[1], sum[2]) / float(n);
+			float variance = std::max(0.0f, (self.squares[index] - float(n) * mean * mean) / float(n - 1));
+
+			max_error = std::max(max_error, variance / float(n));
+		}
+	}
+
+	bool is_active = max_error > self.error_threshold * self.error_threshold;
+	self.active_blocks[block_y * self.blocks_x + block_x] = is_active;
+
+	return is_active;
+}
+
+void
+accumulation_buffer_finish_pass(AccumulationBuffer& self, double elapsed_ms)
+{
+	self.pass_count++;
+	self.elapsed_ms += elapsed_ms;
+
+	// Edges crossing into a block may have been missed by all of its own
+	// samples so far, so blocks next to active ones are kept going as well.
+	// Bit 1 marks blocks active before the dilation.
+	size_t block_count = self.blocks_x * self.blocks_y;
+
+	for (size_t i = 0; i < block_count; i++)
+		self.active_blocks[i] = self.active_blocks[i] ? 3 : 0;
+
+	self.active_block_count = 0;
+	for (size_t y = 0; y < self.blocks_y; y++)
+	{
+		for (size_t x = 0; x < self.blocks_x; x++)
+		{
+			uint8_t& block = self.active_blocks[y * self.blocks_x + x];
+
+			for (size_t ny = y ? y - 1 : y; !block && ny <= std::min(y + 1, self.blocks_y - 1); ny++)
+				for (size_t nx = x ? x - 1 : x; !block && nx <= std::min(x + 1, self.blocks_x - 1); nx++)
+					block |= self.active_blocks[ny * self.blocks_x + nx] & 2;
+
+			self.active_block_count += block != 0;
+		}
+	}
+
+	for (size_t i = 0; i < block_count; i++)
+		self.active_blocks[i] = self.active_blocks[i] != 0;
+}
+
+void
+accumulation_buffer_resolve(const AccumulationBuffer& self, const RenderTarget& target)
+{
+	size_t pixel_size = render_target_get_pixel_size(target);
+
+#if defined(SIMD_AVX2)
+	bool is_aligned = (uintptr_t(target.pixels) | target.pitch) % 32 == 0;
+#endif
+
+	for (size_t y = 0; y < self.height; y++)
+	{
+		const float* color = self.color + y * self.width * 3;
+		const uint32_t* sample_counts = self.sample_counts + y * self.width;
+
+		uint8_t* pixel = target.pixels + y * target.pitch;
+
+		size_t x = 0;
+
+#if defined(SIMD_AVX2)
+		// 8 RGBA32 pixels per store, aligned whenever the rows are.
+		if (target.format == RenderFormat::RF_RGBA32)
+		{
+			for (; x + 8 <= self.width; x += 8, color += 24, pixel += 32)
+			{
+				__m256i pixels = _resolve_rgba32x8(color, sample_counts + x);
+
+				if (is_aligned)
+					_mm256_store_si256((__m256i*)pixel, pixels);
+				else
+					_mm256_storeu_si256((__m256i*)pixel, pixels);
+			}
+		}
+#endif
+
+		for (; x < self.width; x++, color += 3, pixel += pixel_size)
+		{
+			float scale = sample_counts[x] ? 255.0f / float(sample_counts[x]) : 0.0f;
+
+			pixel[0] = (uint8_t)(color[0] * scale);
+			pixel[1] = (uint8_t)(color[1] * scale);
+			pixel[2] = (uint8_t)(color[2] * scale);
+
+			if (pixel_size == 4)
+				pixel[3] = 255;
+		}
+	}
+}
+
+void
+accumulation_buffer_resolve_density(const AccumulationBuffer& self, const RenderTarget& target)
+{
+	uint32_t max_count = 1;
+	for (size_t i = 0; i < self.width * self.height; i++)
+		max_count = std::max(max_count, self.sample_counts[i]);
+
+	size_t pixel_size = render_target_get_pixel_size(target);
+
+	for (size_t y = 0; y < self.height; y++)
+	{
+		const uint32_t* sample_counts = self.sample_counts + y * self.width;
+
+		uint8_t* pixel = target.pixels + y * target.pitch;
+
+		for (size_t x = 0; x < self.width; x++, pixel += pixel_size)
+		{
+			float density = float(sample_counts[x]) / float(max_count);
+
+			pixel[0] = (uint8_t)(std::min(std::max(2.0f * density - 1.0f, 0.0f), 1.0f) * 255.0f);
+			pixel[1] = (uint8_t)((1.0f - std::fabs(2.0f * density - 1.0f)) * 255.0f);
+			pixel[2] = (uint8_t)(std::min(std::max(1.0f - 2.0f * density, 0.0f), 1.0f) * 255.0f);
+
+			if (pixel_size == 4)
+				pixel[3] = 255;
+		}
+	}
+}
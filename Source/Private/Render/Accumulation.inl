@@ -0,0 +1,12 @@
+#ifndef ACCUMULATION_INL
+#define ACCUMULATION_INL
+
+#include <Render/Accumulation.hpp>
+
+static inline bool
+accumulation_buffer_is_block_active(const AccumulationBuffer& self, size_t block_x, size_t block_y)
+{
+	return self.active_blocks[block_y * self.blocks_x + block_x];
+}
+
+#endif
@@ -0,0 +1,1039 @@
+#include <Render/Renderer.hpp>
+
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <Math/RayPacket.hpp>
+
+#include <Render/Accumulation.hpp>
+
+struct _Tile
+{
+	size_t x, y;
+	size_t width, height;
+};
+
+static Vec3f
+_shade(const HitRecord& hit_record)
+{
+	if (hit_record.hit)
+		return 0.5f * (hit_record.normal + Vec3f{ 1.0f, 1.0f, 1.0f });
+
+	return Vec3f{ 0.0f, 0.0f, 0.0f };
+}
+
+// Where a pass samples inside each pixel. Offsets are hashed from the pixel
+// and how many samples it accumulated, so frames are reproducible whatever
+// thread renders a tile, and pixels re-rendered on their own start over.
+// Tiles are laid over a grid of every scale-th pixel; each sample stands for
+// the scale x scale block below and to the right of it. Refinements skip the
+// grid points shared with the next coarser level, which already has them.
+struct _Sampler
+{
+	uint32_t pass;
+	AccumulationBuffer* accumulation;
+
+	uint32_t scale;
+	bool is_refinement;
+
+	// Skips converged blocks and re-estimates the rest after sampling them.
+	bool is_adaptive;
+};
+
+static inline uint32_t
+_hash(uint32_t value)
+{
+	value ^= value >> 16;
+	value *= 0x7FEB352Du;
+	value ^= value >> 15;
+	value *= 0x846CA68Bu;
+	value ^= value >> 16;
+
+	return value;
+}
+
+static inline Vec3f
+_pixel_direction(const RenderView& view, const _Sampler& sampler, size_t x, size_t y)
+{
+	float sample_x = float(x), sample_y = float(y);
+
+	uint32_t sample = sampler.accumulation ? sampler.accumulation->sample_counts[y * sampler.accumulation->width + x] : 0;
+
+	if (sample)
+	{
+		uint32_t seed = _hash(uint32_t(x) ^ _hash(uint32_t(y) ^ _hash(sample)));
+
+		sample_x += float(seed & 0xFFFF) * (1.0f / 65536.0f) - 0.5f;
+		sample_y += float(seed >> 16) * (1.0f / 65536.0f) - 0.5f;
+	}
+
+	Vec3f pixel_center = view.viewport_upper_left +
+		(sample_x * view.pixel_delta_u) +
+		(sample_y * view.pixel_delta_v);
+
+	Vec3f direction = pixel_center - view.center;
+	return vector_normalize(direction);
+}
+
+static inline bool
+_is_sampled(const _Sampler& sampler, size_t grid_x, size_t grid_y)
+{
+	return !sampler.is_refinement || (grid_x & 1) || (grid_y & 1);
+}
+
+static inline void
+_write_pixel(const RenderTarget& target, const _Sampler& sampler, size_t x, size_t y, Vec3f color)
+{
+	if (sampler.accumulation)
+	{
+		AccumulationBuffer& accumulation = *sampler.accumulation;
+
+		size_t index = y * accumulation.width + x;
+		float* sum = accumulation.color + index * 3;
+
+		sum[0] += color.r;
+		sum[1] += color.g;
+		sum[2] += color.b;
+
+		float luminance = 0.2126f * color.r + 0.7152f * color.g + 0.0722f * color.b;
+		accumulation.squares[index] += luminance * luminance;
+
+		// Rounded exactly like accumulation_buffer_resolve.
+		float scale = 255.0f / float(++accumulation.sample_counts[index]);
+		color = Vec3f{ sum[0] * scale, sum[1] * scale, sum[2] * scale };
+	}
+	else
+		color = color * 255.0f;
+
+	uint8_t rgba[4] = { (uint8_t)color.r, (uint8_t)color.g, (uint8_t)color.b, 255 };
+
+	size_t block_width = std::min<size_t>(sampler.scale, target.width - x);
+	size_t block_height = std::min<size_t>(sampler.scale, target.height - y);
+
+	size_t pixel_size = render_target_get_pixel_size(target);
+
+	for (size_t block_y = 0; block_y < block_height; block_y++)
+	{
+		uint8_t* pixel = target.pixels + (y + block_y) * target.pitch + x * pixel_size;
+
+		// Whole RGBA32 pixels are a single aligned store each.
+		if (target.format == RenderFormat::RF_RGBA32)
+		{
+			for (size_t block_x = 0; block_x < block_width; block_x++, pixel += 4)
+				memcpy(pixel, rgba, 4);
+		}
+		else
+		{
+			for (size_t block_x = 0; block_x < block_width; block_x++, pixel += 3)
+			{
+				pixel[0] = rgba[0];
+				pixel[1] = rgba[1];
+				pixel[2] = rgba[2];
+			}
+		}
+	}
+}
+
+static _Tile
+_get_tile(const RenderRect& area, uint32_t tile_size, uint32_t index)
+{
+	size_t tiles_x = (area.width + tile_size - 1) / tile_size;
+
+	_Tile tile;
+	tile.x = area.x + (index % tiles_x) * tile_size;
+	tile.y = area.y + (index / tiles_x) * tile_size;
+	tile.width = std::min<size_t>(tile_size, area.x + area.width - tile.x);
+	tile.height = std::min<size_t>(tile_size, area.y + area.height - tile.y);
+
+	return tile;
+}
+
+// Deque items hold a tile as four 16-bit fields.
+static inline uint64_t
+_pack_tile(const _Tile& tile)
+{
+	return uint64_t(tile.x) | (uint64_t(tile.y) << 16) | (uint64_t(tile.width) << 32) | (uint64_t(tile.height) << 48);
+}
+static inline _Tile
+_unpack_tile(uint64_t item)
+{
+	return { size_t(item & 0xFFFF), size_t((item >> 16) & 0xFFFF), size_t((item >> 32) & 0xFFFF), size_t(item >> 48) };
+}
+
+// Cuts a tile into up to four quadrants along packet boundaries, keeping the
+// first and queueing the rest. Returns false for tiles of a single packet.
+static bool
+_split_tile(WorkStealingDeque& queue, _Tile& tile)
+{
+	if (tile.width <= RAY_PACKET_WIDTH && tile.height <= RAY_PACKET_WIDTH)
+		return false;
+
+	size_t left_width = tile.width > RAY_PACKET_WIDTH ? simd_round_up((tile.width + 1) / 2, RAY_PACKET_WIDTH) : tile.width;
+	size_t top_height = tile.height > RAY_PACKET_WIDTH ? simd_round_up((tile.height + 1) / 2, RAY_PACKET_WIDTH) : tile.height;
+
+	_Tile quadrants[3] = {
+		{ tile.x + left_width, tile.y, tile.width - left_width, top_height },
+		{ tile.x, tile.y + top_height, left_width, tile.height - top_height },
+		{ tile.x + left_width, tile.y + top_height, tile.width - left_width, tile.height - top_height },
+	};
+
+	for (const _Tile& quadrant : quadrants)
+		if (quadrant.width && quadrant.height)
+			work_stealing_deque_push(queue, _pack_tile(quadrant));
+
+	tile.width = left_width;
+	tile.height = top_height;
+
+	return true;
+}
+
+static void
+_destroy_queues(Renderer& self)
+{
+	for (uint32_t i = 0; i < self.queue_count; i++)
+		work_stealing_deque_destroy(self.queues[i]);
+
+	delete[] self.queues;
+
+	self.queues = nullptr;
+	self.queue_count = 0;
+	self.queue_capacity = 0;
+}
+static void
+_reserve_queues(Renderer& self, uint32_t queue_count, size_t capacity)
+{
+	if (queue_count == self.queue_count && capacity <= self.queue_capacity)
+		return;
+
+	_destroy_queues(self);
+
+	self.queues = new WorkStealingDeque[queue_count];
+	for (uint32_t i = 0; i < queue_count; i++)
+		work_stealing_deque_create(self.queues[i], capacity);
+
+	self.queue_count = queue_count;
+	self.queue_capacity = capacity;
+}
+
+static inline uint32_t
+_spread_bits(uint32_t value)
+{
+	value &= 0xFFFF;
+	value = (value | (value << 8)) & 0x00FF00FF;
+	value = (value | (value << 4)) & 0x0F0F0F0F;
+	value = (value | (value << 2)) & 0x33333333;
+	value = (value | (value << 1)) & 0x55555555;
+
+	return value;
+}
+
+// Position of cell (x, y) along the curve over a size x size grid, size a
+// power of two.
+static inline uint64_t
+_curve_index(RenderOrder order, uint32_t size, uint32_t x, uint32_t y)
+{
+	switch (order)
+	{
+	case RenderOrder::RO_MORTON:
+		return _spread_bits(x) | (_spread_bits(y) << 1);
+
+	case RenderOrder::RO_HILBERT:
+	{
+		// Quadrant by quadrant from the top, turning the remaining bits
+		// into the orientation of the quadrant they lie in.
+		uint64_t index = 0;
+		for (uint32_t half = size / 2; half > 0; half /= 2)
+		{
+			uint32_t right = (x & half) != 0;
+			uint32_t bottom = (y & half) != 0;
+
+			index += uint64_t(half) * half * ((3 * right) ^ bottom);
+
+			if (!bottom)
+			{
+				if (right)
+				{
+					x = size - 1 - x;
+					y = size - 1 - y;
+				}
+
+				std::swap(x, y);
+			}
+		}
+
+		return index;
+	}
+
+	default:
+		return uint64_t(y) * size + x;
+	}
+}
+
+// Fills indices with y * width + x for every cell of a width x height grid,
+// sorted along the curve over the enclosing power of two square.
+static void
+_build_order(RenderOrder order, uint32_t width, uint32_t height, std::vector<uint32_t>& indices)
+{
+	uint32_t size = 1;
+	while (size < width || size < height)
+		size *= 2;
+
+	std::vector<std::pair<uint64_t, uint32_t>> keys(size_t(width) * height);
+	for (uint32_t y = 0; y < height; y++)
+		for (uint32_t x = 0; x < width; x++)
+			keys[size_t(y) * width + x] = { _curve_index(order, size, x, y), y * width + x };
+
+	std::sort(keys.begin(), keys.end());
+
+	indices.resize(keys.size());
+	for (size_t i = 0; i < keys.size(); i++)
+		indices[i] = keys[i].second;
+}
+
+static void
+_render_tile(const Renderer& self, const GeometryScene& scene, const RenderView& view, const RenderTarget& target,
+	const _Sampler& sampler, const _Tile& tile, TraversalStats& stats)
+{
+	size_t scale = sampler.scale;
+
+	RayPacket packet;
+	GeometryHit hits[RAY_PACKET_SIZE];
+
+	// Pixel of every ray in the packet, as refinements leave gaps.
+	uint32_t packet_x[RAY_PACKET_SIZE];
+	uint32_t packet_y[RAY_PACKET_SIZE];
+
+	// Tiles start on packet boundaries, so at full resolution every packet
+	// covers exactly one accumulation block. Split tiles are smaller than a
+	// whole one and skip the packets that lie outside.
+	for (uint16_t packet_index : self.packet_order)
+	{
+		size_t block_x = tile.x + (packet_index & 0xFF) * RAY_PACKET_WIDTH;
+		size_t block_y = tile.y + (packet_index >> 8) * RAY_PACKET_WIDTH;
+
+		if (block_x >= tile.x + tile.width || block_y >= tile.y + tile.height)
+			continue;
+
+		size_t block_width = std::min<size_t>(RAY_PACKET_WIDTH, tile.x + tile.width - block_x);
+		size_t block_height = std::min<size_t>(RAY_PACKET_WIDTH, tile.y + tile.height - block_y);
+
+		size_t accumulation_x = block_x / ACCUMULATION_BLOCK_SIZE;
+		size_t accumulation_y = block_y / ACCUMULATION_BLOCK_SIZE;
+
+		if (sampler.is_adaptive && !accumulation_buffer_is_block_active(*sampler.accumulation, accumulation_x, accumulation_y))
+			continue;
+
+		if (!self.packet_tracing)
+		{
+			for (uint16_t pixel_index : self.pixel_order)
+			{
+				size_t x = block_x + (pixel_index & 0xFF), y = block_y + (pixel_index >> 8);
+				if (x >= block_x + block_width || y >= block_y + block_height || !_is_sampled(sampler, x, y))
+					continue;
+
+				Ray ray { view.center, _pixel_direction(view, sampler, x * scale, y * scale) };
+				_write_pixel(target, sampler, x * scale, y * scale,
+					_shade(geometry_scene_hit(scene, ray, 0.001f, constants_infinity<float>(), &stats)));
+			}
+		}
+		else
+		{
+			ray_packet_create(packet, view.center, 0.001f, constants_infinity<float>());
+
+			for (size_t y = block_y; y < block_y + block_height; y++)
+			{
+				for (size_t x = block_x; x < block_x + block_width; x++)
+				{
+					if (!_is_sampled(sampler, x, y))
+						continue;
+
+					packet_x[packet.count] = uint32_t(x * scale);
+					packet_y[packet.count] = uint32_t(y * scale);
+
+					ray_packet_add(packet, _pixel_direction(view, sampler, x * scale, y * scale));
+				}
+			}
+
+			ray_packet_finalize(packet);
+			geometry_scene_intersect_packet(scene, packet, hits, &stats);
+
+			for (uint32_t i = 0; i < packet.count; i++)
+			{
+				HitRecord hit_record = geometry_scene_hit_record(scene, hits[i], ray_packet_get_ray(packet, i));
+				_write_pixel(target, sampler, packet_x[i], packet_y[i], _shade(hit_record));
+			}
+		}
+
+		if (sampler.is_adaptive)
+			accumulation_buffer_update_block(*sampler.accumulation, accumulation_x, accumulation_y);
+	}
+}
+
+void
+renderer_create(Renderer& self, const RenderSettings& settings)
+{
+	thread_pool_create(self.pool, settings.thread_count);
+
+	self.queues = nullptr;
+	self.queue_count = 0;
+	self.queue_capacity = 0;
+
+	self.tile_size = RENDER_DEFAULT_TILE_SIZE;
+	self.packet_tracing = true;
+	self.work_stealing = true;
+
+	self.order = RenderOrder::RO_SCANLINE;
+	self.order_tiles_x = self.order_tiles_y = 0;
+
+	self.budget_ms = 0.0f;
+	self.sample_cost_ms = 0.0;
+
+	self.pending.is_pending = false;
+
+	self.pin_threads = false;
+	self.first_touch = false;
+	self.touched_width = self.touched_height = 0;
+
+	renderer_configure(self, settings);
+}
+void
+renderer_destroy(Renderer& self)
+{
+	// Releases the caller, which stays behind as thread 0.
+	if (self.pin_threads)
+		thread_pool_set_pinned(self.pool, false);
+
+	thread_pool_destroy(self.pool);
+
+	_destroy_queues(self);
+
+	self.tile_order.clear();
+	self.packet_order.clear();
+
+	renderer_discard_pending(self);
+
+	self.touched_buffers.clear();
+}
+
+void
+renderer_configure(Renderer& self, const RenderSettings& settings)
+{
+	uint32_t thread_count = settings.thread_count ? settings.thread_count : std::max(1u, std::thread::hardware_concurrency());
+	bool is_pool_changed = thread_count != thread_pool_get_thread_count(self.pool);
+
+	if (is_pool_changed)
+	{
+		thread_pool_destroy(self.pool);
+		thread_pool_create(self.pool, thread_count);
+	}
+
+	// New pools start unpinned, but the caller may still be pinned from the
+	// last one.
+	if (settings.pin_threads != self.pin_threads || (is_pool_changed && (settings.pin_threads || self.pin_threads)))
+		thread_pool_set_pinned(self.pool, settings.pin_threads);
+
+	self.pin_threads = settings.pin_threads;
+	self.first_touch = settings.first_touch;
+
+	// Whole packets keep every tile on the coherent 8x8 path.
+	uint32_t tile_size = settings.tile_size ? settings.tile_size : RENDER_DEFAULT_TILE_SIZE;
+	self.tile_size = uint32_t(simd_round_up(tile_size, RAY_PACKET_WIDTH));
+
+	self.packet_tracing = settings.packet_tracing;
+	self.work_stealing = settings.work_stealing;
+
+	bool is_reordered = settings.order != self.order || self.packet_order.empty();
+	uint32_t packets_per_side = self.tile_size / RAY_PACKET_WIDTH;
+
+	std::vector<uint32_t> indices;
+
+	if (is_reordered || self.packet_order.size() != size_t(packets_per_side) * packets_per_side)
+	{
+		_build_order(settings.order, packets_per_side, packets_per_side, indices);
+
+		self.packet_order.resize(indices.size());
+		for (size_t i = 0; i < indices.size(); i++)
+			self.packet_order[i] = uint16_t((indices[i] % packets_per_side) | ((indices[i] / packets_per_side) << 8));
+	}
+
+	if (is_reordered)
+	{
+		_build_order(settings.order, RAY_PACKET_WIDTH, RAY_PACKET_WIDTH, indices);
+
+		for (size_t i = 0; i < RAY_PACKET_SIZE; i++)
+			self.pixel_order[i] = uint16_t((indices[i] % RAY_PACKET_WIDTH) | ((indices[i] / RAY_PACKET_WIDTH) << 8));
+
+		// The tile order depends on the frame size; the next frame rebuilds it.
+		self.order_tiles_x = self.order_tiles_y = 0;
+	}
+
+	self.order = settings.order;
+
+	self.budget_ms = std::max(settings.budget_ms, 0.0f);
+}
+
+uint32_t
+renderer_get_thread_count(const Renderer& self)
+{
+	return thread_pool_get_thread_count(self.pool);
+}
+
+void
+renderer_discard_pending(Renderer& self)
+{
+	self.pending.is_pending = false;
+	self.pending.regions.clear();
+	self.pending.tiles.clear();
+}
+
+static bool
+_is_pending(const Renderer& self, const RenderView& view, const RenderTarget& target, uint32_t scale, bool is_refinement,
+	const RenderRect* regions, size_t region_count, const AccumulationBuffer* accumulation)
+{
+	const RenderPending& pending = self.pending;
+
+	if (!pending.is_pending || memcmp(&view, &pending.view, sizeof(RenderView)) != 0)
+		return false;
+
+	if (target.width != pending.width || target.height != pending.height || accumulation != pending.accumulation ||
+		scale != pending.scale || is_refinement != pending.is_refinement || region_count != pending.regions.size())
+		return false;
+
+	for (size_t i = 0; i < region_count; i++)
+	{
+		const RenderRect& a = regions[i];
+		const RenderRect& b = pending.regions[i];
+
+		if (a.x != b.x || a.y != b.y || a.width != b.width || a.height != b.height)
+			return false;
+	}
+
+	return true;
+}
+
+// Writes the first byte of every page of the target and accumulation buffer
+// from the thread that renders the tile holding it in a full resolution frame,
+// unless the buffer was touched before. Pages are claimed by the tile row
+// they start in, so each is touched exactly once and its content is kept.
+static void
+_touch_pages(Renderer& self, const RenderTarget& target, AccumulationBuffer* accumulation)
+{
+	constexpr size_t page_size = 4096;
+
+	if (target.width != self.touched_width || target.height != self.touched_height)
+	{
+		self.touched_buffers.clear();
+		self.touched_width = target.width;
+		self.touched_height = target.height;
+	}
+
+	struct Buffer
+	{
+		uint8_t* data;
+		size_t pitch;
+		size_t pixel_size;
+	};
+
+	Buffer buffers[4];
+	size_t buffer_count = 0;
+
+	auto add_buffer = [&](void* data, size_t pitch, size_t pixel_size) {
+		if (!data || std::find(self.touched_buffers.begin(), self.touched_buffers.end(), data) != self.touched_buffers.end())
+			return;
+
+		self.touched_buffers.push_back(data);
+		buffers[buffer_count++] = { (uint8_t*)data, pitch, pixel_size };
+	};
+
+	add_buffer(target.pixels, target.pitch, render_target_get_pixel_size(target));
+
+	if (accumulation && accumulation->width == target.width && accumulation->height == target.height)
+	{
+		add_buffer(accumulation->color, target.width * 3 * sizeof(float), 3 * sizeof(float));
+		add_buffer(accumulation->squares, target.width * sizeof(float), sizeof(float));
+		add_buffer(accumulation->sample_counts, target.width * sizeof(uint32_t), sizeof(uint32_t));
+	}
+
+	if (!buffer_count)
+		return;
+
+	RenderRect frame = { 0, 0, target.width, target.height };
+
+	uint32_t tiles_x = uint32_t((target.width + self.tile_size - 1) / self.tile_size);
+	uint32_t tiles_y = uint32_t((target.height + self.tile_size - 1) / self.tile_size);
+
+	std::vector<uint32_t> order;
+	_build_order(self.order, tiles_x, tiles_y, order);
+
+	uint32_t thread_count = thread_pool_get_thread_count(self.pool);
+
+	thread_pool_run(self.pool, [&](uint32_t thread_index) {
+		size_t first = order.size() * thread_index / thread_count;
+		size_t last = order.size() * (thread_index + 1) / thread_count;
+
+		for (size_t i = first; i < last; i++)
+		{
+			_Tile tile = _get_tile(frame, self.tile_size, order[i]);
+
+			for (size_t b = 0; b < buffer_count; b++)
+			{
+				const Buffer& buffer = buffers[b];
+
+				for (size_t y = tile.y; y < tile.y + tile.height; y++)
+				{
+					uintptr_t begin = uintptr_t(buffer.data + y * buffer.pitch + tile.x * buffer.pixel_size);
+					uintptr_t end = begin + tile.width * buffer.pixel_size;
+
+					for (uintptr_t page = (begin + page_size - 1) & ~uintptr_t(page_size - 1); page < end; page += page_size)
+					{
+						volatile uint8_t* byte = (volatile uint8_t*)page;
+						*byte = *byte;
+					}
+				}
+			}
+		}
+	});
+}
+
+static RenderStats
+_render_frame(Renderer& self, const GeometryScene& scene, const RenderView& view, const RenderTarget& target,
+	uint32_t scale, bool is_refinement, const RenderRect* regions, size_t region_count, AccumulationBuffer* accumulation,
+	const std::atomic<bool>* cancel)
+{
+	auto frame_start = std::chrono::steady_clock::now();
+
+	RenderStats stats {};
+
+	_Sampler sampler = { 0, accumulation, scale, is_refinement, false };
+	if (accumulation)
+	{
+		accumulation_buffer_prepare(*accumulation, target.width, target.height, view);
+		sampler.pass = accumulation->pass_count;
+
+		// Estimates need a few samples in every pixel first.
+		sampler.is_adaptive = scale == 1 && accumulation->error_threshold > 0.0f &&
+			sampler.pass + 1 >= ACCUMULATION_MIN_ADAPTIVE_PASSES;
+	}
+
+	if (self.first_touch)
+		_touch_pages(self, target, accumulation);
+
+	if (accumulation)
+		accumulation->is_empty = false;
+
+	uint32_t thread_count = thread_pool_get_thread_count(self.pool);
+
+	size_t grid_width = (target.width + scale - 1) / scale;
+	size_t grid_height = (target.height + scale - 1) / scale;
+
+	RenderRect frame = { 0, 0, grid_width, grid_height };
+
+	// Picks up what the last frame left if it rendered the same thing.
+	std::vector<uint64_t> tiles;
+	if (_is_pending(self, view, target, scale, is_refinement, regions, regions ? region_count : 0, accumulation))
+		tiles.swap(self.pending.tiles);
+	else
+	{
+		renderer_discard_pending(self);
+
+		self.pending.view = view;
+		self.pending.width = target.width;
+		self.pending.height = target.height;
+		self.pending.accumulation = accumulation;
+		self.pending.scale = scale;
+		self.pending.is_refinement = is_refinement;
+		if (regions)
+			self.pending.regions.assign(regions, regions + region_count);
+	}
+
+	if (!regions)
+	{
+		regions = &frame;
+		region_count = 1;
+	}
+
+	// Every region gets its own tile grid, anchored at its corner, and its
+	// tiles are queued one region after the other.
+	std::vector<uint32_t> region_order;
+
+	for (size_t i = 0; i < region_count && !self.pending.is_pending; i++)
+	{
+		const RenderRect& region = regions[i];
+
+		uint32_t tiles_x = uint32_t((region.width + self.tile_size - 1) / self.tile_size);
+		uint32_t tiles_y = uint32_t((region.height + self.tile_size - 1) / self.tile_size);
+
+		const std::vector<uint32_t>* order = &region_order;
+		if (regions == &frame)
+		{
+			if (tiles_x != self.order_tiles_x || tiles_y != self.order_tiles_y)
+			{
+				_build_order(self.order, tiles_x, tiles_y, self.tile_order);
+
+				self.order_tiles_x = tiles_x;
+				self.order_tiles_y = tiles_y;
+			}
+
+			order = &self.tile_order;
+		}
+		else
+			_build_order(self.order, tiles_x, tiles_y, region_order);
+
+		for (uint32_t index : *order)
+			tiles.push_back(_pack_tile(_get_tile(region, self.tile_size, index)));
+	}
+
+	int64_t pixel_count = 0;
+	for (uint64_t item : tiles)
+	{
+		_Tile tile = _unpack_tile(item);
+		pixel_count += int64_t(tile.width * tile.height);
+	}
+
+	stats.scale = scale;
+	stats.thread_count = thread_count;
+	stats.tile_count = uint32_t(tiles.size());
+
+	// A deque holds at most its share of the frame, or the three quadrants
+	// of a split, which only happens once it ran empty.
+	size_t share = (stats.tile_count + thread_count - 1) / thread_count;
+	_reserve_queues(self, thread_count, std::max<size_t>(share, 3) + 1);
+
+	for (uint32_t i = 0; i < thread_count; i++)
+	{
+		WorkStealingDeque& queue = self.queues[i];
+		work_stealing_deque_reset(queue);
+
+		// Pushed back to front so the owner takes its share in order and
+		// thieves start from the opposite end.
+		uint32_t first = uint32_t(uint64_t(stats.tile_count) * i / thread_count);
+		uint32_t last = uint32_t(uint64_t(stats.tile_count) * (i + 1) / thread_count);
+
+		for (uint32_t index = last; index-- > first; )
+			work_stealing_deque_push(queue, tiles[index]);
+	}
+
+	// Counters are kept per thread and merged once, so traversal never
+	// contends on shared cache lines.
+	struct alignas(64) ThreadState
+	{
+		TraversalStats traversal;
+		RenderThreadStats stats;
+	};
+
+	std::vector<ThreadState> thread_states(thread_count);
+
+	// Grid points not yet rendered; the frame is done once every split piece
+	// of every tile is, wherever it ended up.
+	std::atomic<int64_t> remaining_pixels { pixel_count };
+
+	std::atomic<bool> is_cancelled { false };
+	std::atomic<bool> is_out_of_time { false };
+
+	// Tiles are predicted to cost their grid points times the measured cost
+	// of a sample; the first tile of every thread always runs, so frames make
+	// progress whatever the budget.
+	double budget_ms = self.budget_ms;
+	double sample_cost_ms = self.sample_cost_ms;
+
+	// Set once, by whichever thread finishes a tile first.
+	std::atomic_flag has_first_tile = ATOMIC_FLAG_INIT;
+	std::chrono::steady_clock::time_point first_tile_end = frame_start;
+
+	auto render_start = std::chrono::steady_clock::now();
+
+	thread_pool_run(self.pool, [&](uint32_t thread_index) {
+		WorkStealingDeque& queue = self.queues[thread_index];
+		ThreadState& state = thread_states[thread_index];
+
+		uint32_t victim = thread_index;
+
+		while (remaining_pixels.load(std::memory_order_acquire) > 0)
+		{
+			if (cancel && cancel->load(std::memory_order_relaxed))
+			{
+				is_cancelled.store(true, std::memory_order_relaxed);
+				break;
+			}
+			if (is_out_of_time.load(std::memory_order_relaxed))
+				break;
+
+			uint64_t item;
+			bool found = work_stealing_deque_take(queue, item);
+
+			for (uint32_t attempt = 1; !found && self.work_stealing && attempt < thread_count; attempt++)
+			{
+				victim = (victim + 1) % thread_count;
+				if (victim != thread_index && work_stealing_deque_steal(self.queues[victim], item))
+				{
+					found = true;
+					state.stats.steal_count++;
+				}
+			}
+
+			if (!found)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			_Tile tile = _unpack_tile(item);
+
+			if (budget_ms > 0.0 && state.stats.tile_count)
+			{
+				double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count();
+				if (elapsed_ms + double(tile.width * tile.height) * sample_cost_ms > budget_ms)
+				{
+					// Own deque had room for the item just taken or was empty.
+					work_stealing_deque_push(queue, item);
+					is_out_of_time.store(true, std::memory_order_relaxed);
+					break;
+				}
+			}
+
+			if (self.work_stealing && work_stealing_deque_empty(queue) && _split_tile(queue, tile))
+				state.stats.split_count++;
+
+			auto tile_start = std::chrono::steady_clock::now();
+			_render_tile(self, scene, view, target, sampler, tile, state.traversal);
+			auto tile_end = std::chrono::steady_clock::now();
+
+			state.stats.busy_ms += std::chrono::duration<double, std::milli>(tile_end - tile_start).count();
+			state.stats.tile_count++;
+
+			if (!has_first_tile.test_and_set(std::memory_order_relaxed))
+				first_tile_end = tile_end;
+
+			if (target.finished_tiles)
+			{
+				size_t x = tile.x * scale, y = tile.y * scale;
+				tile_queue_push(*target.finished_tiles, x, y,
+					std::min(tile.width * scale, target.width - x), std::min(tile.height * scale, target.height - y));
+			}
+
+			remaining_pixels.fetch_sub(int64_t(tile.width * tile.height), std::memory_order_release);
+		}
+	});
+
+	auto render_end = std::chrono::steady_clock::now();
+
+	stats.render_ms = std::chrono::duration<double, std::milli>(render_end - render_start).count();
+	stats.first_pixel_ms = std::chrono::duration<double, std::milli>(first_tile_end - frame_start).count();
+	stats.cancelled = is_cancelled.load(std::memory_order_relaxed);
+	stats.threads.resize(thread_count);
+
+	// Whatever threads left behind carries over, each deque in the order its
+	// owner would have taken it.
+	for (uint32_t i = 0; i < thread_count; i++)
+	{
+		size_t first = self.pending.tiles.size();
+
+		uint64_t item;
+		while (work_stealing_deque_take(self.queues[i], item))
+			self.pending.tiles.push_back(item);
+
+		std::reverse(self.pending.tiles.begin() + first, self.pending.tiles.end());
+	}
+
+	stats.is_complete = self.pending.tiles.empty();
+	self.pending.is_pending = !stats.is_complete;
+
+	if (accumulation)
+	{
+		// Coarse levels and unfinished frames only make up part of a pass.
+		if (scale == 1 && stats.is_complete)
+			accumulation_buffer_finish_pass(*accumulation, stats.render_ms);
+		else
+			accumulation->elapsed_ms += stats.render_ms;
+
+		stats.pass_count = accumulation->pass_count;
+		stats.accumulated_ms = accumulation->elapsed_ms;
+
+		size_t block_count = accumulation->blocks_x * accumulation->blocks_y;
+		stats.active_fraction = block_count ? float(accumulation->active_block_count) / float(block_count) : 0.0f;
+	}
+
+	double busy_ms = 0.0;
+	for (uint32_t i = 0; i < thread_count; i++)
+	{
+		RenderThreadStats& thread = stats.threads[i];
+		thread = thread_states[i].stats;
+		thread.idle_ms = std::max(0.0, stats.render_ms - thread.busy_ms);
+
+		busy_ms += thread.busy_ms;
+		traversal_stats_merge(stats.traversal, thread_states[i].traversal);
+	}
+
+	stats.load_balance = stats.render_ms > 0.0 ? float(busy_ms / (stats.render_ms * thread_count)) : 1.0f;
+
+	if (stats.traversal.rays)
+	{
+		double cost_ms = busy_ms / double(stats.traversal.rays);
+		self.sample_cost_ms = self.sample_cost_ms > 0.0 ? 0.75 * self.sample_cost_ms + 0.25 * cost_ms : cost_ms;
+	}
+
+	stats.sample_cost_ms = self.sample_cost_ms;
+
+	return stats;
+}
+
+RenderStats
+renderer_render(Renderer& self, const GeometryScene& scene, const RenderView& view, const RenderTarget& target,
+	AccumulationBuffer* accumulation, const std::atomic<bool>* cancel)
+{
+	return _render_frame(self, scene, view, target, 1, false, nullptr, 0, accumulation, cancel);
+}
+
+RenderStats
+renderer_render_preview(Renderer& self, const GeometryScene& scene, const RenderView& view, const RenderTarget& target,
+	uint32_t scale, bool refines, AccumulationBuffer* accumulation, const std::atomic<bool>* cancel)
+{
+	scale = std::min(std::max(scale, 1u), RENDER_PREVIEW_SCALE);
+
+	return _render_frame(self, scene, view, target, scale, refines && scale < RENDER_PREVIEW_SCALE, nullptr, 0, accumulation, cancel);
+}
+
+RenderStats
+renderer_render_regions(Renderer& self, const GeometryScene& scene, const RenderView& view, const RenderTarget& target,
+	const RenderRect* regions, size_t region_count, AccumulationBuffer* accumulation, const std::atomic<bool>* cancel)
+{
+	RenderStats stats {};
+	stats.is_complete = true;
+	if (!region_count)
+		return stats;
+
+	// Partial passes do not count, but the frame has to match what was
+	// accumulated so far.
+	uint32_t pass_count = accumulation ? accumulation->pass_count : 0;
+	double elapsed_ms = accumulation ? accumulation->elapsed_ms : 0.0;
+
+	stats = _render_frame(self, scene, view, target, 1, false, regions, region_count, accumulation, cancel);
+
+	if (accumulation)
+	{
+		accumulation->pass_count = pass_count;
+		accumulation->elapsed_ms = elapsed_ms + stats.render_ms;
+
+		stats.pass_count = accumulation->pass_count;
+		stats.accumulated_ms = accumulation->elapsed_ms;
+	}
+
+	return stats;
+}
+
+bool
+render_rect_project(const RenderView& view, const AABB& bounds, size_t width, size_t height, RenderRect& rect)
+{
+	Vec3f normal = vector_cross(view.pixel_delta_u, view.pixel_delta_v);
+	float plane_distance = vector_dot(normal, view.viewport_upper_left - view.center);
+
+	float u_scale = 1.0f / vector_dot(view.pixel_delta_u, view.pixel_delta_u);
+	float v_scale = 1.0f / vector_dot(view.pixel_delta_v, view.pixel_delta_v);
+
+	float min_u = INFINITY, min_v = INFINITY;
+	float max_u = -INFINITY, max_v = -INFINITY;
+
+	// The projection of the box is inside that of its corners as long as
+	// all of them are in front of the camera.
+	for (int corner = 0; corner < 8; corner++)
+	{
+		Vec3f point = {
+			corner & 1 ? bounds.max.x : bounds.min.x,
+			corner & 2 ? bounds.max.y : bounds.min.y,
+			corner & 4 ? bounds.max.z : bounds.min.z,
+		};
+
+		Vec3f direction = point - view.center;
+
+		float depth = vector_dot(normal, direction) / plane_distance;
+		if (!(depth > 1e-6f))
+		{
+			rect = { 0, 0, width, height };
+			return true;
+		}
+
+		Vec3f offset = view.center + direction / depth - view.viewport_upper_left;
+
+		float u = vector_dot(offset, view.pixel_delta_u) * u_scale;
+		float v = vector_dot(offset, view.pixel_delta_v) * v_scale;
+
+		min_u = std::min(min_u, u);
+		min_v = std::min(min_v, v);
+		max_u = std::max(max_u, u);
+		max_v = std::max(max_v, v);
+	}
+
+	// Samples are jittered up to half a pixel away from the pixel position.
+	float left = std::max(std::floor(min_u - 0.5f), 0.0f);
+	float top = std::max(std::floor(min_v - 0.5f), 0.0f);
+	float right = std::min(std::ceil(max_u + 0.5f) + 1.0f, float(width));
+	float bottom = std::min(std::ceil(max_v + 0.5f) + 1.0f, float(height));
+
+	if (!(left < right && top < bottom))
+		return false;
+
+	rect = { size_t(left), size_t(top), size_t(right - left), size_t(bottom - top) };
+	return true;
+}
+
+void
+render_rects_merge(std::vector<RenderRect>& rects, size_t width, size_t height)
+{
+	for (RenderRect& rect : rects)
+	{
+		size_t right = std::min(simd_round_up(rect.x + rect.width, RAY_PACKET_WIDTH), width);
+		size_t bottom = std::min(simd_round_up(rect.y + rect.height, RAY_PACKET_WIDTH), height);
+
+		rect.x -= rect.x % RAY_PACKET_WIDTH;
+		rect.y -= rect.y % RAY_PACKET_WIDTH;
+		rect.width = right > rect.x ? right - rect.x : 0;
+		rect.height = bottom > rect.y ? bottom - rect.y : 0;
+	}
+
+	rects.erase(std::remove_if(rects.begin(), rects.end(), [](const RenderRect& rect) {
+		return !rect.width || !rect.height;
+	}), rects.end());
+
+	// Merged rects can reach others that did not overlap before, so this
+	// repeats until nothing changes.
+	for (bool merged = true; merged; )
+	{
+		merged = false;
+
+		for (size_t i = 0; i < rects.size() && !merged; i++)
+		{
+			for (size_t j = i + 1; j < rects.size() && !merged; j++)
+			{
+				RenderRect& lhs = rects[i];
+				const RenderRect& rhs = rects[j];
+
+				if (lhs.x >= rhs.x + rhs.width || rhs.x >= lhs.x + lhs.width ||
+					lhs.y >= rhs.y + rhs.height || rhs.y >= lhs.y + lhs.height)
+					continue;
+
+				size_t right = std::max(lhs.x + lhs.width, rhs.x + rhs.width);
+				size_t bottom = std::max(lhs.y + lhs.height, rhs.y + rhs.height);
+
+				lhs.x = std::min(lhs.x, rhs.x);
+				lhs.y = std::min(lhs.y, rhs.y);
+				lhs.width = right - lhs.x;
+				lhs.height = bottom - lhs.y;
+
+				rects.erase(rects.begin() + j);
+				merged = true;
+			}
+		}
+	}
+}
+
+size_t
+render_target_get_pixel_size(const RenderTarget& self)
+{
+	return self.format == RenderFormat::RF_RGBA32 ? 4 : 3;
+}
@@ -4,12 +4,16 @@
 #include <cstdint>
 #include <functional>
 
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <thread>
 #include <condition_variable>
 
 #include <IMGUI/imgui.h>
 
+#include <Core/TileQueue.hpp>
+
 struct FrameBuffer;
 struct ApplicationWindow;
 
@@ -24,15 +28,50 @@ enum class FrameBufferFormat
 	FMT_RGBA32,
 };
 
+// Writable view of a frame buffer's back buffer, rows pitch bytes apart.
+// Valid until the next resize.
+struct FrameBufferView
+{
+	uint8_t* pixels;
+	size_t width, height;
+	size_t pitch;
+
+	FrameBufferFormat format;
+};
+
 struct ApplicationState
 {
 	bool is_dirty;
 	bool is_running;
+	bool is_refining; // keeps the render worker going without new input
+
+	// Raised together with is_dirty and lowered when the worker starts the
+	// next frame; the frame in flight gives up and is not presented.
+	std::atomic<bool> is_cancelled;
+
+	// The worker is inside a frame, drawing into the back buffer, which
+	// resizes wait out on frame_cv.
+	bool is_rendering;
+	std::condition_variable frame_cv;
+
+	// Oldest input not yet picked up by a frame, and the one the frame in
+	// flight answers, for input latency.
+	bool has_input;
+	bool frame_has_input;
+	std::chrono::steady_clock::time_point input_time;
+	std::chrono::steady_clock::time_point frame_input_time;
 
 	std::mutex mtx;
 	std::condition_variable cv;
 	std::thread render_worker_thread;
-} static g_state;
+};
+
+extern ApplicationState g_state;
+
+// Requests a new frame for changed input and cancels the one in flight.
+// Called with mtx held; the caller notifies cv once it is released.
+void
+application_state_mark_dirty(ApplicationState& self);
 
 FrameBuffer*
 framebuffer_new();
@@ -53,10 +92,41 @@ framebuffer_get_width(const FrameBuffer* self);
 size_t
 framebuffer_get_height(const FrameBuffer* self);
 
+// Triple buffered: frames are drawn straight into the back buffer, which the
+// render worker publishes once they are done, and the presenter takes the
+// latest published frame as its front buffer. Neither side locks or waits.
+// Only the worker may draw, sync or swap, and only the presenter acquire.
+FrameBufferView
+framebuffer_get_back_buffer(FrameBuffer* self);
+
+// Notes an area drawn other than through the finished tiles queue. A back
+// buffer lags the latest published frame wherever frames were drawn since it
+// last matched.
 void
-framebuffer_swap(FrameBuffer* self);
+framebuffer_mark_drawn(FrameBuffer* self, size_t x, size_t y, size_t width, size_t height);
+// Copies where the back buffer lags from the latest published frame, for
+// frames that draw over the last one instead of replacing all of it.
+void
+framebuffer_sync_back_buffer(FrameBuffer* self);
+
+// Publishes the back buffer and takes over the one it replaces.
 void
-framebuffer_update(FrameBuffer* self, void* buffer);
+framebuffer_swap(FrameBuffer* self);
+
+// Makes the latest published frame the front buffer, if there is a newer
+// one than the current, and returns whether there was.
+bool
+framebuffer_acquire_front(FrameBuffer* self);
+const void*
+framebuffer_get_front_buffer(const FrameBuffer* self);
+
+// Render workers push every rect they finish drawing into the back buffer,
+// from any thread, which counts as drawn like framebuffer_mark_drawn. Only
+// what changed is copied on sync and uploaded to the screen.
+TileQueue*
+framebuffer_get_finished_tiles(FrameBuffer* self);
+
+// Not safe while either side is using the buffers.
 void
 framebuffer_resize(FrameBuffer* self, size_t width, size_t height);
 
@@ -69,8 +139,10 @@ application_window_free(ApplicationWindow* self);
 FrameBuffer*
 application_window_get_framebuffer(ApplicationWindow* self);
 
+// RGBA32 frame buffers, the default, have rows aligned for vector stores.
 void
-application_window_create(ApplicationWindow* self, const char* title, size_t width = 0, size_t height = 0);
+application_window_create(ApplicationWindow* self, const char* title, size_t width = 0, size_t height = 0,
+	FrameBufferFormat format = FrameBufferFormat::FMT_RGBA32);
 void
 application_window_destroy(ApplicationWindow* self);
 
@@ -0,0 +1,66 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+using ThreadPoolJob = std::function<void(uint32_t)>;
+
+// Fixed set of worker threads that live as long as the pool and sleep between
+// jobs. A job runs once on every thread, the caller included as thread 0, and
+// splits its work itself; starting one costs a wake-up instead of a spawn.
+struct ThreadPool
+{
+	std::vector<std::thread> threads;
+
+	std::mutex mtx;
+	std::condition_variable start_cv;
+	std::condition_variable done_cv;
+
+	const ThreadPoolJob* job;
+	uint64_t job_generation;
+	uint32_t busy_count;
+
+	bool is_running;
+
+	// Hardware thread and NUMA node of every pool thread, empty while the
+	// threads may run anywhere.
+	std::vector<uint32_t> cpus;
+	std::vector<uint32_t> nodes;
+};
+
+// thread_count of 0 uses every hardware thread.
+void
+thread_pool_create(ThreadPool& self, uint32_t thread_count = 0);
+void
+thread_pool_destroy(ThreadPool& self);
+
+uint32_t
+thread_pool_get_thread_count(const ThreadPool& self);
+
+// Runs job(thread_index) on all threads and returns once every one finished.
+void
+thread_pool_run(ThreadPool& self, const ThreadPoolJob& job);
+
+// Pins thread i to the i-th hardware thread the process may run on, counted
+// NUMA node by node, so neighbouring thread indices share a node. The caller
+// is pinned as thread 0 and should be the one running jobs. Unpinning lets
+// every thread run anywhere again. Returns false where affinity is not
+// supported, leaving the threads as they were.
+bool
+thread_pool_set_pinned(ThreadPool& self, bool is_pinned);
+
+static bool
+thread_pool_is_pinned(const ThreadPool& self);
+// NUMA node a pinned thread runs on; 0 while unpinned.
+static uint32_t
+thread_pool_get_node(const ThreadPool& self, uint32_t thread_index);
+
+#endif
+
+#include "../../Private/Core/ThreadPool.inl"
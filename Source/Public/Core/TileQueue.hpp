@@ -0,0 +1,47 @@
+#ifndef TILE_QUEUE_HPP
+#define TILE_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded multi-producer, single-consumer queue of finished pixel rectangles
+// (Vyukov's bounded queue). Any thread may push; only the consumer pops. Each
+// slot carries a sequence number telling whose turn it is, so producers only
+// contend on the tail. Pushes to a full queue are dropped and flagged instead
+// of waiting, and the consumer falls back on assuming everything changed.
+struct TileQueue
+{
+	alignas(64) std::atomic<size_t> tail;
+	alignas(64) size_t head;
+
+	std::atomic<bool> has_dropped;
+
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		uint64_t rect; // x, y, width and height as four 16-bit fields
+	};
+
+	alignas(64) Slot* slots;
+	size_t mask;
+};
+
+// Capacity is rounded up to a power of two.
+void
+tile_queue_create(TileQueue& self, size_t capacity);
+void
+tile_queue_destroy(TileQueue& self);
+
+static void
+tile_queue_push(TileQueue& self, size_t x, size_t y, size_t width, size_t height);
+static bool
+tile_queue_pop(TileQueue& self, size_t& x, size_t& y, size_t& width, size_t& height);
+
+// Returns whether pushes were dropped since the last call.
+static bool
+tile_queue_take_dropped(TileQueue& self);
+
+#endif
+
+#include "../../Private/Core/TileQueue.inl"
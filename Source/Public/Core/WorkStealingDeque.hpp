@@ -0,0 +1,45 @@
+#ifndef WORK_STEALING_DEQUE_HPP
+#define WORK_STEALING_DEQUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded Chase-Lev deque of 64-bit work items (Le, Pop, Cohen, Zappa Nardelli
+// 2013). The owning thread pushes and takes at the bottom, LIFO, while any
+// other thread steals from the top, FIFO, so thieves take the oldest and
+// usually largest items. Only the owner may push, take or reset.
+struct WorkStealingDeque
+{
+	alignas(64) std::atomic<int64_t> top;
+	alignas(64) std::atomic<int64_t> bottom;
+
+	alignas(64) std::atomic<uint64_t>* items;
+	size_t mask;
+};
+
+// Capacity is rounded up to a power of two and must hold every item queued at
+// the same time; pushing past it is a bug.
+void
+work_stealing_deque_create(WorkStealingDeque& self, size_t capacity);
+void
+work_stealing_deque_destroy(WorkStealingDeque& self);
+
+// Empties the deque. Not safe while other threads may steal.
+static void
+work_stealing_deque_reset(WorkStealingDeque& self);
+
+static void
+work_stealing_deque_push(WorkStealingDeque& self, uint64_t item);
+static bool
+work_stealing_deque_take(WorkStealingDeque& self, uint64_t& item);
+// Fails both when the deque is empty and when another thread won the race.
+static bool
+work_stealing_deque_steal(WorkStealingDeque& self, uint64_t& item);
+
+static bool
+work_stealing_deque_empty(const WorkStealingDeque& self);
+
+#endif
+
+#include "../../Private/Core/WorkStealingDeque.inl"
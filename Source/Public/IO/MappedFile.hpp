@@ -0,0 +1,27 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+
+// Read-only view of a whole file mapped into the address space. Pages are
+// faulted in on first access, so opening a large file costs nothing until it
+// is parsed.
+struct MappedFile
+{
+	const char* data;
+	size_t size;
+
+#if defined(_WIN32)
+	void* file;
+	void* mapping;
+#else
+	int fd;
+#endif
+};
+
+bool
+mapped_file_open(MappedFile& self, const char* filename);
+void
+mapped_file_close(MappedFile& self);
+
+#endif
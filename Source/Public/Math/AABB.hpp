@@ -0,0 +1,38 @@
+#ifndef AABB_HPP
+#define AABB_HPP
+
+#include <Math/Ray.hpp>
+#include <Math/Vector.hpp>
+#include <Math/Constants.hpp>
+
+// Far slab distances are scaled by 1 + 2 * gamma(3) so that rounding in the
+// slab test can not reject a ray grazing a box exactly at a primitive's vertex.
+constexpr float AABB_FAR_SCALE = 1.0000004f;
+
+struct AABB
+{
+	Vec3f min;
+	Vec3f max;
+};
+
+static AABB
+aabb_empty();
+
+static void
+aabb_expand(AABB& self, const Vec3f& point);
+static void
+aabb_expand(AABB& self, const AABB& other);
+
+static Vec3f
+aabb_extent(const AABB& self);
+static Vec3f
+aabb_centroid(const AABB& self);
+static float
+aabb_surface_area(const AABB& self);
+
+static bool
+aabb_intersect(const AABB& self, const Ray& ray, const Vec3f& inv_direction, float ray_tmin, float ray_tmax, float& t);
+
+#endif
+
+#include "../../Private/Math/AABB.inl"
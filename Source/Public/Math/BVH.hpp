@@ -0,0 +1,103 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include <Math/Ray.hpp>
+#include <Math/AABB.hpp>
+#include <Math/Hittable.hpp>
+
+struct BVHNode
+{
+	AABB bounds;
+
+	uint32_t offset; // first child for interior nodes, first index for leaves
+	uint32_t count;  // primitive count, zero for interior nodes
+};
+
+struct TraversalStats
+{
+	uint64_t rays;
+	uint64_t nodes_visited;
+	uint64_t leaves_visited;
+};
+
+struct BVH
+{
+	std::vector<BVHNode> nodes;
+	std::vector<uint32_t> indices;
+
+	// SAH cost of every subtree relative to its own root area, as last built.
+	// Refitted trees are measured against it to find degraded subtrees.
+	std::vector<float> costs;
+};
+
+// Deepest node the builder produces, with the root at depth 0. Traversals size
+// their fixed stacks from it and cached trees deeper than it are rejected.
+constexpr uint32_t BVH_MAX_DEPTH = 64;
+
+// Updates whose root SAH cost grows past this factor of the built cost
+// rebuild their degraded subtrees instead of only refitting.
+constexpr float BVH_REBUILD_THRESHOLD = 1.3f;
+
+enum class BVHUpdateType
+{
+	BU_NONE = 0,
+
+	BU_REFIT,
+	BU_PARTIAL_REBUILD,
+	BU_FULL_REBUILD,
+};
+
+struct BVHUpdateStats
+{
+	BVHUpdateType type;
+
+	uint32_t rebuilt_primitives;
+
+	// Root SAH cost relative to the last build, after refitting and after the
+	// update completed.
+	float refit_cost_ratio;
+	float cost_ratio;
+
+	double refit_ms;
+	double rebuild_ms;
+};
+
+void
+bvh_build(BVH& self, const AABB* bounds, size_t count);
+void
+bvh_build(BVH& self, const HittableList& hittable_list);
+
+void
+bvh_clear(BVH& self);
+
+// Recomputes every node bound bottom-up from new primitive bounds, keeping the
+// topology. Bounds are indexed like the ones the tree was built from.
+void
+bvh_refit(BVH& self, const AABB* bounds);
+// Refits, then rebuilds the subtrees whose SAH cost degraded past threshold.
+// Falls back to a full rebuild when the tree as a whole stays degraded.
+BVHUpdateStats
+bvh_update(BVH& self, const AABB* bounds, size_t count, float threshold = BVH_REBUILD_THRESHOLD);
+
+float
+bvh_sah_cost(const BVH& self);
+
+void
+traversal_stats_merge(TraversalStats& self, const TraversalStats& other);
+
+template<typename InLeafFn>
+bool
+bvh_traverse_leaves(const BVH& self, const Ray& ray, float ray_tmin, float& ray_tmax, InLeafFn leaf_fn, TraversalStats* stats = nullptr);
+template<typename InLeafFn>
+bool
+bvh_traverse(const BVH& self, const Ray& ray, float ray_tmin, float& ray_tmax, InLeafFn leaf_fn);
+
+const HitRecord
+bvh_hit(const BVH& self, HittableList& hittable_list, const Ray& ray, float ray_tmin, float ray_tmax);
+
+#endif
+
+#include "../../Private/Math/BVH.inl"
@@ -0,0 +1,100 @@
+#ifndef GEOMETRY_HPP
+#define GEOMETRY_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include <Math/BVH.hpp>
+#include <Math/Ray.hpp>
+#include <Math/RayPacket.hpp>
+#include <Math/WideBVH.hpp>
+#include <Math/Hittable.hpp>
+#include <Math/Instance.hpp>
+#include <Math/SphereSoA.hpp>
+#include <Math/TriangleMesh.hpp>
+
+enum class AccelerationType
+{
+	AT_BVH2 = 0,
+	AT_BVH4,
+	AT_BVH8,
+};
+
+// Non-owning reference into one of the per-type primitive batches of a
+// GeometryScene.
+struct GeometryHandle
+{
+	HittableType type;
+	uint32_t index;
+};
+
+struct GeometryHit
+{
+	float t;
+	GeometryHandle handle;
+
+	bool hit;
+
+	// Meshes and instances only: the hit triangle and its barycentrics.
+	uint32_t primitive;
+	float u, v;
+};
+
+// Flattened copy of a HittableList with primitives grouped by concrete type.
+// Batches are stored in BVH leaf order and every leaf keeps its primitives
+// sorted by type, so each run of same-typed primitives in a leaf maps onto a
+// contiguous range of its batch and is intersected by one kernel call.
+// The wide hierarchies are collapsed from the binary one and share its leaves.
+// Meshes and instances are referenced rather than copied and must outlive the
+// scene. With instances, bvh is the top level over their world bounds and the
+// shared mesh BVHs are the bottom level.
+struct GeometryScene
+{
+	AccelerationType acceleration;
+
+	BVH bvh;
+	BVH4 bvh4;
+	BVH8 bvh8;
+
+	SphereSoA spheres;
+	std::vector<const TriangleMesh*> meshes;
+	std::vector<const Instance*> instances;
+
+	std::vector<GeometryHandle> handles;
+	// Position in the HittableList the scene was built from, per handle.
+	std::vector<uint32_t> sources;
+};
+
+void
+geometry_scene_create(GeometryScene& self);
+void
+geometry_scene_destroy(GeometryScene& self);
+
+void
+geometry_scene_build(GeometryScene& self, const HittableList& hittable_list);
+
+// Picks up moved or resized hittables of the list the scene was built from.
+// Batched copies are refreshed and the BVH is refitted, with degraded subtrees
+// rebuilt past threshold. The list must hold the same hittables in the same
+// order; anything else is a full rebuild.
+BVHUpdateStats
+geometry_scene_update(GeometryScene& self, const HittableList& hittable_list, float threshold = BVH_REBUILD_THRESHOLD);
+
+void
+geometry_scene_set_acceleration(GeometryScene& self, AccelerationType acceleration);
+
+const GeometryHit
+geometry_scene_intersect(const GeometryScene& self, const Ray& ray, float ray_tmin, float ray_tmax, TraversalStats* stats = nullptr);
+
+// Traces a packet of rays sharing one origin through the binary BVH, writing
+// one hit per ray. Incoherent packets fall back to single-ray traversal with
+// the selected acceleration structure.
+void
+geometry_scene_intersect_packet(const GeometryScene& self, RayPacket& packet, GeometryHit* hits, TraversalStats* stats = nullptr);
+
+const HitRecord
+geometry_scene_hit_record(const GeometryScene& self, const GeometryHit& hit, const Ray& ray);
+const HitRecord
+geometry_scene_hit(const GeometryScene& self, const Ray& ray, float ray_tmin, float ray_tmax, TraversalStats* stats = nullptr);
+
+#endif
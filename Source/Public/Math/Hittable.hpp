@@ -3,8 +3,10 @@
 
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 #include <Math/Ray.hpp>
+#include <Math/AABB.hpp>
 
 struct HitRecord
 {
@@ -12,6 +14,10 @@ struct HitRecord
 	float tmin;
 	float tmax;
 
+	// Barycentric coordinates of the hit, only set by triangle meshes.
+	float u;
+	float v;
+
 	Vec3f point;
 	Vec3f normal;
 
@@ -19,9 +25,21 @@ struct HitRecord
 	bool front_face;
 };
 
+enum class HittableType : uint8_t
+{
+	HT_NULL = 0,
+
+	HT_SPHERE,
+	HT_MESH,
+	HT_INSTANCE,
+};
+
 struct Hittable
 {
-	HitRecord (*hit)(std::shared_ptr<Hittable> hittable, const Ray& ray, double ray_tmin, double ray_tmax);
+	HittableType type;
+
+	HitRecord (*hit)(const Hittable* hittable, const Ray& ray, float ray_tmin, float ray_tmax);
+	AABB (*bounds)(const Hittable* hittable);
 };
 
 using HittableList = std::vector<std::shared_ptr<Hittable>>;
@@ -0,0 +1,38 @@
+#ifndef INSTANCE_HPP
+#define INSTANCE_HPP
+
+#include <Math/BVH.hpp>
+#include <Math/Ray.hpp>
+#include <Math/AABB.hpp>
+#include <Math/Hittable.hpp>
+#include <Math/Transform.hpp>
+#include <Math/TriangleMesh.hpp>
+
+#include <Graphics/Renderable.hpp>
+
+// Placement of a shared triangle mesh in the world. The mesh and its BVH are
+// referenced, not copied, so any number of instances cost one mesh plus a
+// transform pair each. Rays are moved into object space and traced through
+// the mesh BVH there; the mesh must outlive its instances.
+struct Instance : public Hittable, Renderable
+{
+	const TriangleMesh* mesh;
+
+	Transform object_to_world;
+	Transform world_to_object;
+
+	AABB bounding_box;
+};
+
+void
+instance_create(Instance& self, const TriangleMesh* mesh, const Transform& object_to_world);
+
+void
+instance_set_transform(Instance& self, const Transform& object_to_world);
+
+const TriangleHit
+instance_intersect(const Instance& self, const Ray& ray, float ray_tmin, float ray_tmax, TraversalStats* stats = nullptr);
+const HitRecord
+instance_hit_record(const Instance& self, const TriangleHit& hit, const Ray& ray);
+
+#endif
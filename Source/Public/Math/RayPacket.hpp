@@ -0,0 +1,65 @@
+#ifndef RAY_PACKET_HPP
+#define RAY_PACKET_HPP
+
+#include <cstdint>
+
+#include <Math/BVH.hpp>
+#include <Math/Ray.hpp>
+#include <Math/AABB.hpp>
+#include <Math/SIMD.hpp>
+#include <Math/Vector.hpp>
+
+constexpr uint32_t RAY_PACKET_WIDTH = 8;
+constexpr uint32_t RAY_PACKET_SIZE = RAY_PACKET_WIDTH * RAY_PACKET_WIDTH;
+
+// A bundle of rays sharing one origin, stored per component. Lanes past count
+// are padding with an empty [tmin, tmax] interval so SIMD loops never need a
+// tail. The packet is coherent when every direction component keeps the same
+// sign across all rays; only then does the inverse direction interval bound
+// the whole packet and allow conservative culling of entire subtrees.
+struct RayPacket
+{
+	alignas(64) float direction_x[RAY_PACKET_SIZE];
+	alignas(64) float direction_y[RAY_PACKET_SIZE];
+	alignas(64) float direction_z[RAY_PACKET_SIZE];
+
+	alignas(64) float inv_direction_x[RAY_PACKET_SIZE];
+	alignas(64) float inv_direction_y[RAY_PACKET_SIZE];
+	alignas(64) float inv_direction_z[RAY_PACKET_SIZE];
+
+	alignas(64) float tmax[RAY_PACKET_SIZE];
+
+	Vec3f origin;
+	float tmin;
+
+	uint32_t count;
+
+	Vec3f mean_direction;
+	Vec3f inv_direction_min;
+	Vec3f inv_direction_max;
+
+	bool coherent;
+};
+
+void
+ray_packet_create(RayPacket& self, const Vec3f& origin, float ray_tmin, float ray_tmax);
+void
+ray_packet_add(RayPacket& self, const Vec3f& direction);
+void
+ray_packet_finalize(RayPacket& self);
+
+static Ray
+ray_packet_get_ray(const RayPacket& self, uint32_t index);
+
+bool
+ray_packet_cull(const RayPacket& self, const AABB& bounds, float packet_tmax);
+uint32_t
+ray_packet_first_hit(const RayPacket& self, const AABB& bounds, uint32_t first);
+
+template<typename InLeafFn>
+void
+ray_packet_traverse_leaves(const BVH& bvh, RayPacket& packet, InLeafFn leaf_fn, TraversalStats* stats = nullptr);
+
+#endif
+
+#include "../../Private/Math/RayPacket.inl"
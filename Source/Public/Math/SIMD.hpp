@@ -0,0 +1,42 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__AVX2__)
+	#define SIMD_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SIMD_SSE2 1
+#endif
+
+#if defined(SIMD_AVX2) || defined(SIMD_SSE2)
+	#include <immintrin.h>
+#endif
+
+#if defined(SIMD_AVX2)
+	constexpr size_t SIMD_WIDTH = 8;
+#elif defined(SIMD_SSE2)
+	constexpr size_t SIMD_WIDTH = 4;
+#else
+	constexpr size_t SIMD_WIDTH = 1;
+#endif
+
+constexpr size_t SIMD_ALIGNMENT = 64;
+
+static void*
+simd_aligned_alloc(size_t size, size_t alignment = SIMD_ALIGNMENT);
+static void
+simd_aligned_free(void* ptr);
+
+static size_t
+simd_round_up(size_t count, size_t multiple);
+
+static uint32_t
+simd_count_trailing_zeros(uint32_t mask);
+
+#endif
+
+#include "../../Private/Math/SIMD.inl"
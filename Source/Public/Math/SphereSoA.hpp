@@ -0,0 +1,54 @@
+#ifndef SPHERE_SOA_HPP
+#define SPHERE_SOA_HPP
+
+#include <cstdint>
+
+#include <Math/Ray.hpp>
+#include <Math/SIMD.hpp>
+#include <Math/Vector.hpp>
+#include <Math/Hittable.hpp>
+
+// Sphere storage split into one aligned float array per component, padded so
+// that the SIMD kernel can always load a full register past any index.
+struct SphereSoA
+{
+	float* center_x;
+	float* center_y;
+	float* center_z;
+	float* radius;
+
+	size_t count;
+	size_t capacity;
+};
+
+struct SphereSoAHit
+{
+	float t;
+	uint32_t index;
+
+	bool hit;
+};
+
+void
+sphere_soa_create(SphereSoA& self, size_t capacity = 0);
+void
+sphere_soa_destroy(SphereSoA& self);
+
+void
+sphere_soa_reserve(SphereSoA& self, size_t capacity);
+uint32_t
+sphere_soa_add(SphereSoA& self, float radius, Vec3f center);
+void
+sphere_soa_set(SphereSoA& self, uint32_t index, float radius, Vec3f center);
+void
+sphere_soa_clear(SphereSoA& self);
+
+const SphereSoAHit
+sphere_soa_intersect(const SphereSoA& self, const Ray& ray, float ray_tmin, float ray_tmax);
+const SphereSoAHit
+sphere_soa_intersect(const SphereSoA& self, size_t first, size_t count, const Ray& ray, float ray_tmin, float ray_tmax);
+
+const HitRecord
+sphere_soa_hit_record(const SphereSoA& self, uint32_t index, const Ray& ray, float t);
+
+#endif
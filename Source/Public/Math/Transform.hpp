@@ -0,0 +1,47 @@
+#ifndef TRANSFORM_HPP
+#define TRANSFORM_HPP
+
+#include <Math/Ray.hpp>
+#include <Math/AABB.hpp>
+#include <Math/Vector.hpp>
+
+// Affine transform stored as the top three rows of a 4x4 row-major matrix.
+struct Transform
+{
+	float m[3][4];
+};
+
+static Transform
+transform_identity();
+static Transform
+transform_translate(const Vec3f& translation);
+static Transform
+transform_scale(const Vec3f& scale);
+static Transform
+transform_rotate(const Vec3f& axis, float radians);
+
+// Returns lhs * rhs, which applies rhs first.
+static Transform
+transform_multiply(const Transform& lhs, const Transform& rhs);
+static Transform
+transform_inverse(const Transform& self);
+
+static Vec3f
+transform_point(const Transform& self, const Vec3f& point);
+static Vec3f
+transform_vector(const Transform& self, const Vec3f& vector);
+// Transforms a normal by the transpose of inverse, the inverse of the
+// transform the surface was moved by.
+static Vec3f
+transform_normal(const Transform& inverse, const Vec3f& normal);
+
+// Transforms origin and direction. The direction is not renormalized, so hit
+// distances stay comparable between both spaces.
+static Ray
+transform_ray(const Transform& self, const Ray& ray);
+static AABB
+transform_aabb(const Transform& self, const AABB& aabb);
+
+#endif
+
+#include "../../Private/Math/Transform.inl"
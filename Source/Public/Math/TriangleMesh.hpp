@@ -0,0 +1,91 @@
+#ifndef TRIANGLE_MESH_HPP
+#define TRIANGLE_MESH_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include <Math/BVH.hpp>
+#include <Math/Ray.hpp>
+#include <Math/AABB.hpp>
+#include <Math/SIMD.hpp>
+#include <Math/Vector.hpp>
+#include <Math/WideBVH.hpp>
+#include <Math/Hittable.hpp>
+
+#include <Graphics/Renderable.hpp>
+
+constexpr size_t MESH_BVH_WIDTH = SIMD_WIDTH >= 8 ? 8 : 4;
+
+using MeshBVH = WideBVH<MESH_BVH_WIDTH>;
+using MeshBVHNode = WideBVHNode<MESH_BVH_WIDTH>;
+
+// Triangle vertices copied out of the indexed buffers into BVH leaf order and
+// split per component, so that a leaf is one contiguous range the SIMD kernel
+// can load directly. primitive maps every slot back to its source triangle.
+struct TriangleSoA
+{
+	float* v0_x; float* v0_y; float* v0_z;
+	float* v1_x; float* v1_y; float* v1_z;
+	float* v2_x; float* v2_y; float* v2_z;
+
+	uint32_t* primitive;
+
+	size_t count;
+};
+
+struct TriangleHit
+{
+	float t;
+	float u, v;
+
+	uint32_t index; // slot in the leaf ordered triangles
+
+	bool hit;
+};
+
+struct TriangleMesh : public Hittable, Renderable
+{
+	std::vector<Vec3f> positions;
+	std::vector<uint32_t> indices;
+
+	AABB bounding_box;
+
+	BVH bvh;
+	MeshBVH wide_bvh;
+	TriangleSoA triangles;
+
+	// The nodes traversal reads, wide_bvh's own after a build. External meshes
+	// point these and the triangles into memory they do not own.
+	const MeshBVHNode* nodes;
+	size_t node_count;
+
+	bool is_external;
+};
+
+void
+triangle_mesh_create(TriangleMesh& self);
+void
+triangle_mesh_create(TriangleMesh& self, const Vec3f* positions, size_t vertex_count, const uint32_t* indices, size_t index_count);
+// Wraps render data kept elsewhere, such as a mapped BVH cache, which has to
+// outlive the mesh. Such a mesh intersects and shades like a built one but has
+// no positions, indices or binary BVH to rebuild from.
+void
+triangle_mesh_create(TriangleMesh& self, const AABB& bounds, const MeshBVHNode* nodes, size_t node_count, const TriangleSoA& triangles);
+void
+triangle_mesh_destroy(TriangleMesh& self);
+
+void
+triangle_mesh_build(TriangleMesh& self);
+
+size_t
+triangle_mesh_get_triangle_count(const TriangleMesh& self);
+
+const TriangleHit
+triangle_mesh_intersect(const TriangleMesh& self, const Ray& ray, float ray_tmin, float ray_tmax, TraversalStats* stats = nullptr);
+const HitRecord
+triangle_mesh_hit_record(const TriangleMesh& self, const TriangleHit& hit, const Ray& ray);
+
+const TriangleHit
+triangle_soa_intersect(const TriangleSoA& self, size_t first, size_t count, const Ray& ray, float ray_tmin, float ray_tmax);
+
+#endif
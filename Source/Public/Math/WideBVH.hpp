@@ -0,0 +1,50 @@
+#ifndef WIDE_BVH_HPP
+#define WIDE_BVH_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include <Math/BVH.hpp>
+#include <Math/Ray.hpp>
+#include <Math/SIMD.hpp>
+
+// Child bounds are stored per component so that a single SIMD sequence tests
+// the ray against every child of a node. Unused slots hold an inverted (empty)
+// box and never report a hit.
+template<size_t InWidth>
+struct alignas(64) WideBVHNode
+{
+	float min_x[InWidth], min_y[InWidth], min_z[InWidth];
+	float max_x[InWidth], max_y[InWidth], max_z[InWidth];
+
+	uint32_t offset[InWidth]; // child node for interior children, first index for leaves
+	uint32_t count[InWidth];  // primitive count, zero for interior children
+};
+
+template<size_t InWidth>
+struct WideBVH
+{
+	std::vector<WideBVHNode<InWidth>> nodes;
+};
+
+using BVH4 = WideBVH<4>;
+using BVH8 = WideBVH<8>;
+
+template<size_t InWidth>
+void
+wide_bvh_build(WideBVH<InWidth>& self, const BVH& bvh);
+template<size_t InWidth>
+void
+wide_bvh_clear(WideBVH<InWidth>& self);
+
+template<size_t InWidth, typename InLeafFn>
+bool
+wide_bvh_traverse_leaves(const WideBVH<InWidth>& self, const Ray& ray, float ray_tmin, float& ray_tmax, InLeafFn leaf_fn, TraversalStats* stats = nullptr);
+// Same traversal over a node array held outside a WideBVH, e.g. in a mapped file.
+template<size_t InWidth, typename InLeafFn>
+bool
+wide_bvh_traverse_leaves(const WideBVHNode<InWidth>* nodes, size_t node_count, const Ray& ray, float ray_tmin, float& ray_tmax, InLeafFn leaf_fn, TraversalStats* stats = nullptr);
+
+#endif
+
+#include "../../Private/Math/WideBVH.inl"
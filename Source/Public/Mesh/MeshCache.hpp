@@ -0,0 +1,66 @@
+#ifndef MESH_CACHE_HPP
+#define MESH_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <IO/MappedFile.hpp>
+#include <Math/TriangleMesh.hpp>
+#include <Mesh/MeshLoader.hpp>
+
+// Bumped whenever the file layout or the BVH builder changes, which makes
+// every existing cache stale.
+constexpr uint32_t MESH_CACHE_VERSION = 1;
+
+// Binary image of a built mesh: bounds, wide BVH nodes and the leaf ordered
+// triangles, each section 64 byte aligned so that a mapped cache is traversed
+// in place. The header records the hash of the source file it was built from
+// and the node width, so caches are only reused by a matching build.
+struct MeshCache
+{
+	MappedFile file;
+
+	bool is_open;
+};
+
+struct MeshCacheStats
+{
+	bool hit;
+
+	size_t bytes; // cache file size
+
+	double hash_ms;
+	double open_ms;
+	double write_ms;
+
+	MeshLoadStats load; // misses only
+};
+
+void
+mesh_cache_create(MeshCache& self);
+
+// Maps filename and points mesh at it when it is a valid cache for
+// source_hash. The mesh is only usable until the cache is closed.
+bool
+mesh_cache_open(MeshCache& self, TriangleMesh& mesh, const char* filename, uint64_t source_hash);
+void
+mesh_cache_close(MeshCache& self);
+
+// Writes a built mesh next to a temporary name and renames it over filename,
+// so a cache is never observed half written.
+bool
+mesh_cache_write(const TriangleMesh& mesh, const char* filename, uint64_t source_hash);
+
+// 64-bit content hash, computed over fixed size chunks in parallel. The value
+// does not depend on thread_count; 0 uses every hardware thread.
+uint64_t
+mesh_cache_hash(const void* data, size_t size, uint32_t thread_count = 0);
+
+// Loads an OBJ or PLY file through its cache, cache_filename or filename with
+// ".bvh" appended. A cache matching the file's hash is mapped without parsing
+// or building; otherwise the file is loaded and the cache rewritten.
+bool
+triangle_mesh_load_cached(TriangleMesh& self, MeshCache& cache, const char* filename, const char* cache_filename = nullptr,
+	uint32_t thread_count = 0, MeshCacheStats* stats = nullptr);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef MESH_LOADER_HPP
+#define MESH_LOADER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Math/TriangleMesh.hpp>
+
+struct MeshLoadStats
+{
+	size_t bytes;
+	size_t vertex_count;
+	size_t triangle_count;
+
+	uint32_t thread_count;
+
+	double parse_ms;
+	double build_ms;
+};
+
+// Loads a Wavefront OBJ or PLY (ascii or binary little endian) file into a
+// triangle mesh and builds its BVH. The file is memory mapped and split into
+// line-aligned chunks that are parsed in parallel straight into the mesh
+// buffers. Polygons are fan triangulated and only positions are read.
+// thread_count of 0 uses every hardware thread.
+bool
+triangle_mesh_load(TriangleMesh& self, const char* filename, uint32_t thread_count = 0, MeshLoadStats* stats = nullptr);
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef ACCUMULATION_HPP
+#define ACCUMULATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Render/Renderer.hpp>
+
+// Adaptive sampling decides per packet sized block of pixels.
+constexpr size_t ACCUMULATION_BLOCK_SIZE = RAY_PACKET_WIDTH;
+// Passes every block takes before its error estimate is trusted.
+constexpr uint32_t ACCUMULATION_MIN_ADAPTIVE_PASSES = 8;
+
+// Running per-pixel sums of every sample rendered since the last reset, and
+// how many samples each pixel took. The view is remembered so that a frame
+// rendered from anywhere else starts over instead of blending two images.
+// With an error threshold, blocks whose largest standard error of the mean
+// luminance fell below it stop taking samples.
+struct AccumulationBuffer
+{
+	float* color;   // RGB sums
+	float* squares; // luminance square sums
+	uint32_t* sample_counts;
+
+	size_t width, height;
+
+	uint8_t* active_blocks;
+	size_t blocks_x, blocks_y;
+	size_t active_block_count;
+
+	float error_threshold; // 0 samples every pixel in every pass
+
+	RenderView view;
+
+	uint32_t pass_count;
+	double elapsed_ms; // rendering time since the last reset
+
+	// Nothing was rendered into the sums since they were cleared, which
+	// resets then skip, leaving fresh pages untouched.
+	bool is_empty;
+};
+
+void
+accumulation_buffer_create(AccumulationBuffer& self);
+void
+accumulation_buffer_destroy(AccumulationBuffer& self);
+
+void
+accumulation_buffer_reset(AccumulationBuffer& self);
+// Drops the samples of a single region, whose blocks are sampled again.
+void
+accumulation_buffer_reset_region(AccumulationBuffer& self, const RenderRect& region);
+
+// Resets when the size or view differs from what was accumulated, reallocating
+// on resizes, with pages left for the renderer to touch first. Returns whether
+// it did. Preview levels accumulate before the
+// first pass is counted, so the view is compared even without passes.
+bool
+accumulation_buffer_prepare(AccumulationBuffer& self, size_t width, size_t height, const RenderView& view);
+
+// Blocks skipped for a higher threshold are sampled again after a change.
+void
+accumulation_buffer_set_error_threshold(AccumulationBuffer& self, float error_threshold);
+
+// Estimates the error of a block from its samples, which the caller must not
+// be adding to concurrently, and returns whether it needs more.
+bool
+accumulation_buffer_update_block(AccumulationBuffer& self, size_t block_x, size_t block_y);
+
+static bool
+accumulation_buffer_is_block_active(const AccumulationBuffer& self, size_t block_x, size_t block_y);
+
+// Counts a pass, rendered in elapsed_ms, and the blocks still active after it.
+void
+accumulation_buffer_finish_pass(AccumulationBuffer& self, double elapsed_ms);
+
+// Writes the mean of every pixel to target, which has to match in size.
+// RGBA32 targets are written a vector of pixels at a time.
+void
+accumulation_buffer_resolve(const AccumulationBuffer& self, const RenderTarget& target);
+
+// Debug view of where samples went: pixels are shaded from blue, for the
+// fewest samples, to red, for the most.
+void
+accumulation_buffer_resolve_density(const AccumulationBuffer& self, const RenderTarget& target);
+
+#endif
+
+#include "../../Private/Render/Accumulation.inl"
@@ -0,0 +1,260 @@
+#ifndef RENDERER_HPP
+#define RENDERER_HPP
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <Core/TileQueue.hpp>
+#include <Core/ThreadPool.hpp>
+#include <Core/WorkStealingDeque.hpp>
+
+#include <Math/BVH.hpp>
+#include <Math/AABB.hpp>
+#include <Math/Vector.hpp>
+#include <Math/Geometry.hpp>
+#include <Math/RayPacket.hpp>
+
+constexpr uint32_t RENDER_DEFAULT_TILE_SIZE = 32;
+// Coarsest level of the interactive preview, in pixels per sample and axis.
+constexpr uint32_t RENDER_PREVIEW_SCALE = 8;
+
+struct AccumulationBuffer;
+
+// Pinhole camera reduced to what primary rays need: the ray through pixel
+// (x, y) starts at center and passes viewport_upper_left + x * pixel_delta_u +
+// y * pixel_delta_v.
+struct RenderView
+{
+	Vec3f center;
+
+	Vec3f viewport_upper_left;
+	Vec3f pixel_delta_u;
+	Vec3f pixel_delta_v;
+};
+
+// Pixel rectangle of a frame.
+struct RenderRect
+{
+	size_t x, y;
+	size_t width, height;
+};
+
+// Byte order of target pixels. RGBA32 pixels are opaque and take single
+// 32-bit stores; rows starting on SIMD_ALIGNMENT let resolves store whole
+// vectors of them.
+enum class RenderFormat
+{
+	RF_RGB24 = 0,
+	RF_RGBA32,
+};
+
+// Pixels rows pitch bytes apart. Every tile is pushed to finished_tiles, when
+// set, as the pixels it wrote once it is done.
+struct RenderTarget
+{
+	uint8_t* pixels;
+
+	size_t width, height;
+	size_t pitch;
+
+	RenderFormat format;
+
+	TileQueue* finished_tiles;
+};
+
+// Order tiles are dealt out in, packets are traced in within a tile and
+// pixels are traced in within a packet when packet tracing is off. The space
+// filling curves keep consecutive rays close on screen and in the scene.
+enum class RenderOrder
+{
+	RO_SCANLINE = 0,
+	RO_MORTON,
+	RO_HILBERT,
+};
+
+struct RenderSettings
+{
+	uint32_t thread_count; // 0 uses every hardware thread
+	uint32_t tile_size;    // rounded up to whole ray packets
+
+	bool packet_tracing;
+	bool work_stealing;    // off keeps every thread on its static share
+
+	RenderOrder order;
+
+	// Threads stop taking tiles that would not finish within budget_ms of
+	// the frame start and the frame returns incomplete. 0 renders whole
+	// frames.
+	float budget_ms;
+
+	// Pins render threads to hardware threads, node by node. With first_touch
+	// every page of a new target or accumulation buffer is first written by
+	// the thread whose share of the frame holds it, which places it on that
+	// thread's NUMA node; buffers have to be freshly allocated for it to.
+	bool pin_threads;
+	bool first_touch;
+};
+
+struct RenderThreadStats
+{
+	double busy_ms;
+	double idle_ms;
+
+	uint32_t tile_count; // rendered, split pieces included
+	uint32_t steal_count;
+	uint32_t split_count;
+};
+
+struct RenderStats
+{
+	TraversalStats traversal;
+
+	uint32_t scale; // pixels per sample and axis, 1 at full resolution
+	uint32_t thread_count;
+	uint32_t tile_count;
+
+	uint32_t pass_count; // accumulated passes, including this one
+	double accumulated_ms;
+	float active_fraction; // accumulation blocks still taking samples
+
+	double render_ms;
+	// From the call to the first finished tile, the earliest any pixel of the
+	// frame reaches the target.
+	double first_pixel_ms;
+
+	// Stopped at a cancel request; the target holds a partial frame.
+	bool cancelled;
+	// Every tile was rendered; false when the budget ran out or the frame
+	// was cancelled, leaving the rest pending.
+	bool is_complete;
+
+	// Thread time per traced sample, averaged over recent frames.
+	double sample_cost_ms;
+
+	// Busy time summed over all threads relative to thread_count * render_ms.
+	float load_balance;
+	std::vector<RenderThreadStats> threads;
+};
+
+// What an unfinished frame was rendering and the tiles it left.
+struct RenderPending
+{
+	bool is_pending;
+
+	RenderView view;
+	size_t width, height;
+	const AccumulationBuffer* accumulation;
+
+	uint32_t scale;
+	bool is_refinement;
+	std::vector<RenderRect> regions;
+
+	std::vector<uint64_t> tiles;
+};
+
+// Splits frames into square tiles and deals every thread of a persistent pool
+// a contiguous share, along the selected order, in its own work-stealing
+// deque. Threads render their share front to back and, once it runs out,
+// steal from the far end of another thread's share. A thread whose deque is
+// empty splits the tile it holds into quadrants and queues three of them, so
+// the end of the frame is fine grained enough for the stragglers to be
+// shared out.
+struct Renderer
+{
+	ThreadPool pool;
+
+	WorkStealingDeque* queues;
+	uint32_t queue_count;
+	size_t queue_capacity;
+
+	uint32_t tile_size;
+	bool packet_tracing;
+	bool work_stealing;
+
+	// Tile indices of the last frame's grid in order, packets of a whole tile
+	// and pixels of a packet as packed 8-bit x and y, both in order.
+	RenderOrder order;
+	uint32_t order_tiles_x, order_tiles_y;
+	std::vector<uint32_t> tile_order;
+	std::vector<uint16_t> packet_order;
+	uint16_t pixel_order[RAY_PACKET_SIZE];
+
+	float budget_ms;
+	double sample_cost_ms; // 0 until a frame was measured
+
+	RenderPending pending;
+
+	bool pin_threads;
+	bool first_touch;
+
+	// Buffers already touched at the current frame size.
+	std::vector<const void*> touched_buffers;
+	size_t touched_width, touched_height;
+};
+
+void
+renderer_create(Renderer& self, const RenderSettings& settings);
+void
+renderer_destroy(Renderer& self);
+
+// Applies new settings, restarting the pool only when the thread count changed.
+void
+renderer_configure(Renderer& self, const RenderSettings& settings);
+
+uint32_t
+renderer_get_thread_count(const Renderer& self);
+
+// Frames that end incomplete are picked up where they stopped by the next
+// call rendering the same kind of frame of the same view and target size,
+// until this drops them, as after scene edits.
+void
+renderer_discard_pending(Renderer& self);
+
+// Renders one sample per pixel into target. With an accumulation buffer the
+// sample is jittered inside the pixel, except on the first pass, and added to
+// what was accumulated from the same view; target then gets the running mean.
+// Threads check cancel before every tile and stop once it is raised, so a
+// stale frame is given up within about one tile per thread. Samples of a
+// cancelled pass stay accumulated; every pixel keeps its own count.
+RenderStats
+renderer_render(Renderer& self, const GeometryScene& scene, const RenderView& view, const RenderTarget& target,
+	AccumulationBuffer* accumulation = nullptr, const std::atomic<bool>* cancel = nullptr);
+
+// Renders one level of a coarse-to-fine preview: a sample every scale pixels
+// in both directions, a power of two up to RENDER_PREVIEW_SCALE, shown as a
+// scale x scale block. A level that refines the one at twice its scale only
+// traces the pixels that level left out and overwrites the rest of its
+// blocks, so going through 8, 4, 2 and 1 on the same target traces every
+// pixel once. With accumulation the levels make up its first pass, which
+// level 1 completes; the buffer has to start out empty.
+RenderStats
+renderer_render_preview(Renderer& self, const GeometryScene& scene, const RenderView& view, const RenderTarget& target,
+	uint32_t scale, bool refines, AccumulationBuffer* accumulation = nullptr, const std::atomic<bool>* cancel = nullptr);
+
+// Re-renders only the given regions, which must not overlap, and leaves the
+// rest of target as it is. With accumulation, region pixels take one more
+// sample each without counting a pass; pixels reset on their own catch up
+// with the rest over repeated calls.
+RenderStats
+renderer_render_regions(Renderer& self, const GeometryScene& scene, const RenderView& view, const RenderTarget& target,
+	const RenderRect* regions, size_t region_count, AccumulationBuffer* accumulation = nullptr,
+	const std::atomic<bool>* cancel = nullptr);
+
+// Screen bounds of what primary rays can see of bounds in a width x height
+// frame, jitter included. Returns false when it is off screen; boxes reaching
+// behind the camera cover the whole frame.
+bool
+render_rect_project(const RenderView& view, const AABB& bounds, size_t width, size_t height, RenderRect& rect);
+
+// Rounds rects out to whole packets, clips them to the frame and merges
+// overlapping ones until none overlap.
+void
+render_rects_merge(std::vector<RenderRect>& rects, size_t width, size_t height);
+
+// Bytes per pixel of the target's format.
+size_t
+render_target_get_pixel_size(const RenderTarget& self);
+
+#endif
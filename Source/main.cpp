@@ -1,5 +1,7 @@
+#include <chrono>
 #include <cstring>
 #include <iostream>
+#include <thread>
 
 #include <SDL3/SDL_main.h>
 
@@ -9,12 +11,18 @@
 
 #include <Math/Ray.hpp>
 #include <Math/Vector.hpp>
+#include <Math/Geometry.hpp>
 #include <Math/Hittable.hpp>
+#include <Math/TriangleMesh.hpp>
 #include <Math/BoundingSphere.hpp>
 
+#include <Mesh/MeshCache.hpp>
+
+#include <Render/Renderer.hpp>
+#include <Render/Accumulation.hpp>
+
 struct RenderContext
 {
-	void* temp_buffer;
 	FrameBuffer* framebuffer;
 
 	Vec3f camera_center = { 0.0f, 0.0f, 0.0f };
@@ -26,20 +34,95 @@ struct RenderContext
 	Vec3f pixel_delta_u;
 	Vec3f pixel_delta_v;
 	Vec3f viewport_upper_left;
+
+	// The camera above as the render thread sees it, published under
+	// g_state.mtx along with every edit and once per UI frame.
+	RenderView view;
+
+	AccelerationType acceleration = SIMD_WIDTH >= 8 ? AccelerationType::AT_BVH8 : AccelerationType::AT_BVH4;
+
+	Renderer renderer;
+	RenderSettings render_settings = { 0, RENDER_DEFAULT_TILE_SIZE, true, true, RenderOrder::RO_SCANLINE };
+	RenderStats render_stats {};
+
+	// Passes keep accumulating while view and scene stay put, until target_spp
+	// or, when set, time_budget_s of rendering is reached.
+	AccumulationBuffer accumulation;
+	bool progressive = true;
+	int target_spp = 256;
+	float time_budget_s = 0.0f;
+
+	// Adaptive sampling leaves blocks whose error estimate fell below
+	// error_threshold alone and, with stop_when_converged, ends refinement
+	// once none is left.
+	bool adaptive = false;
+	bool stop_when_converged = true;
+	float error_threshold = 0.005f;
+
+	bool show_density = false;
+	bool is_showing_density = false;
+
+	// Input restarts the preview at RENDER_PREVIEW_SCALE; every frame after
+	// halves preview_scale, which is 0 once full resolution was reached.
+	// preview_refines is set once the first level was rendered.
+	bool preview = true;
+	uint32_t preview_scale = 0;
+	bool preview_refines = false;
+
+	// With a frame budget, frames stop taking tiles once they would run past
+	// budget_ms and the next frame picks up the rest. Previews start at the
+	// finest level that fits and progressive frames take as many passes as
+	// are predicted to fit.
+	bool use_budget = false;
+	float budget_ms = 16.0f;
+
+	// Edited from the UI and picked up by the next render through a BVH update.
+	BoundingSphere* moving_sphere;
+	Vec3f moving_sphere_center = { 0.0f, -5.0f, -100.0f };
+	bool is_scene_dirty = false;
+
+	BVHUpdateStats update_stats;
+
+	// Screen regions the edits can have changed, re-rendered on their own
+	// while the view stays put and the target holds a full frame of it. With
+	// accumulation they take region_pass_count passes to catch up.
+	std::vector<RenderRect> dirty_regions;
+	uint32_t region_pass_count = 0;
+	bool use_dirty_regions = true;
+	float region_fraction = 0.0f; // of the frame, in the last region frame
+
+	bool has_frame = false;
+	RenderView frame_view;
+	size_t frame_width = 0, frame_height = 0;
+
+	// From the input a frame answers to its first rendered tile and to its
+	// presentation, and from an input to the abort of the frame it cancelled.
+	double input_to_first_pixel_ms = 0.0;
+	double input_to_frame_ms = 0.0;
+	double cancel_ms = 0.0;
+	uint32_t cancelled_frame_count = 0;
 };
 
-Vec3f ray_color(const Ray& ray, HittableList& world)
+// Derives the viewport from the camera fields and publishes it as the view the
+// render thread picks up. Callers hold g_state.mtx, so that an edit and the
+// view it produces reach the render thread together.
+static void
+_render_context_update_view(RenderContext& self)
 {
-	HitRecord hit_record = hittable_list_hit(world, ray, 0.001f, constants_infinity<float>());
+	size_t framebuffer_width = framebuffer_get_width(self.framebuffer);
+	size_t framebuffer_height = framebuffer_get_height(self.framebuffer);
+
+	self.viewport_height = self.viewport_width / (float(framebuffer_width) / float(framebuffer_height));
+
+	Vec3f viewport_u = { self.viewport_width, 0.0f, 0.0f };
+	Vec3f viewport_v = { 0.0f, -self.viewport_height, 0.0f };
 
-	if (hit_record.hit)
-		return 0.5f * (hit_record.normal + Vec3f{ 1.0f, 1.0f, 1.0f });
+	self.pixel_delta_u = viewport_u / float(framebuffer_width);
+	self.pixel_delta_v = viewport_v / float(framebuffer_height);
 
-	// Vec3f unit_direction = unit_vector(ray.direction);
-	// auto a = 0.5*(unit_direction.y() + 1.0);
-	// return (1.0-a)*color(1.0, 1.0, 1.0) + a*color(0.5, 0.7, 1.0);
+	self.viewport_upper_left = self.camera_center - self.camera_focal_length - (viewport_u / 2.0f) - (viewport_v / 2.0f);
 
-	return Vec3f{ 0.0f, 0.0f, 0.0f };
+	self.view = { self.camera_center, self.viewport_upper_left, self.pixel_delta_u, self.pixel_delta_v };
 }
 
 int main(int argc, char *argv[])
@@ -47,75 +130,391 @@ int main(int argc, char *argv[])
 	ApplicationWindow* window = application_window_new();
 
 	HittableList world;
+	GeometryScene scene;
 	RenderContext context;
 
-	application_window_on_create(window, [&world, &context](ApplicationWindow* self) -> void {
-		context.framebuffer = application_window_get_framebuffer(self);
+	std::shared_ptr<TriangleMesh> ground_ptr = std::make_shared<TriangleMesh>();
+	std::shared_ptr<TriangleMesh> mesh_ptr;
+
+	MeshCache mesh_cache;
+	mesh_cache_create(mesh_cache);
+
+	// An OBJ or PLY file given on the command line is added to the scene as is,
+	// its BVH cached next to it for the next start-up.
+	if (argc > 1)
+	{
+		MeshCacheStats stats {};
+
+		mesh_ptr = std::make_shared<TriangleMesh>();
+		if (triangle_mesh_load_cached(*(mesh_ptr.get()), mesh_cache, argv[1], nullptr, 0, &stats))
+		{
+			if (stats.hit)
+			{
+				std::cout << "Loaded " << argv[1] << " from cache: " << triangle_mesh_get_triangle_count(*(mesh_ptr.get())) << " triangles, "
+					<< stats.hash_ms << " ms hash, " << stats.open_ms << " ms open" << std::endl;
+			}
+			else
+			{
+				std::cout << "Loaded " << argv[1] << ": " << stats.load.triangle_count << " triangles, "
+					<< double(stats.load.bytes) / (1 << 20) / (stats.load.parse_ms / 1000.0) << " MB/s parse, "
+					<< stats.load.build_ms << " ms build, " << stats.write_ms << " ms cache write" << std::endl;
+			}
+		}
+		else
+		{
+			std::cerr << "Failed to load " << argv[1] << std::endl;
+			mesh_ptr.reset();
+		}
+	}
 
-		size_t framebuffer_bps = framebuffer_get_bps(context.framebuffer);
-		size_t framebuffer_width = framebuffer_get_width(context.framebuffer);
-		size_t framebuffer_height = framebuffer_get_height(context.framebuffer);
+	geometry_scene_create(scene);
+	renderer_create(context.renderer, context.render_settings);
+	accumulation_buffer_create(context.accumulation);
 
-		context.temp_buffer = malloc(framebuffer_width * framebuffer_height * framebuffer_bps);
+	application_window_on_create(window, [&world, &scene, &context, &ground_ptr, &mesh_ptr](ApplicationWindow* self) -> void {
+		context.framebuffer = application_window_get_framebuffer(self);
 
 		std::shared_ptr<BoundingSphere> sphere1_ptr((BoundingSphere*)malloc(sizeof(BoundingSphere)));
 		std::shared_ptr<BoundingSphere> sphere2_ptr((BoundingSphere*)malloc(sizeof(BoundingSphere)));
 
 		bound_sphere_create(*(sphere1_ptr.get()), 20.0f, {10.0f, 0.0f, -150.0f});
-		bound_sphere_create(*(sphere2_ptr.get()), 10.0f, {0.0f, -5.0f, -100.0f});
+		bound_sphere_create(*(sphere2_ptr.get()), 10.0f, context.moving_sphere_center);
+
+		context.moving_sphere = sphere2_ptr.get();
 
 		hittable_list_add(world, sphere1_ptr);
 		hittable_list_add(world, sphere2_ptr);
 
+		const Vec3f ground_positions[] = {
+			{ -200.0f, -25.0f, 0.0f }, { 200.0f, -25.0f, 0.0f },
+			{ 200.0f, -25.0f, -400.0f }, { -200.0f, -25.0f, -400.0f },
+		};
+		const uint32_t ground_indices[] = { 0, 1, 2, 0, 2, 3 };
+
+		triangle_mesh_create(*(ground_ptr.get()), ground_positions, 4, ground_indices, 6);
+		hittable_list_add(world, ground_ptr);
+
+		if (mesh_ptr)
+			hittable_list_add(world, mesh_ptr);
+
+		geometry_scene_build(scene, world);
+
 		g_state.is_dirty = true;
 	});
 
 	application_window_on_update(window, [&world, &context](ApplicationWindow* self) -> void {
-		size_t framebuffer_width = framebuffer_get_width(context.framebuffer);
-		size_t framebuffer_height = framebuffer_get_height(context.framebuffer);
+		std::lock_guard<std::mutex> lock(g_state.mtx);
+		_render_context_update_view(context);
+	});
+
+	application_window_on_render(window, [&world, &scene, &context](ApplicationWindow* self) -> void {
+		// Edited by the UI thread while frames render; every frame works from
+		// what was set when it started.
+		RenderView view;
+		RenderSettings render_settings;
+		AccelerationType acceleration;
+		bool progressive, preview, adaptive, stop_when_converged, show_density;
+		int target_spp;
+		float time_budget_s, error_threshold;
+		bool use_budget, use_dirty_regions;
+		float budget_ms;
+		bool is_scene_dirty;
+		Vec3f moving_sphere_center;
+		{
+			std::lock_guard<std::mutex> lock(g_state.mtx);
+			view = context.view;
 
-		context.viewport_height = context.viewport_width / (float(framebuffer_width) / float(framebuffer_height));
+			render_settings = context.render_settings;
+			acceleration = context.acceleration;
 
-		Vec3f viewport_u = { context.viewport_width, 0.0f, 0.0f };
-		Vec3f viewport_v = { 0.0f, -context.viewport_height, 0.0f };
+			progressive = context.progressive;
+			preview = context.preview;
+			target_spp = context.target_spp;
+			time_budget_s = context.time_budget_s;
 
-		context.pixel_delta_u = viewport_u / float(framebuffer_width);
-		context.pixel_delta_v = viewport_v / float(framebuffer_height);
+			adaptive = context.adaptive;
+			stop_when_converged = context.stop_when_converged;
+			error_threshold = context.error_threshold;
+			show_density = context.show_density;
 
-		context.viewport_upper_left = context.camera_center - context.camera_focal_length - (viewport_u / 2.0f) - (viewport_v / 2.0f);
-	});
+			use_budget = context.use_budget;
+			budget_ms = context.budget_ms;
+			use_dirty_regions = context.use_dirty_regions;
 
-	application_window_on_render(window, [&world, &context](ApplicationWindow* self) -> void {
-		size_t framebuffer_width = framebuffer_get_width(context.framebuffer);
-		size_t framebuffer_height = framebuffer_get_height(context.framebuffer);
+			is_scene_dirty = context.is_scene_dirty;
+			moving_sphere_center = context.moving_sphere_center;
+			context.is_scene_dirty = false;
+		}
+
+		// Drawn in place; the worker presents it by swapping buffers.
+		FrameBufferView back_buffer = framebuffer_get_back_buffer(context.framebuffer);
+
+		size_t framebuffer_width = back_buffer.width;
+		size_t framebuffer_height = back_buffer.height;
+		RenderFormat format = back_buffer.format == FrameBufferFormat::FMT_RGBA32 ? RenderFormat::RF_RGBA32 : RenderFormat::RF_RGB24;
+		RenderTarget target = { back_buffer.pixels, framebuffer_width, framebuffer_height, back_buffer.pitch, format,
+			framebuffer_get_finished_tiles(context.framebuffer) };
+
+		AccumulationBuffer& accumulation = context.accumulation;
+
+		bool has_frame = context.has_frame && use_dirty_regions &&
+			framebuffer_width == context.frame_width && framebuffer_height == context.frame_height &&
+			memcmp(&view, &context.frame_view, sizeof(RenderView)) == 0;
 
-		for (int y = 0; y < framebuffer_height; y++)
+		if (!has_frame)
+			context.dirty_regions.clear();
+
+		// Unfinished frames were of the old view or scene.
+		if (g_state.frame_has_input || is_scene_dirty)
+			renderer_discard_pending(context.renderer);
+
+		BVHUpdateStats update_stats {};
+		if (is_scene_dirty)
 		{
-			for (int x = 0; x < framebuffer_width; x++)
+			BoundingSphere& sphere = *context.moving_sphere;
+			Vec3f extent = { sphere.radius, sphere.radius, sphere.radius };
+
+			// Primary rays can only see a difference where they saw the
+			// sphere before or see it now.
+			AABB bounds[2];
+			bounds[0] = { sphere.center - extent, sphere.center + extent };
+			sphere.center = moving_sphere_center;
+			bounds[1] = { sphere.center - extent, sphere.center + extent };
+
+			update_stats = geometry_scene_update(scene, world);
+
+			if (has_frame)
 			{
-				Vec3f pixel_center = context.viewport_upper_left +
-					(float(x) * context.pixel_delta_u) +
-					(float(y) * context.pixel_delta_v);
+				for (const AABB& box : bounds)
+				{
+					RenderRect region;
+					if (render_rect_project(view, box, framebuffer_width, framebuffer_height, region))
+						context.dirty_regions.push_back(region);
+				}
+
+				render_rects_merge(context.dirty_regions, framebuffer_width, framebuffer_height);
+
+				// Regions still catching up start over together with the
+				// new ones.
+				for (const RenderRect& region : context.dirty_regions)
+					accumulation_buffer_reset_region(accumulation, region);
+
+				context.region_pass_count = 0;
+			}
+			else
+				accumulation_buffer_reset(accumulation);
+		}
+
+		geometry_scene_set_acceleration(scene, acceleration);
 
-				Vec3f direction = pixel_center - context.camera_center;
+		render_settings.budget_ms = use_budget ? budget_ms : 0.0f;
+		renderer_configure(context.renderer, render_settings);
 
-				Ray ray { context.camera_center, vector_normalize(direction) };
+		// Milliseconds a pass over pixel_count pixels is expected to take,
+		// 0 before anything was measured.
+		auto predict_ms = [&context](double pixel_count) -> double {
+			return pixel_count * context.renderer.sample_cost_ms / double(renderer_get_thread_count(context.renderer));
+		};
 
-				auto pixel_color = ray_color(ray, world);
+		bool is_region_frame = !context.dirty_regions.empty();
+
+		auto is_converged = [&accumulation, target_spp, time_budget_s, adaptive, stop_when_converged]() -> bool {
+			return accumulation.pass_count >= uint32_t(target_spp) ||
+				(time_budget_s > 0.0f && accumulation.elapsed_ms >= time_budget_s * 1000.0) ||
+				(adaptive && stop_when_converged && accumulation.pass_count >= ACCUMULATION_MIN_ADAPTIVE_PASSES &&
+					!accumulation.active_block_count);
+		};
+
+		bool is_refining = false;
+		bool is_previewing = false;
+		bool has_rendered = true;
+
+		auto render_start = std::chrono::steady_clock::now();
+
+		if (progressive)
+		{
+			accumulation_buffer_prepare(accumulation, framebuffer_width, framebuffer_height, view);
+			accumulation_buffer_set_error_threshold(accumulation, adaptive ? error_threshold : 0.0f);
+		}
+		else if (accumulation.pass_count)
+			accumulation_buffer_reset(accumulation);
+
+		// Once a pass is accumulated there is nothing left to preview. Before
+		// that the buffer only holds preview levels, which are cheap to redo.
+		if (g_state.frame_has_input && !is_region_frame)
+		{
+			bool has_pass = progressive && accumulation.pass_count;
+			context.preview_scale = preview && !has_pass ? RENDER_PREVIEW_SCALE : 0;
+			context.preview_refines = false;
+
+			// Coarser levels than needed to fit the budget are skipped.
+			double pixel_count = double(framebuffer_width * framebuffer_height);
+			while (use_budget && context.renderer.sample_cost_ms > 0.0 && context.preview_scale > 1 &&
+				predict_ms(pixel_count / (context.preview_scale * context.preview_scale / 4)) <= budget_ms)
+				context.preview_scale /= 2;
+
+			if (progressive && !has_pass)
+				accumulation_buffer_reset(accumulation);
+		}
+		else if (!preview)
+			context.preview_scale = 0;
 
-				int index = (x + (y * framebuffer_width)) * 3;
+		float region_fraction = 0.0f;
+		for (const RenderRect& region : context.dirty_regions)
+			region_fraction += float(region.width * region.height) / float(framebuffer_width * framebuffer_height);
 
-				auto buffer = (uint8_t*)context.temp_buffer;
-				buffer[index + 0] = (uint8_t)(pixel_color.r * 255.0f);
-				buffer[index + 1] = (uint8_t)(pixel_color.g * 255.0f);
-				buffer[index + 2] = (uint8_t)(pixel_color.b * 255.0f);
+		// Frames that only draw over part of the last one need it in the back
+		// buffer, which otherwise still holds the frame before. Budgeted frames
+		// may stop anywhere. Rendered tiles mark themselves drawn.
+		bool is_redrawn = !is_region_frame && !use_budget && !context.renderer.pending.is_pending &&
+			(context.preview_scale ? !context.preview_refines : !progressive || !adaptive || is_converged());
+
+		if (!is_redrawn)
+			framebuffer_sync_back_buffer(context.framebuffer);
+
+		RenderStats render_stats {};
+		if (is_region_frame)
+		{
+			render_stats = renderer_render_regions(context.renderer, scene, view, target, context.dirty_regions.data(),
+				context.dirty_regions.size(), progressive ? &accumulation : nullptr, &g_state.is_cancelled);
+
+			if (render_stats.is_complete && (!progressive || ++context.region_pass_count >= accumulation.pass_count))
+				context.dirty_regions.clear();
+
+			is_refining = !context.dirty_regions.empty() || (progressive && !is_converged());
+		}
+		else if (context.preview_scale)
+		{
+			render_stats = renderer_render_preview(context.renderer, scene, view, target, context.preview_scale,
+				context.preview_refines, progressive ? &accumulation : nullptr, &g_state.is_cancelled);
+
+			if (render_stats.is_complete)
+			{
+				context.preview_scale /= 2;
+				context.preview_refines = true;
 			}
+
+			// The coarsest level covers the whole target.
+			is_previewing = true;
+			context.is_showing_density = false;
+
+			is_refining = context.preview_scale || (progressive && !is_converged());
+		}
+		else if (progressive)
+		{
+			// Converged images are only resolved again, for inputs that do not
+			// change the picture, such as the thread count.
+			if (!is_converged())
+			{
+				render_stats = renderer_render(context.renderer, scene, view, target, &accumulation, &g_state.is_cancelled);
+
+				// Further passes only while they are predicted to fit in what
+				// is left of the budget.
+				while (use_budget && render_stats.is_complete && !is_converged())
+				{
+					double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - render_start).count();
+					double pixel_count = double(framebuffer_width * framebuffer_height) * render_stats.active_fraction;
+
+					if (elapsed_ms + predict_ms(pixel_count) > budget_ms)
+						break;
+
+					render_stats = renderer_render(context.renderer, scene, view, target, &accumulation, &g_state.is_cancelled);
+				}
+			}
+			else
+			{
+				accumulation_buffer_resolve(accumulation, target);
+				framebuffer_mark_drawn(context.framebuffer, 0, 0, framebuffer_width, framebuffer_height);
+				has_rendered = false;
+			}
+
+			is_refining = !is_converged();
+		}
+		else
+		{
+			render_stats = renderer_render(context.renderer, scene, view, target, nullptr, &g_state.is_cancelled);
+
+			is_refining = !render_stats.is_complete;
+		}
+
+		auto render_end = std::chrono::steady_clock::now();
+
+		bool is_cancelled = render_stats.cancelled;
+
+		// Coarse preview levels and partly drawn frames leave nothing to
+		// re-render regions of. Unfinished region frames only touched pixels
+		// inside regions that are still pending.
+		if (!is_region_frame)
+			context.has_frame = (!has_rendered || render_stats.is_complete) && !(is_previewing && render_stats.scale > 1);
+		context.frame_view = view;
+		context.frame_width = framebuffer_width;
+		context.frame_height = framebuffer_height;
+
+		// Skipped blocks keep what the target held, so leaving the density
+		// view takes one full resolve.
+		if (progressive && !is_previewing && !is_cancelled)
+		{
+			if (show_density)
+				accumulation_buffer_resolve_density(accumulation, target);
+			else if (context.is_showing_density)
+				accumulation_buffer_resolve(accumulation, target);
+
+			if (show_density || context.is_showing_density)
+				framebuffer_mark_drawn(context.framebuffer, 0, 0, framebuffer_width, framebuffer_height);
+
+			context.is_showing_density = show_density;
+		}
+
+		// The UI thread reads these while the next frame renders.
+		{
+			std::lock_guard<std::mutex> lock(g_state.mtx);
+
+			if (is_cancelled)
+			{
+				context.cancel_ms = std::chrono::duration<double, std::milli>(render_end - g_state.input_time).count();
+				context.cancelled_frame_count++;
+			}
+			else if (g_state.frame_has_input)
+			{
+				double input_ms = std::chrono::duration<double, std::milli>(render_start - g_state.frame_input_time).count();
+
+				context.input_to_first_pixel_ms = input_ms + (has_rendered ? render_stats.first_pixel_ms : 0.0);
+				context.input_to_frame_ms = std::chrono::duration<double, std::milli>(render_end - g_state.frame_input_time).count();
+			}
+
+			if (is_region_frame)
+				context.region_fraction = region_fraction;
+
+			if (is_scene_dirty)
+				context.update_stats = update_stats;
+
+			if (has_rendered)
+				context.render_stats = std::move(render_stats);
+
+			g_state.is_refining = is_refining;
 		}
 
-		framebuffer_update(context.framebuffer, context.temp_buffer);
 	});
 
 	application_window_on_ui_render(window, [&context](ApplicationWindow* self) -> void {
+		// Published by the render thread after every frame.
+		RenderStats render_stats;
+		double input_to_first_pixel_ms, input_to_frame_ms, cancel_ms;
+		uint32_t cancelled_frame_count;
+		float region_fraction;
+		BVHUpdateStats update_stats;
+		{
+			std::lock_guard<std::mutex> lock(g_state.mtx);
+			render_stats = context.render_stats;
+			region_fraction = context.region_fraction;
+			update_stats = context.update_stats;
+
+			input_to_first_pixel_ms = context.input_to_first_pixel_ms;
+			input_to_frame_ms = context.input_to_frame_ms;
+			cancel_ms = context.cancel_ms;
+			cancelled_frame_count = context.cancelled_frame_count;
+		}
+
 		ImGui::Begin("Camera/Viewport Settings");
 
 			// Camera Focal Point
@@ -127,7 +526,8 @@ int main(int argc, char *argv[])
 				{
 					{
 						std::lock_guard<std::mutex> lock(g_state.mtx);
-						g_state.is_dirty = true;
+						_render_context_update_view(context);
+						application_state_mark_dirty(g_state);
 					}
 
 					g_state.cv.notify_one();
@@ -146,7 +546,8 @@ int main(int argc, char *argv[])
 				{
 					{
 						std::lock_guard<std::mutex> lock(g_state.mtx);
-						g_state.is_dirty = true;
+						_render_context_update_view(context);
+						application_state_mark_dirty(g_state);
 					}
 
 					g_state.cv.notify_one();
@@ -165,7 +566,8 @@ int main(int argc, char *argv[])
 				{
 					{
 						std::lock_guard<std::mutex> lock(g_state.mtx);
-						g_state.is_dirty = true;
+						_render_context_update_view(context);
+						application_state_mark_dirty(g_state);
 					}
 
 					g_state.cv.notify_one();
@@ -196,19 +598,313 @@ int main(int argc, char *argv[])
 				ImGui::EndDisabled();
 			}
 
+			ImGui::Separator();
+			ImGui::Spacing();
+
+			// Scene Edit
+			{
+				ImGui::Text("Sphere Center");
+
+				Vec3f center = context.moving_sphere_center;
+
+				ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+				if (ImGui::SliderFloat3("##SphereCenter", center.data, -200.0f, 200.0f, "%.3f"))
+				{
+					{
+						std::lock_guard<std::mutex> lock(g_state.mtx);
+
+						context.moving_sphere_center = center;
+						context.is_scene_dirty = true;
+						application_state_mark_dirty(g_state);
+					}
+
+					g_state.cv.notify_one();
+				}
+
+				bool use_dirty_regions = context.use_dirty_regions;
+				if (ImGui::Checkbox("Re-render Dirty Regions Only", &use_dirty_regions))
+				{
+					{
+						std::lock_guard<std::mutex> lock(g_state.mtx);
+
+						context.use_dirty_regions = use_dirty_regions;
+						application_state_mark_dirty(g_state);
+					}
+
+					g_state.cv.notify_one();
+				}
+
+				if (use_dirty_regions)
+					ImGui::Text("Last edit re-rendered %.1f%% of the frame", region_fraction * 100.0f);
+
+				const char* update_names[] = { "None", "Refit", "Partial Rebuild", "Full Rebuild" };
+				const BVHUpdateStats& stats = update_stats;
+
+				ImGui::Text("%s: %.2f ms refit, %.2f ms rebuild", update_names[int(stats.type)], stats.refit_ms, stats.rebuild_ms);
+				ImGui::Text("SAH cost %.2fx after refit, %.2fx after update", stats.refit_cost_ratio, stats.cost_ratio);
+			}
+
+			ImGui::Separator();
+			ImGui::Spacing();
+
+			// Acceleration Structure
+			{
+				ImGui::Text("Acceleration Structure");
+
+				const char* acceleration_names[] = { "BVH2", "BVH4", "BVH8" };
+
+				int acceleration = int(context.acceleration);
+
+				ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+				if (ImGui::Combo("##Acceleration", &acceleration, acceleration_names, IM_ARRAYSIZE(acceleration_names)))
+				{
+					{
+						std::lock_guard<std::mutex> lock(g_state.mtx);
+
+						context.acceleration = AccelerationType(acceleration);
+						application_state_mark_dirty(g_state);
+					}
+
+					g_state.cv.notify_one();
+				}
+
+				bool packet_tracing = context.render_settings.packet_tracing;
+				if (ImGui::Checkbox("Packet Tracing (8x8)", &packet_tracing))
+				{
+					{
+						std::lock_guard<std::mutex> lock(g_state.mtx);
+
+						context.render_settings.packet_tracing = packet_tracing;
+						application_state_mark_dirty(g_state);
+					}
+
+					g_state.cv.notify_one();
+				}
+
+				const TraversalStats& stats = render_stats.traversal;
+				double rays = stats.rays ? double(stats.rays) : 1.0;
+				double render_ms = render_stats.render_ms;
+
+				ImGui::Text("%.2f Mrays/s (%.1f ms)",
+					render_ms > 0.0 ? double(stats.rays) / (render_ms * 1000.0) : 0.0, render_ms);
+				ImGui::Text("%.1f nodes/ray, %.1f leaves/ray",
+					double(stats.nodes_visited) / rays, double(stats.leaves_visited) / rays);
+
+				bool use_budget = context.use_budget;
+				float budget_ms = context.budget_ms;
+
+				bool is_budget_changed = ImGui::Checkbox("Frame Time Budget", &use_budget);
+
+				ImGui::BeginDisabled(!use_budget);
+					ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+					is_budget_changed |= ImGui::SliderFloat("##FrameBudget", &budget_ms, 1.0f, 100.0f, "%.1f ms");
+				ImGui::EndDisabled();
+
+				if (is_budget_changed)
+				{
+					{
+						std::lock_guard<std::mutex> lock(g_state.mtx);
+
+						context.use_budget = use_budget;
+						context.budget_ms = budget_ms;
+						application_state_mark_dirty(g_state);
+					}
+
+					g_state.cv.notify_one();
+				}
+
+				if (use_budget)
+					ImGui::Text("%.1f ns/sample, frame %s", render_stats.sample_cost_ms * 1e6,
+						render_stats.is_complete ? "complete" : "carried over");
+
+				ImGui::Text("Input Latency");
+				ImGui::Text("%.1f ms to first pixel, %.1f ms to frame", input_to_first_pixel_ms, input_to_frame_ms);
+				ImGui::Text("%u frames cancelled, last after %.1f ms", cancelled_frame_count, cancel_ms);
+			}
+
+			ImGui::Separator();
+			ImGui::Spacing();
+
+			// Progressive Refinement
+			{
+				ImGui::Text("Progressive Refinement");
+
+				bool progressive = context.progressive;
+				bool preview = context.preview;
+				int target_spp = context.target_spp;
+				float time_budget_s = context.time_budget_s;
+
+				bool adaptive = context.adaptive;
+				bool stop_when_converged = context.stop_when_converged;
+				float error_threshold = context.error_threshold;
+				bool show_density = context.show_density;
+
+				bool changed = ImGui::Checkbox("Accumulate Samples", &progressive);
+				changed |= ImGui::Checkbox("Coarse-to-Fine Preview", &preview);
+
+				ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+				changed |= ImGui::SliderInt("##TargetSpp", &target_spp, 1, 4096, "%d spp", ImGuiSliderFlags_Logarithmic);
+
+				ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+				changed |= ImGui::SliderFloat("##TimeBudget", &time_budget_s, 0.0f, 60.0f, time_budget_s > 0.0f ? "%.1f s budget" : "no time budget");
+
+				changed |= ImGui::Checkbox("Adaptive Sampling", &adaptive);
+
+				ImGui::BeginDisabled(!adaptive);
+					ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+					changed |= ImGui::SliderFloat("##ErrorThreshold", &error_threshold, 0.0005f, 0.05f, "%.4f max error", ImGuiSliderFlags_Logarithmic);
+
+					changed |= ImGui::Checkbox("Stop When Converged", &stop_when_converged);
+				ImGui::EndDisabled();
+
+				changed |= ImGui::Checkbox("Show Sample Density", &show_density);
+
+				if (changed)
+				{
+					{
+						std::lock_guard<std::mutex> lock(g_state.mtx);
+
+						context.progressive = progressive;
+						context.preview = preview;
+						context.adaptive = adaptive;
+						context.stop_when_converged = stop_when_converged;
+						context.error_threshold = error_threshold;
+						context.show_density = show_density;
+						context.target_spp = target_spp;
+						context.time_budget_s = time_budget_s;
+						application_state_mark_dirty(g_state);
+					}
+
+					g_state.cv.notify_one();
+				}
+
+				if (render_stats.scale > 1)
+					ImGui::Text("Preview at 1/%u resolution", render_stats.scale);
+				else if (progressive)
+					ImGui::Text("%u spp in %.2f s", render_stats.pass_count, render_stats.accumulated_ms / 1000.0);
+
+				if (progressive && adaptive)
+					ImGui::Text("%.1f%% of blocks still sampled", render_stats.active_fraction * 100.0f);
+			}
+
+			ImGui::Separator();
+			ImGui::Spacing();
+
+			// Threading
+			{
+				ImGui::Text("Render Threads");
+
+				// The pool belongs to the render thread; before the first
+				// frame it is about to start every hardware thread.
+				int max_thread_count = int(std::max(1u, std::thread::hardware_concurrency()));
+				int thread_count = int(context.render_settings.thread_count ? context.render_settings.thread_count :
+					render_stats.thread_count ? render_stats.thread_count : uint32_t(max_thread_count));
+
+				ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+				if (ImGui::SliderInt("##ThreadCount", &thread_count, 1, max_thread_count))
+				{
+					{
+						std::lock_guard<std::mutex> lock(g_state.mtx);
+
+						context.render_settings.thread_count = uint32_t(thread_count);
+						application_state_mark_dirty(g_state);
+					}
+
+					g_state.cv.notify_one();
+				}
+
+				ImGui::Text("Tile Size");
+
+				const char* tile_size_names[] = { "8", "16", "32", "64", "128" };
+				const uint32_t tile_sizes[] = { 8, 16, 32, 64, 128 };
+
+				int tile_size = 0;
+				while (tile_size + 1 < IM_ARRAYSIZE(tile_sizes) && tile_sizes[tile_size] < context.render_settings.tile_size)
+					tile_size++;
+
+				ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+				if (ImGui::Combo("##TileSize", &tile_size, tile_size_names, IM_ARRAYSIZE(tile_size_names)))
+				{
+					{
+						std::lock_guard<std::mutex> lock(g_state.mtx);
+
+						context.render_settings.tile_size = tile_sizes[tile_size];
+						application_state_mark_dirty(g_state);
+					}
+
+					g_state.cv.notify_one();
+				}
+
+				ImGui::Text("Traversal Order");
+
+				const char* order_names[] = { "Scanline", "Morton", "Hilbert" };
+
+				int order = int(context.render_settings.order);
+
+				ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+				if (ImGui::Combo("##TraversalOrder", &order, order_names, IM_ARRAYSIZE(order_names)))
+				{
+					{
+						std::lock_guard<std::mutex> lock(g_state.mtx);
+
+						context.render_settings.order = RenderOrder(order);
+						application_state_mark_dirty(g_state);
+					}
+
+					g_state.cv.notify_one();
+				}
+
+				bool pin_threads = context.render_settings.pin_threads;
+				bool first_touch = context.render_settings.first_touch;
+
+				bool is_placement_changed = ImGui::Checkbox("Pin Threads", &pin_threads);
+				is_placement_changed |= ImGui::Checkbox("NUMA First Touch", &first_touch);
+
+				if (is_placement_changed)
+				{
+					{
+						std::lock_guard<std::mutex> lock(g_state.mtx);
+
+						context.render_settings.pin_threads = pin_threads;
+						context.render_settings.first_touch = first_touch;
+						application_state_mark_dirty(g_state);
+					}
+
+					g_state.cv.notify_one();
+				}
+
+				bool work_stealing = context.render_settings.work_stealing;
+				if (ImGui::Checkbox("Work Stealing", &work_stealing))
+				{
+					{
+						std::lock_guard<std::mutex> lock(g_state.mtx);
+
+						context.render_settings.work_stealing = work_stealing;
+						application_state_mark_dirty(g_state);
+					}
+
+					g_state.cv.notify_one();
+				}
+
+				ImGui::Text("%u threads, %u tiles, %.1f%% load balance", render_stats.thread_count, render_stats.tile_count,
+					render_stats.load_balance * 100.0f);
+
+				for (size_t i = 0; i < render_stats.threads.size(); i++)
+				{
+					const RenderThreadStats& thread = render_stats.threads[i];
+
+					char label[64];
+					snprintf(label, sizeof(label), "%.1f ms busy, %u steals", thread.busy_ms, thread.steal_count);
+
+					ImGui::ProgressBar(render_stats.render_ms > 0.0 ? float(thread.busy_ms / render_stats.render_ms) : 0.0f, ImVec2(-1.0f, 0.0f), label);
+				}
+			}
+
 		ImGui::End();
 	});
 
 	application_window_on_resize(window, [&context](ApplicationWindow* self, size_t width, size_t height) -> void {
-		free(context.temp_buffer);
-
 		context.framebuffer = application_window_get_framebuffer(self);
-
-		size_t framebuffer_bps = framebuffer_get_bps(context.framebuffer);
-		size_t framebuffer_width = framebuffer_get_width(context.framebuffer);
-		size_t framebuffer_height = framebuffer_get_height(context.framebuffer);
-
-		context.temp_buffer = malloc(framebuffer_width * framebuffer_height * framebuffer_bps);
 	});
 
 	application_window_create(window, "minimalistic-raytracer");
@@ -219,5 +915,14 @@ int main(int argc, char *argv[])
 	application_window_shutdown_imgui(window);
 	application_window_destroy(window);
 
+	accumulation_buffer_destroy(context.accumulation);
+	renderer_destroy(context.renderer);
+	geometry_scene_destroy(scene);
+	triangle_mesh_destroy(*(ground_ptr.get()));
+	if (mesh_ptr)
+		triangle_mesh_destroy(*(mesh_ptr.get()));
+
+	mesh_cache_close(mesh_cache);
+
 	return 0;
 }
\ No newline at end of file